@@ -0,0 +1,251 @@
+/*
+ * mini-alloc.c
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mini-alloc.h"
+
+
+/**
+ *  Allocates memory with the C library.
+ */
+static void *
+mini_alloc_libc_malloc (size_t size, void *user_data)
+{
+    return malloc (size);
+}
+
+/**
+ *  Resizes memory with the C library.
+ */
+static void *
+mini_alloc_libc_realloc (void *ptr, size_t size, void *user_data)
+{
+    return realloc (ptr, size);
+}
+
+/**
+ *  Frees memory with the C library.
+ */
+static void
+mini_alloc_libc_free (void *ptr, void *user_data)
+{
+    free (ptr);
+}
+
+static const MiniAllocator mini_alloc_libc = {
+    mini_alloc_libc_malloc,
+    mini_alloc_libc_realloc,
+    mini_alloc_libc_free,
+    NULL
+};
+
+/* Counter of the allocations of the running thread, or NULL */
+static _Thread_local MiniAllocCount *mini_alloc_counter;
+
+/* Allocator of everything not owned by a MiniFile */
+static MiniAllocator mini_alloc_global = {
+    mini_alloc_libc_malloc,
+    mini_alloc_libc_realloc,
+    mini_alloc_libc_free,
+    NULL
+};
+
+
+/**
+ *  Sets the allocator of the library, used by the new MiniFiles (unless 
+ *  they're given one) and by everything else. It must be set before the 
+ *  library is used: the memory allocated before isn't released with it.
+ *
+ *  @param allocator A MiniAllocator structure, which is copied, or NULL 
+ *         to use the C library.
+ */
+void
+mini_set_allocator (const MiniAllocator *allocator)
+{
+    if (allocator == NULL)
+        allocator = &mini_alloc_libc;
+
+    /* All the functions are needed */
+    assert (allocator->malloc != NULL);
+    assert (allocator->realloc != NULL);
+    assert (allocator->free != NULL);
+
+    mini_alloc_global = *allocator;
+}
+
+/**
+ *  Gets the allocator of the library.
+ *
+ *  @return The return value is the allocator set by mini_set_allocator().
+ */
+const MiniAllocator *
+mini_get_allocator (void)
+{
+    return &mini_alloc_global;
+}
+
+/**
+ *  Allocates memory.
+ *
+ *  @param allocator A MiniAllocator structure, or NULL for the allocator 
+ *         of the library.
+ *  @param size Number of bytes.
+ *  @return The return value is the allocated memory.
+ *          The function returns NULL, if the memory can't be allocated.
+ */
+void *
+mini_malloc (const MiniAllocator *allocator, size_t size)
+{
+    if (allocator == NULL)
+        allocator = &mini_alloc_global;
+
+    if (mini_alloc_counter != NULL) {
+        mini_alloc_counter->allocations++;
+        mini_alloc_counter->bytes += size;
+    }
+
+    return allocator->malloc (size, allocator->user_data);
+}
+
+/**
+ *  Allocates zeroed memory for an array.
+ *
+ *  @param allocator A MiniAllocator structure, or NULL for the allocator 
+ *         of the library.
+ *  @param nmemb Number of elements.
+ *  @param size Size of an element.
+ *  @return The return value is the allocated memory.
+ *          The function returns NULL, if the memory can't be allocated.
+ */
+void *
+mini_calloc (const MiniAllocator *allocator, size_t nmemb, size_t size)
+{
+    void *ptr;
+
+    /* Overflow */
+    if ((size != 0) && (nmemb > SIZE_MAX / size))
+        return NULL;
+
+    ptr = mini_malloc (allocator, nmemb * size);
+    if (ptr != NULL)
+        memset (ptr, 0, nmemb * size);
+
+    return ptr;
+}
+
+/**
+ *  Resizes memory allocated by the same allocator.
+ *
+ *  @param allocator A MiniAllocator structure, or NULL for the allocator 
+ *         of the library.
+ *  @param ptr Allocated memory, or NULL.
+ *  @param size New number of bytes.
+ *  @return The return value is the resized memory.
+ *          The function returns NULL, if the memory can't be resized 
+ *          (then ptr is untouched).
+ */
+void *
+mini_realloc (const MiniAllocator *allocator, void *ptr, size_t size)
+{
+    if (allocator == NULL)
+        allocator = &mini_alloc_global;
+
+    if (mini_alloc_counter != NULL) {
+        mini_alloc_counter->allocations++;
+        mini_alloc_counter->bytes += size;
+    }
+
+    return allocator->realloc (ptr, size, allocator->user_data);
+}
+
+/**
+ *  Frees memory allocated by the same allocator.
+ *
+ *  @param allocator A MiniAllocator structure, or NULL for the allocator 
+ *         of the library.
+ *  @param ptr Allocated memory, or NULL.
+ */
+void
+mini_free (const MiniAllocator *allocator, void *ptr)
+{
+    /* Do nothing with NULL pointers */
+    if (ptr == NULL)
+        return;
+
+    if (allocator == NULL)
+        allocator = &mini_alloc_global;
+
+    allocator->free (ptr, allocator->user_data);
+}
+
+/**
+ *  Duplicates a string.
+ *
+ *  @param allocator A MiniAllocator structure, or NULL for the allocator 
+ *         of the library.
+ *  @param string A string.
+ *  @return The return value is the copy of the string.
+ *          The function returns NULL, if the copy can't be allocated.
+ */
+char *
+mini_strdup (const MiniAllocator *allocator, const char *string)
+{
+    size_t len;
+    char *copy;
+
+    /* String can't be NULL */
+    assert (string != NULL);
+
+    len = strlen (string);
+    copy = (char *) mini_malloc (allocator, len + 1);
+    if (copy != NULL)
+        memcpy (copy, string, len + 1);
+
+    return copy;
+}
+
+/**
+ *  Counts the allocations and reallocations made by the calling thread, 
+ *  with any allocator, and the bytes they request, until another counter 
+ *  is set. The memory freed meanwhile isn't subtracted.
+ *
+ *  @param count A MiniAllocCount structure receiving the counts, or NULL 
+ *         to stop counting.
+ *  @return The return value is the previous counter of the thread, to be 
+ *          set again when done.
+ */
+MiniAllocCount *
+mini_alloc_count (MiniAllocCount *count)
+{
+    MiniAllocCount *previous = mini_alloc_counter;
+
+    mini_alloc_counter = count;
+
+    return previous;
+}
@@ -0,0 +1,76 @@
+/*
+ * mini-alloc.h
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MINI_ALLOC_H__
+#define __MINI_ALLOC_H__
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* 
+ * Allocator used by the library. Memory is always released by the 
+ * allocator which allocated it, so every MiniFile (through its arena) 
+ * keeps a copy of its allocator.
+ */
+typedef struct _MiniAllocator MiniAllocator;
+struct _MiniAllocator {
+    void *(*malloc) (size_t size, void *user_data);
+    void *(*realloc) (void *ptr, size_t size, void *user_data);
+    void (*free) (void *ptr, void *user_data);
+    void *user_data;
+};
+
+/* Allocations made by a thread while counting, see mini_alloc_count() */
+typedef struct _MiniAllocCount MiniAllocCount;
+struct _MiniAllocCount {
+    unsigned int allocations;
+    size_t bytes;
+};
+
+
+void mini_set_allocator (const MiniAllocator *allocator);
+
+const MiniAllocator *mini_get_allocator (void);
+
+void *mini_malloc (const MiniAllocator *allocator, size_t size);
+
+void *mini_calloc (const MiniAllocator *allocator, size_t nmemb, size_t size);
+
+void *mini_realloc (const MiniAllocator *allocator, void *ptr, size_t size);
+
+void mini_free (const MiniAllocator *allocator, void *ptr);
+
+char *mini_strdup (const MiniAllocator *allocator, const char *string);
+
+MiniAllocCount *mini_alloc_count (MiniAllocCount *count);
+
+#endif /* __MINI_ALLOC_H__ */
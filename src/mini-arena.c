@@ -0,0 +1,301 @@
+/*
+ * mini-arena.c
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mini-arena.h"
+
+/* Chunk header size, rounded up so that chunk data is aligned */
+#define CHUNK_HEADER_SIZE \
+    ((sizeof (MiniArenaChunk) + MINI_ARENA_ALIGN - 1) & ~(MINI_ARENA_ALIGN - 1))
+
+
+/**
+ *  Allocates a new chunk able to hold, at least, the given number of bytes 
+ *  and links it into the arena.
+ *
+ *  @param arena A MiniArena structure.
+ *  @param size Number of bytes that must fit in the new chunk.
+ *  @return The return value is the new chunk.
+ *          The function returns NULL, if the chunk can't be allocated.
+ */
+static MiniArenaChunk *
+mini_arena_chunk_new (MiniArena *arena, size_t size)
+{
+    MiniArenaChunk *chunk;
+    size_t chunk_size;
+
+    /* Oversized requests get a chunk of their own */
+    chunk_size = (size > arena->chunk_size / 4) ? size : arena->chunk_size;
+
+    chunk = (MiniArenaChunk *) mini_malloc (&arena->allocator, 
+                                            CHUNK_HEADER_SIZE + chunk_size);
+    if (chunk == NULL)
+        return NULL;
+
+    chunk->size = chunk_size;
+    chunk->used = 0;
+
+    if ((chunk_size != arena->chunk_size) && (arena->chunk != NULL)) {
+        /* Keep filling the current chunk */
+        chunk->next = arena->chunk->next;
+        arena->chunk->next = chunk;
+    } else {
+        chunk->next = arena->chunk;
+        arena->chunk = chunk;
+
+        /* Every new regular chunk is bigger than the previous one */
+        if (arena->chunk_size < MINI_ARENA_MAX_CHUNK_SIZE)
+            arena->chunk_size *= 2;
+    }
+
+    arena->num_chunks++;
+    arena->bytes += CHUNK_HEADER_SIZE + chunk_size;
+
+    return chunk;
+}
+
+
+/**
+ *  Creates a new arena. An arena hands out memory from a few big chunks, 
+ *  all of them released at once by mini_arena_free().
+ *
+ *  @param allocator Allocator of the chunks, which is copied, or NULL for 
+ *         the allocator of the library.
+ *  @return The return value is the new MiniArena structure.
+ *          The function returns NULL, if the arena can't be created.
+ */
+MiniArena *
+mini_arena_new (const MiniAllocator *allocator)
+{
+    MiniArena *arena;
+
+    if (allocator == NULL)
+        allocator = mini_get_allocator ();
+
+    arena = (MiniArena *) mini_malloc (allocator, sizeof (MiniArena));
+    if (arena == NULL)
+        return NULL;
+
+    arena->allocator = *allocator;
+
+    arena->chunk = NULL;
+    arena->chunk_size = MINI_ARENA_CHUNK_SIZE;
+    arena->num_chunks = 0;
+    arena->bytes = 0;
+
+    return arena;
+}
+
+/**
+ *  Frees an arena and all the memory allocated from it.
+ *
+ *  @param arena A MiniArena structure.
+ */
+void
+mini_arena_free (MiniArena *arena)
+{
+    MiniAllocator allocator;
+    MiniArenaChunk *p;
+
+    /* Do nothing with NULL pointers */
+    if (arena == NULL)
+        return;
+
+    /* The arena holds its own allocator */
+    allocator = arena->allocator;
+
+    while (arena->chunk != NULL) {
+        p = arena->chunk;
+        arena->chunk = p->next;
+        mini_free (&allocator, p);
+    }
+
+    mini_free (&allocator, arena);
+}
+
+/**
+ *  Allocates memory from an arena. The memory is aligned to 
+ *  MINI_ARENA_ALIGN bytes and it can't be freed on its own.
+ *
+ *  @param arena A MiniArena structure.
+ *  @param size Number of bytes to be allocated.
+ *  @return The return value is the allocated memory.
+ *          The function returns NULL, if the memory can't be allocated.
+ */
+void *
+mini_arena_alloc (MiniArena *arena, size_t size)
+{
+    MiniArenaChunk *chunk;
+    void *p;
+
+    /* Arena can't be NULL */
+    assert (arena != NULL);
+
+    size = (size + MINI_ARENA_ALIGN - 1) & ~((size_t) MINI_ARENA_ALIGN - 1);
+
+    chunk = arena->chunk;
+    if ((chunk == NULL) || (chunk->size - chunk->used < size)) {
+        chunk = mini_arena_chunk_new (arena, size);
+        if (chunk == NULL)
+            return NULL;
+    }
+
+    p = (char *) chunk + CHUNK_HEADER_SIZE + chunk->used;
+    chunk->used += size;
+
+    return p;
+}
+
+/**
+ *  Allocates zeroed memory from an arena.
+ *
+ *  @param arena A MiniArena structure.
+ *  @param size Number of bytes to be allocated.
+ *  @return The return value is the allocated memory.
+ *          The function returns NULL, if the memory can't be allocated.
+ */
+void *
+mini_arena_calloc (MiniArena *arena, size_t size)
+{
+    void *p;
+
+    p = mini_arena_alloc (arena, size);
+    if (p != NULL)
+        memset (p, 0, size);
+
+    return p;
+}
+
+/**
+ *  Copies the first bytes of a string into an arena.
+ *
+ *  @param arena A MiniArena structure.
+ *  @param string String to be copied.
+ *  @param len Number of bytes to be copied.
+ *  @return The return value is the NUL terminated copy.
+ *          The function returns NULL, if the memory can't be allocated.
+ */
+char *
+mini_arena_strndup (MiniArena *arena, const char *string, size_t len)
+{
+    char *p;
+
+    /* String can't be NULL */
+    assert (string != NULL);
+
+    p = (char *) mini_arena_alloc (arena, len + 1);
+    if (p == NULL)
+        return NULL;
+
+    memcpy (p, string, len);
+    p[len] = '\0';
+
+    return p;
+}
+
+/**
+ *  Copies a string into an arena.
+ *
+ *  @param arena A MiniArena structure.
+ *  @param string String to be copied.
+ *  @return The return value is the copy.
+ *          The function returns NULL, if the memory can't be allocated.
+ */
+char *
+mini_arena_strdup (MiniArena *arena, const char *string)
+{
+    /* String can't be NULL */
+    assert (string != NULL);
+
+    return mini_arena_strndup (arena, string, strlen (string));
+}
+
+/**
+ *  Moves all the memory of an arena into another one, which releases it 
+ *  from then on. The moved arena is freed, but the memory allocated from 
+ *  it is still valid. Both arenas must have the same allocator.
+ *
+ *  @param arena A MiniArena structure receiving the memory.
+ *  @param other A MiniArena structure to be merged into the first one.
+ */
+void
+mini_arena_merge (MiniArena *arena, MiniArena *other)
+{
+    MiniArenaChunk *last;
+
+    /* Arena can't be NULL */
+    assert (arena != NULL);
+
+    /* Do nothing with NULL pointers */
+    if (other == NULL)
+        return;
+
+    if (other->chunk != NULL) {
+        for (last = other->chunk; last->next != NULL; last = last->next)
+            ;
+
+        /* Keep filling the current chunk */
+        if (arena->chunk != NULL) {
+            last->next = arena->chunk->next;
+            arena->chunk->next = other->chunk;
+        } else
+            arena->chunk = other->chunk;
+    }
+
+    arena->num_chunks += other->num_chunks;
+    arena->bytes += other->bytes;
+
+    mini_free (&arena->allocator, other);
+}
+
+/**
+ *  Checks whether a pointer points into the memory handed out by an arena.
+ *
+ *  @param arena A MiniArena structure.
+ *  @param ptr A pointer.
+ *  @return The function returns non-zero if the pointer was allocated 
+ *          from the arena.
+ */
+int
+mini_arena_contains (const MiniArena *arena, const void *ptr)
+{
+    const MiniArenaChunk *chunk;
+    uintptr_t p = (uintptr_t) ptr, start;
+
+    /* Arena can't be NULL */
+    assert (arena != NULL);
+
+    for (chunk = arena->chunk; chunk != NULL; chunk = chunk->next) {
+        start = (uintptr_t) chunk + CHUNK_HEADER_SIZE;
+        if ((p >= start) && (p < start + chunk->used))
+            return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+/*
+ * mini-arena.h
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MINI_ARENA_H__
+#define __MINI_ARENA_H__
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mini-alloc.h"
+
+#define MINI_ARENA_CHUNK_SIZE (64 * 1024)
+#define MINI_ARENA_MAX_CHUNK_SIZE (4 * 1024 * 1024)
+#define MINI_ARENA_ALIGN 8
+
+typedef struct _MiniArenaChunk MiniArenaChunk;
+struct _MiniArenaChunk {
+    MiniArenaChunk *next;
+    size_t size;
+    size_t used;
+};
+
+typedef struct _MiniArena MiniArena;
+struct _MiniArena {
+    MiniArenaChunk *chunk;
+    size_t chunk_size;
+    unsigned int num_chunks;
+    size_t bytes;
+    /* Allocator of the chunks and of the arena itself */
+    MiniAllocator allocator;
+};
+
+
+MiniArena *mini_arena_new (const MiniAllocator *allocator);
+
+void mini_arena_free (MiniArena *arena);
+
+void *mini_arena_alloc (MiniArena *arena, size_t size);
+
+void *mini_arena_calloc (MiniArena *arena, size_t size);
+
+char *mini_arena_strndup (MiniArena *arena, const char *string, size_t len);
+
+char *mini_arena_strdup (MiniArena *arena, const char *string);
+
+void mini_arena_merge (MiniArena *arena, MiniArena *other);
+
+int mini_arena_contains (const MiniArena *arena, const void *ptr);
+
+#endif /* __MINI_ARENA_H__ */
@@ -0,0 +1,749 @@
+/*
+ * mini-bench.c
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mini-parser.h"
+
+#define DEFAULT_SECTIONS 1000
+#define DEFAULT_KEYS 20
+#define DEFAULT_VALUE_SIZE 16
+#define DEFAULT_COMMENT_PERCENT 10
+#define DEFAULT_COMMENT_SIZE 40
+#define DEFAULT_ITERATIONS 5
+#define DEFAULT_LOOKUPS 100000
+#define DEFAULT_BATCH_SIZE 256
+#define TIMER_SAMPLES 1001
+
+typedef struct _BenchOptions BenchOptions;
+struct _BenchOptions {
+    /* Generated INI file */
+    unsigned long sections;
+    unsigned long keys;             /* per section */
+    unsigned long value_size;
+    unsigned long comment_percent;  /* lines followed by a comment line */
+    unsigned long comment_size;
+    unsigned long padding;          /* spaces around names and values */
+    unsigned long seed;
+    /* Benchmark */
+    const char *mode;
+    unsigned long iterations;
+    unsigned long lookups;          /* of every kind, hits and misses */
+    unsigned long batch_size;       /* queries per mini_file_get_values() */
+    const char *input;              /* existing INI file, or NULL */
+    const char *output;             /* kept generated INI file, or NULL */
+};
+
+typedef struct _BenchLatency BenchLatency;
+struct _BenchLatency {
+    unsigned long count;
+    unsigned long found;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t p999;
+    uint64_t max;
+};
+
+/* Allocations of the library, counted by bench_allocator */
+static atomic_ulong bench_allocations;
+static atomic_ulong bench_allocated_bytes;
+
+static void *
+bench_malloc (size_t size, void *user_data)
+{
+    atomic_fetch_add (&bench_allocations, 1);
+    atomic_fetch_add (&bench_allocated_bytes, size);
+
+    return malloc (size);
+}
+
+static void *
+bench_realloc (void *ptr, size_t size, void *user_data)
+{
+    atomic_fetch_add (&bench_allocations, 1);
+    atomic_fetch_add (&bench_allocated_bytes, size);
+
+    return realloc (ptr, size);
+}
+
+static void
+bench_free (void *ptr, void *user_data)
+{
+    free (ptr);
+}
+
+/* Counts every allocation of the library, the parse threads' ones too */
+static const MiniAllocator bench_allocator = {
+    bench_malloc,
+    bench_realloc,
+    bench_free,
+    NULL
+};
+
+
+/**
+ *  Prints the program's usage.
+ */
+static void
+print_usage (const char *program_name)
+{
+    printf ("usage: %s [OPTION]...\n"
+            "Generates an INI file, and prints how fast it's parsed, "
+            "searched and freed as JSON.\n\n"
+            "  -s SECTIONS   number of sections (%d)\n"
+            "  -k KEYS       number of keys per section (%d)\n"
+            "  -v SIZE       size of the values (%d)\n"
+            "  -c PERCENT    lines followed by a comment line (%d)\n"
+            "  -l SIZE       size of the comment lines (%d)\n"
+            "  -w SPACES     spaces around names and values (0)\n"
+            "  -r SEED       seed of the generated values (1)\n"
+            "  -o FILE       keep the generated INI file in FILE\n"
+            "  -f FILE       use an existing INI file instead\n"
+            "  -m MODE       parse with mini_parse_file (file), "
+            "mini_parse_mmap (mmap)\n"
+            "                or mini_parse_file_parallel (parallel)\n"
+            "  -i ITERATIONS number of parses (%d)\n"
+            "  -n LOOKUPS    number of hits and of misses (%d)\n"
+            "  -b SIZE       queries per mini_file_get_values call (%d)\n",
+            program_name, DEFAULT_SECTIONS, DEFAULT_KEYS, DEFAULT_VALUE_SIZE,
+            DEFAULT_COMMENT_PERCENT, DEFAULT_COMMENT_SIZE, DEFAULT_ITERATIONS,
+            DEFAULT_LOOKUPS, DEFAULT_BATCH_SIZE);
+    exit (0);
+}
+
+/**
+ *  Gets the current time, in nanoseconds.
+ */
+static uint64_t
+get_time (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ *  Writes a comment line after a generated line, sometimes.
+ */
+static void
+bench_comment (FILE *file, const BenchOptions *options, const char *comment)
+{
+    if ((unsigned long) rand () % 100 < options->comment_percent)
+        fprintf (file, "%s\n", comment);
+}
+
+/**
+ *  Writes a synthetic INI file: sections named "sectionN" with keys named 
+ *  "keyN", and random values.
+ *
+ *  @return The function returns a negative number, if the file can't be 
+ *          written.
+ */
+static int
+bench_generate (FILE *file, const BenchOptions *options)
+{
+    unsigned long s, k, i;
+    char *value, *comment, *pad;
+    int ret = -1;
+
+    value = (char *) malloc (options->value_size + 1);
+    comment = (char *) malloc (options->comment_size + 2);
+    pad = (char *) malloc (options->padding + 1);
+    if ((value == NULL) || (comment == NULL) || (pad == NULL))
+        goto out;
+
+    comment[0] = ';';
+    memset (&comment[1], '-', options->comment_size);
+    comment[(options->comment_size > 0) ? options->comment_size : 1] = '\0';
+    memset (pad, ' ', options->padding);
+    pad[options->padding] = '\0';
+    value[options->value_size] = '\0';
+
+    srand (options->seed);
+    for (s = 0; s < options->sections; s++) {
+        fprintf (file, "%s[section%lu]%s\n", pad, s, pad);
+        bench_comment (file, options, comment);
+
+        for (k = 0; k < options->keys; k++) {
+            for (i = 0; i < options->value_size; i++)
+                value[i] = 'a' + rand () % 26;
+
+            fprintf (file, "%skey%lu%s=%s%s%s\n", pad, k, pad, pad, value, 
+                     pad);
+            bench_comment (file, options, comment);
+        }
+    }
+
+    if (ferror (file) == 0)
+        ret = 0;
+
+out:
+    free (value);
+    free (comment);
+    free (pad);
+
+    return ret;
+}
+
+/**
+ *  Counts the bytes and the lines of a file.
+ *
+ *  @return The function returns a negative number, if the file can't be 
+ *          read.
+ */
+static int
+bench_measure (const char *file_name, uint64_t *bytes, uint64_t *lines)
+{
+    char buffer[65536];
+    size_t n, i;
+    FILE *file;
+
+    file = fopen (file_name, "r");
+    if (file == NULL)
+        return -1;
+
+    *bytes = 0;
+    *lines = 0;
+    while ((n = fread (buffer, 1, sizeof (buffer), file)) > 0) {
+        *bytes += n;
+        for (i = 0; i < n; i++)
+            if (buffer[i] == '\n')
+                (*lines)++;
+    }
+
+    fclose (file);
+
+    return 0;
+}
+
+/**
+ *  Parses a file with the given mode.
+ */
+static MiniFile *
+bench_parse (const char *mode, const char *file_name)
+{
+    if (strcmp (mode, "mmap") == 0)
+        return mini_parse_mmap (file_name);
+
+    if (strcmp (mode, "parallel") == 0)
+        return mini_parse_file_parallel (file_name, 0);
+
+    return mini_parse_file (file_name);
+}
+
+/**
+ *  Compares two samples, for qsort().
+ */
+static int
+bench_compare (const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ *  Gets the median cost of reading the clock, included in every latency.
+ */
+static uint64_t
+bench_timer_overhead (void)
+{
+    uint64_t samples[TIMER_SAMPLES], start;
+    unsigned int i;
+
+    for (i = 0; i < TIMER_SAMPLES; i++) {
+        start = get_time ();
+        samples[i] = get_time () - start;
+    }
+
+    qsort (samples, TIMER_SAMPLES, sizeof (uint64_t), bench_compare);
+
+    return samples[TIMER_SAMPLES / 2];
+}
+
+/**
+ *  Times every lookup of the given section and key names with 
+ *  mini_file_get_value(), and gets the percentiles of their latencies.
+ */
+static void
+bench_lookup (MiniFile *mini_file, char **sections, char **keys, 
+              unsigned long n, uint64_t *samples, BenchLatency *latency)
+{
+    unsigned long i;
+    uint64_t start;
+    char *value;
+
+    latency->count = n;
+    latency->found = 0;
+    for (i = 0; i < n; i++) {
+        start = get_time ();
+        value = mini_file_get_value (mini_file, sections[i], keys[i]);
+        samples[i] = get_time () - start;
+
+        if (value != NULL)
+            latency->found++;
+    }
+
+    qsort (samples, n, sizeof (uint64_t), bench_compare);
+
+    latency->p50 = samples[(n - 1) * 50 / 100];
+    latency->p90 = samples[(n - 1) * 90 / 100];
+    latency->p99 = samples[(n - 1) * 99 / 100];
+    latency->p999 = samples[(n - 1) * 999 / 1000];
+    latency->max = samples[n - 1];
+}
+
+/**
+ *  Times the same hits with a mini_file_get_value() call per key and with 
+ *  mini_file_get_values() batches.
+ *
+ *  @return The function returns a negative number, if the queries can't 
+ *          be allocated.
+ */
+static int
+bench_batch (MiniFile *mini_file, char **sections, char **keys, 
+             unsigned long n, unsigned long batch_size, uint64_t *single, 
+             uint64_t *batch)
+{
+    MiniQuery *queries;
+    const char **values;
+    unsigned long i, size;
+    uint64_t start;
+
+    queries = (MiniQuery *) malloc (n * sizeof (MiniQuery));
+    values = (const char **) malloc (n * sizeof (char *));
+    if ((queries == NULL) || (values == NULL)) {
+        free (queries);
+        free (values);
+        return -1;
+    }
+
+    for (i = 0; i < n; i++) {
+        queries[i].section = sections[i];
+        queries[i].key = keys[i];
+    }
+
+    start = get_time ();
+    for (i = 0; i < n; i++)
+        values[i] = mini_file_get_value (mini_file, sections[i], keys[i]);
+    *single = get_time () - start;
+
+    start = get_time ();
+    for (i = 0; i < n; i += size) {
+        size = (n - i < batch_size) ? n - i : batch_size;
+        mini_file_get_values (mini_file, &queries[i], size, &values[i]);
+    }
+    *batch = get_time () - start;
+
+    free (queries);
+    free (values);
+
+    return 0;
+}
+
+/**
+ *  Gets the keys found by a lookup, in file order.
+ *
+ *  @return The return value is the number of keys.
+ */
+static unsigned long
+bench_collect (MiniFile *mini_file, Section **sections, SectionData **keys)
+{
+    Section *sec;
+    SectionData *data;
+    unsigned long n = 0;
+
+    for (sec = mini_file_section_iter (mini_file, NULL); sec != NULL; 
+         sec = mini_file_section_iter (mini_file, sec)) {
+        if (mini_file_find_section (mini_file, sec->name, 
+                                    sec->name_len) != sec)
+            continue;
+
+        for (data = mini_section_key_iter (sec, NULL); data != NULL; 
+             data = mini_section_key_iter (sec, data)) {
+            if (mini_file_find_key (sec, data->key, data->key_len) != data)
+                continue;
+
+            sections[n] = sec;
+            keys[n] = data;
+            n++;
+        }
+    }
+
+    return n;
+}
+
+/**
+ *  Builds the section and key names of the lookups: random existing keys, 
+ *  then as many missing keys, half of them in missing sections.
+ *
+ *  @return The function returns a negative number, if the names can't be 
+ *          allocated.
+ */
+static int
+bench_names (MiniFile *mini_file, unsigned long lookups, char **sections, 
+             char **keys)
+{
+    Section **found_sections;
+    SectionData **found_keys;
+    unsigned long num_found, total = 0, i, j;
+    char missing[64];
+    Section *sec;
+    int ret = -1;
+
+    for (sec = mini_file_section_iter (mini_file, NULL); sec != NULL; 
+         sec = mini_file_section_iter (mini_file, sec))
+        total += sec->num_keys;
+
+    found_sections = (Section **) malloc ((total + 1) * sizeof (Section *));
+    found_keys = (SectionData **) malloc ((total + 1) * 
+                                          sizeof (SectionData *));
+    if ((found_sections == NULL) || (found_keys == NULL))
+        goto out;
+
+    num_found = bench_collect (mini_file, found_sections, found_keys);
+    if (num_found == 0)
+        goto out;
+
+    for (i = 0; i < 2 * lookups; i++) {
+        j = (unsigned long) rand () % num_found;
+        sections[i] = strndup (found_sections[j]->name, 
+                               found_sections[j]->name_len);
+        if (i < lookups)
+            keys[i] = strndup (found_keys[j]->key, found_keys[j]->key_len);
+        else {
+            snprintf (missing, sizeof (missing), "mini-bench-missing-%lu", i);
+            keys[i] = strdup (missing);
+            if ((i % 2 == 1) && (sections[i] != NULL)) {
+                free (sections[i]);
+                sections[i] = strdup (missing);
+            }
+        }
+
+        if ((sections[i] == NULL) || (keys[i] == NULL))
+            goto out;
+    }
+
+    ret = 0;
+
+out:
+    free (found_sections);
+    free (found_keys);
+
+    return ret;
+}
+
+/**
+ *  Prints a JSON string.
+ */
+static void
+print_json_string (const char *string)
+{
+    const unsigned char *p;
+
+    putchar ('"');
+    for (p = (const unsigned char *) string; *p != '\0'; p++) {
+        if ((*p == '"') || (*p == '\\'))
+            printf ("\\%c", *p);
+        else if (*p < 0x20)
+            printf ("\\u%04x", *p);
+        else
+            putchar (*p);
+    }
+    putchar ('"');
+}
+
+/**
+ *  Prints the latencies of a kind of lookups as a JSON object.
+ */
+static void
+print_json_latency (const char *name, const BenchLatency *latency, int last)
+{
+    printf ("    \"%s\": {\"count\": %lu, \"found\": %lu, \"p50_ns\": %llu, "
+            "\"p90_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, "
+            "\"max_ns\": %llu}%s\n", name, latency->count, latency->found, 
+            (unsigned long long) latency->p50, 
+            (unsigned long long) latency->p90, 
+            (unsigned long long) latency->p99, 
+            (unsigned long long) latency->p999, 
+            (unsigned long long) latency->max, last ? "" : ",");
+}
+
+/**
+ *  Gets an option's number, or exits.
+ */
+static unsigned long
+get_number (const char *program_name, const char *arg)
+{
+    unsigned long number;
+    char *end;
+
+    number = strtoul (arg, &end, 10);
+    if ((*arg == '\0') || (*end != '\0')) {
+        fprintf (stderr, "%s: Invalid number '%s'!\n", program_name, arg);
+        exit (1);
+    }
+
+    return number;
+}
+
+
+/**
+ *  Benchmarks the parse, the lookups and the free of a MiniFile, and 
+ *  prints the results as JSON so they can be compared between releases.
+ */
+int
+main (int argc, char *argv[])
+{
+    BenchOptions options;
+    BenchLatency hits, misses;
+    MiniFile *mini_file = NULL;
+    struct rusage usage;
+    char temporary[] = "/tmp/mini-bench-XXXXXX";
+    const char *file_name;
+    char **sections = NULL, **keys = NULL;
+    uint64_t *samples = NULL;
+    uint64_t bytes, lines, start, elapsed, parse_min = UINT64_MAX;
+    uint64_t parse_total = 0, free_total = 0, timer;
+    uint64_t single_total = 0, batch_total = 0;
+    unsigned long allocations = 0, allocated_bytes = 0, i;
+    unsigned int num_sections = 0, num_keys = 0;
+    Section *sec;
+    FILE *file;
+    int opt, fd, ret = -1;
+
+    options.sections = DEFAULT_SECTIONS;
+    options.keys = DEFAULT_KEYS;
+    options.value_size = DEFAULT_VALUE_SIZE;
+    options.comment_percent = DEFAULT_COMMENT_PERCENT;
+    options.comment_size = DEFAULT_COMMENT_SIZE;
+    options.padding = 0;
+    options.seed = 1;
+    options.mode = "file";
+    options.iterations = DEFAULT_ITERATIONS;
+    options.lookups = DEFAULT_LOOKUPS;
+    options.batch_size = DEFAULT_BATCH_SIZE;
+    options.input = NULL;
+    options.output = NULL;
+
+    while ((opt = getopt (argc, argv, "s:k:v:c:l:w:r:o:f:m:i:n:b:h")) != -1) {
+        switch (opt) {
+            case 's': options.sections = get_number (argv[0], optarg); break;
+            case 'k': options.keys = get_number (argv[0], optarg); break;
+            case 'v': options.value_size = get_number (argv[0], optarg); break;
+            case 'c': 
+                options.comment_percent = get_number (argv[0], optarg); 
+                break;
+            case 'l': 
+                options.comment_size = get_number (argv[0], optarg); 
+                break;
+            case 'w': options.padding = get_number (argv[0], optarg); break;
+            case 'r': options.seed = get_number (argv[0], optarg); break;
+            case 'o': options.output = optarg; break;
+            case 'f': options.input = optarg; break;
+            case 'm': options.mode = optarg; break;
+            case 'i': options.iterations = get_number (argv[0], optarg); break;
+            case 'n': options.lookups = get_number (argv[0], optarg); break;
+            case 'b': 
+                options.batch_size = get_number (argv[0], optarg); 
+                break;
+            default: print_usage (argv[0]);
+        }
+    }
+
+    if ((optind != argc) || (options.iterations == 0) || 
+        (options.batch_size == 0) ||
+        ((strcmp (options.mode, "file") != 0) && 
+         (strcmp (options.mode, "mmap") != 0) &&
+         (strcmp (options.mode, "parallel") != 0)))
+        print_usage (argv[0]);
+
+    mini_set_allocator (&bench_allocator);
+
+    /* Generate the INI file, unless one is given */
+    file_name = options.input;
+    if (file_name == NULL) {
+        if (options.output != NULL) {
+            file_name = options.output;
+            file = fopen (file_name, "w");
+        } else {
+            file_name = temporary;
+            fd = mkstemp (temporary);
+            file = (fd >= 0) ? fdopen (fd, "w") : NULL;
+        }
+
+        if ((file == NULL) || (bench_generate (file, &options) < 0) || 
+            (fclose (file) != 0)) {
+            fprintf (stderr, "%s: Can't write '%s' INI file!\n", argv[0], 
+                     file_name);
+            goto out;
+        }
+    }
+
+    if (bench_measure (file_name, &bytes, &lines) < 0) {
+        fprintf (stderr, "%s: Can't read '%s' INI file!\n", argv[0], 
+                 file_name);
+        goto out;
+    }
+
+    /* Parse it, keeping the last MiniFile for the lookups */
+    for (i = 0; i < options.iterations; i++) {
+        atomic_store (&bench_allocations, 0);
+        atomic_store (&bench_allocated_bytes, 0);
+        start = get_time ();
+        mini_file = bench_parse (options.mode, file_name);
+        elapsed = get_time () - start;
+        allocations = atomic_load (&bench_allocations);
+        allocated_bytes = atomic_load (&bench_allocated_bytes);
+
+        if (mini_file == NULL) {
+            fprintf (stderr, "%s: Can't parse '%s' INI file!\n", argv[0], 
+                     file_name);
+            goto out;
+        }
+
+        parse_total += elapsed;
+        if (elapsed < parse_min)
+            parse_min = elapsed;
+
+        if (i + 1 < options.iterations) {
+            start = get_time ();
+            mini_file_free (mini_file);
+            free_total += get_time () - start;
+        }
+    }
+
+    getrusage (RUSAGE_SELF, &usage);
+
+    num_sections = mini_file_get_number_of_sections (mini_file);
+    for (sec = mini_file_section_iter (mini_file, NULL); sec != NULL; 
+         sec = mini_file_section_iter (mini_file, sec))
+        num_keys += sec->num_keys;
+
+    /* Random hits, then misses */
+    memset (&hits, 0, sizeof (BenchLatency));
+    memset (&misses, 0, sizeof (BenchLatency));
+    timer = bench_timer_overhead ();
+    if ((num_keys > 0) && (options.lookups > 0)) {
+        sections = (char **) calloc (2 * options.lookups, sizeof (char *));
+        keys = (char **) calloc (2 * options.lookups, sizeof (char *));
+        samples = (uint64_t *) malloc (options.lookups * sizeof (uint64_t));
+        if ((sections == NULL) || (keys == NULL) || (samples == NULL) ||
+            (bench_names (mini_file, options.lookups, sections, keys) < 0)) {
+            fprintf (stderr, "%s: Out of memory!\n", argv[0]);
+            goto out;
+        }
+
+        bench_lookup (mini_file, sections, keys, options.lookups, samples, 
+                      &hits);
+        bench_lookup (mini_file, &sections[options.lookups], 
+                      &keys[options.lookups], options.lookups, samples, 
+                      &misses);
+
+        if (bench_batch (mini_file, sections, keys, options.lookups, 
+                         options.batch_size, &single_total, 
+                         &batch_total) < 0) {
+            fprintf (stderr, "%s: Out of memory!\n", argv[0]);
+            goto out;
+        }
+    }
+
+    start = get_time ();
+    mini_file_free (mini_file);
+    free_total += get_time () - start;
+    mini_file = NULL;
+
+    printf ("{\n");
+    printf ("  \"file\": ");
+    print_json_string (file_name);
+    printf (",\n");
+    if (options.input == NULL)
+        printf ("  \"generator\": {\"sections\": %lu, \"keys_per_section\": "
+                "%lu, \"value_size\": %lu, \"comment_percent\": %lu, "
+                "\"comment_size\": %lu, \"padding\": %lu, \"seed\": %lu},\n",
+                options.sections, options.keys, options.value_size, 
+                options.comment_percent, options.comment_size, 
+                options.padding, options.seed);
+    printf ("  \"input\": {\"bytes\": %llu, \"lines\": %llu, "
+            "\"sections\": %u, \"keys\": %u},\n", (unsigned long long) bytes,
+            (unsigned long long) lines, num_sections, num_keys);
+    printf ("  \"parse\": {\n");
+    printf ("    \"mode\": \"%s\",\n", options.mode);
+    printf ("    \"iterations\": %lu,\n", options.iterations);
+    printf ("    \"seconds_min\": %.9f,\n", parse_min / 1e9);
+    printf ("    \"seconds_mean\": %.9f,\n", 
+            parse_total / 1e9 / options.iterations);
+    printf ("    \"mb_per_s\": %.3f,\n", bytes / 1e6 / (parse_min / 1e9));
+    printf ("    \"lines_per_s\": %.0f,\n", lines / (parse_min / 1e9));
+    printf ("    \"allocations\": %lu,\n", allocations);
+    printf ("    \"allocated_bytes\": %lu,\n", allocated_bytes);
+    printf ("    \"peak_rss_kb\": %ld\n", usage.ru_maxrss);
+    printf ("  },\n");
+    printf ("  \"lookup\": {\n");
+    printf ("    \"timer_overhead_ns\": %llu,\n", (unsigned long long) timer);
+    print_json_latency ("hit", &hits, 0);
+    print_json_latency ("miss", &misses, 0);
+    printf ("    \"batch\": {\"size\": %lu, \"single_ns_per_key\": %.1f, "
+            "\"batch_ns_per_key\": %.1f}\n", options.batch_size, 
+            options.lookups ? (double) single_total / options.lookups : 0.0, 
+            options.lookups ? (double) batch_total / options.lookups : 0.0);
+    printf ("  },\n");
+    printf ("  \"free\": {\"seconds_mean\": %.9f}\n", 
+            free_total / 1e9 / options.iterations);
+    printf ("}\n");
+
+    ret = 0;
+
+out:
+    if (mini_file != NULL)
+        mini_file_free (mini_file);
+
+    if ((sections != NULL) && (keys != NULL))
+        for (i = 0; i < 2 * options.lookups; i++) {
+            free (sections[i]);
+            free (keys[i]);
+        }
+
+    free (sections);
+    free (keys);
+    free (samples);
+
+    if ((options.input == NULL) && (options.output == NULL))
+        unlink (temporary);
+
+    return ret;
+}
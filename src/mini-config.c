@@ -0,0 +1,348 @@
+/*
+ * mini-config.c
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mini-config.h"
+
+
+/**
+ *  Checks if any reader is reading a snapshot.
+ *
+ *  @param handle A MiniConfigHandle structure.
+ *  @param mini_file A snapshot.
+ *  @return The function returns non-zero if some hazard pointer points 
+ *          to the snapshot.
+ */
+static int
+mini_config_is_read (MiniConfigHandle *handle, const MiniFile *mini_file)
+{
+    MiniConfigReader *reader;
+
+    for (reader = atomic_load (&handle->readers); reader != NULL; 
+         reader = reader->next)
+        if (atomic_load (&reader->hazard) == mini_file)
+            return 1;
+
+    return 0;
+}
+
+/**
+ *  Frees the retired snapshots that nobody reads anymore.
+ *
+ *  @param handle A MiniConfigHandle structure.
+ */
+static void
+mini_config_collect (MiniConfigHandle *handle)
+{
+    MiniConfigRetired **link, *retired;
+
+    for (link = &handle->retired; *link != NULL; ) {
+        retired = *link;
+        if (mini_config_is_read (handle, retired->mini_file)) {
+            link = &retired->next;
+            continue;
+        }
+
+        *link = retired->next;
+        mini_file_free (retired->mini_file);
+        mini_free (NULL, retired);
+    }
+}
+
+/**
+ *  Reload thread: parses the file again and publishes the new snapshot.
+ *
+ *  @param arg A MiniConfigHandle structure.
+ *  @return The return value is NULL.
+ */
+static void *
+mini_config_reload_thread (void *arg)
+{
+    MiniConfigHandle *handle = (MiniConfigHandle *) arg;
+    MiniConfigRetired *retired;
+    MiniFile *mini_file;
+
+    handle->result = -1;
+
+    mini_file = mini_parse_file_strict (handle->file_name);
+    if (mini_file == NULL)
+        return NULL;
+
+    retired = (MiniConfigRetired *) mini_malloc (NULL, 
+                                                 sizeof (MiniConfigRetired));
+    if (retired == NULL) {
+        mini_file_free (mini_file);
+        return NULL;
+    }
+
+    /* From now on, new readers only see the new snapshot */
+    retired->mini_file = atomic_exchange (&handle->current, mini_file);
+    retired->next = handle->retired;
+    handle->retired = retired;
+
+    mini_config_collect (handle);
+    handle->result = 0;
+
+    return NULL;
+}
+
+
+/**
+ *  Creates a new MiniConfigHandle structure, publishing a first snapshot 
+ *  of the given INI file.
+ *
+ *  @param file_name INI file path.
+ *  @return The return value is the new MiniConfigHandle structure.
+ *          The function returns NULL, if the given INI file can't be parsed.
+ */
+MiniConfigHandle *
+mini_config_new (const char *file_name)
+{
+    MiniConfigHandle *handle;
+    MiniFile *mini_file;
+
+    /* Filename can't be NULL */
+    assert (file_name != NULL);
+
+    handle = (MiniConfigHandle *) mini_malloc (NULL, 
+                                               sizeof (MiniConfigHandle));
+    if (handle == NULL)
+        return NULL;
+
+    handle->file_name = mini_strdup (NULL, file_name);
+    if (handle->file_name == NULL) {
+        mini_free (NULL, handle);
+        return NULL;
+    }
+
+    mini_file = mini_parse_file_strict (file_name);
+    if (mini_file == NULL) {
+        mini_free (NULL, handle->file_name);
+        mini_free (NULL, handle);
+        return NULL;
+    }
+
+    atomic_init (&handle->current, mini_file);
+    atomic_init (&handle->readers, NULL);
+    handle->retired = NULL;
+    handle->reloading = 0;
+    handle->result = 0;
+
+    return handle;
+}
+
+/**
+ *  Frees a MiniConfigHandle structure, with all its snapshots and readers.
+ *  A running reload is waited for. Nobody may be reading the handle.
+ *
+ *  @param handle A MiniConfigHandle structure.
+ */
+void
+mini_config_free (MiniConfigHandle *handle)
+{
+    MiniConfigRetired *retired;
+    MiniConfigReader *reader;
+
+    /* Do nothing with NULL pointers */
+    if (handle == NULL)
+        return;
+
+    mini_config_wait (handle);
+
+    while (handle->retired != NULL) {
+        retired = handle->retired;
+        handle->retired = retired->next;
+        mini_file_free (retired->mini_file);
+        mini_free (NULL, retired);
+    }
+
+    while ((reader = atomic_load (&handle->readers)) != NULL) {
+        atomic_store (&handle->readers, reader->next);
+        mini_free (NULL, reader);
+    }
+
+    mini_file_free (atomic_load (&handle->current));
+    mini_free (NULL, handle->file_name);
+    mini_free (NULL, handle);
+}
+
+/**
+ *  Registers a reader of a MiniConfigHandle. Every thread reading the 
+ *  handle needs a reader of its own, it can be kept as long as the 
+ *  thread lives. Released readers are reused.
+ *
+ *  @param handle A MiniConfigHandle structure.
+ *  @return The return value is the new MiniConfigReader structure.
+ *          The function returns NULL, if the reader can't be created.
+ */
+MiniConfigReader *
+mini_config_reader_new (MiniConfigHandle *handle)
+{
+    MiniConfigReader *reader, *head;
+    int unused;
+
+    /* Handle can't be NULL */
+    assert (handle != NULL);
+
+    for (reader = atomic_load (&handle->readers); reader != NULL; 
+         reader = reader->next) {
+        unused = 0;
+        if (atomic_compare_exchange_strong (&reader->in_use, &unused, 1))
+            return reader;
+    }
+
+    reader = (MiniConfigReader *) mini_malloc (NULL, 
+                                               sizeof (MiniConfigReader));
+    if (reader == NULL)
+        return NULL;
+
+    atomic_init (&reader->hazard, NULL);
+    atomic_init (&reader->in_use, 1);
+
+    /* Push it, readers are registered without locks too */
+    head = atomic_load (&handle->readers);
+    do
+        reader->next = head;
+    while (!atomic_compare_exchange_weak (&handle->readers, &head, reader));
+
+    return reader;
+}
+
+/**
+ *  Releases a reader, which mustn't be reading the handle.
+ *
+ *  @param reader A MiniConfigReader structure.
+ */
+void
+mini_config_reader_free (MiniConfigReader *reader)
+{
+    /* Do nothing with NULL pointers */
+    if (reader == NULL)
+        return;
+
+    atomic_store (&reader->hazard, NULL);
+    atomic_store (&reader->in_use, 0);
+}
+
+/**
+ *  Pins the current snapshot of a MiniConfigHandle, without locks. The 
+ *  snapshot isn't freed by a reload until mini_config_read_unlock() is 
+ *  called, and it must only be looked up (mini_file_get_value(), 
+ *  mini_file_get_int64(), mini_file_find_section()...), never modified.
+ *
+ *  @param handle A MiniConfigHandle structure.
+ *  @param reader A MiniConfigReader structure of the calling thread.
+ *  @return The return value is the current snapshot.
+ */
+MiniFile *
+mini_config_read_lock (MiniConfigHandle *handle, MiniConfigReader *reader)
+{
+    MiniFile *mini_file;
+
+    /* Handle and reader can't be NULL */
+    assert (handle != NULL);
+    assert (reader != NULL);
+
+    /* The snapshot is safe once it's still current after being pinned */
+    do {
+        mini_file = atomic_load (&handle->current);
+        atomic_store (&reader->hazard, mini_file);
+    } while (mini_file != atomic_load (&handle->current));
+
+    return mini_file;
+}
+
+/**
+ *  Unpins the snapshot pinned by mini_config_read_lock().
+ *
+ *  @param reader A MiniConfigReader structure.
+ */
+void
+mini_config_read_unlock (MiniConfigReader *reader)
+{
+    /* Reader can't be NULL */
+    assert (reader != NULL);
+
+    atomic_store_explicit (&reader->hazard, NULL, memory_order_release);
+}
+
+/**
+ *  Parses the INI file of a MiniConfigHandle again in a background thread,
+ *  swapping the new snapshot in when it's complete. Readers go on reading 
+ *  the old one meanwhile; it's freed once all of them have left it. A 
+ *  file with a wrong line keeps the old snapshot.
+ *
+ *  The thread owning the handle calls mini_config_reload(), 
+ *  mini_config_wait() and mini_config_free(), never at the same time.
+ *
+ *  @param handle A MiniConfigHandle structure.
+ *  @return The function returns a negative number, if the reload can't 
+ *          be started.
+ */
+int
+mini_config_reload (MiniConfigHandle *handle)
+{
+    /* Handle can't be NULL */
+    assert (handle != NULL);
+
+    /* One reload at a time */
+    mini_config_wait (handle);
+
+    if (pthread_create (&handle->thread, NULL, mini_config_reload_thread, 
+                        handle) != 0)
+        return -1;
+
+    handle->reloading = 1;
+
+    return 0;
+}
+
+/**
+ *  Waits for the last reload of a MiniConfigHandle to finish, and frees 
+ *  the old snapshots that nobody reads anymore.
+ *
+ *  @param handle A MiniConfigHandle structure.
+ *  @return The function returns zero if the last reload published a new 
+ *          snapshot, or a negative number if the file couldn't be parsed.
+ */
+int
+mini_config_wait (MiniConfigHandle *handle)
+{
+    /* Handle can't be NULL */
+    assert (handle != NULL);
+
+    if (handle->reloading) {
+        pthread_join (handle->thread, NULL);
+        handle->reloading = 0;
+    }
+
+    mini_config_collect (handle);
+
+    return handle->result;
+}
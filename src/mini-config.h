@@ -0,0 +1,98 @@
+/*
+ * mini-config.h
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MINI_CONFIG_H__
+#define __MINI_CONFIG_H__
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mini-file.h"
+#include "mini-parser.h"
+
+/* 
+ * Reader of a MiniConfigHandle. Its hazard pointer is the snapshot being 
+ * read, which can't be freed until the reader leaves it. Reader records 
+ * are never unlinked: released ones are reused by new readers.
+ */
+typedef struct _MiniConfigReader MiniConfigReader;
+struct _MiniConfigReader {
+    _Atomic (MiniFile *) hazard;
+    atomic_int in_use;
+    MiniConfigReader *next;
+};
+
+/* Snapshot replaced by a reload, waiting for its readers to leave */
+typedef struct _MiniConfigRetired MiniConfigRetired;
+struct _MiniConfigRetired {
+    MiniFile *mini_file;
+    MiniConfigRetired *next;
+};
+
+/* 
+ * Published snapshot of an INI file, replaced as a whole by every reload. 
+ * The snapshots are never modified, so they are read without locks. The 
+ * fields after readers belong to the thread owning the handle and to its 
+ * reload thread, which never run at the same time on them.
+ */
+typedef struct _MiniConfigHandle MiniConfigHandle;
+struct _MiniConfigHandle {
+    _Atomic (MiniFile *) current;
+    _Atomic (MiniConfigReader *) readers;
+    char *file_name;
+    MiniConfigRetired *retired;
+    pthread_t thread;
+    int reloading;
+    int result;
+};
+
+
+MiniConfigHandle *mini_config_new (const char *file_name);
+
+void mini_config_free (MiniConfigHandle *handle);
+
+MiniConfigReader *mini_config_reader_new (MiniConfigHandle *handle);
+
+void mini_config_reader_free (MiniConfigReader *reader);
+
+MiniFile *mini_config_read_lock (MiniConfigHandle *handle, 
+                                 MiniConfigReader *reader);
+
+void mini_config_read_unlock (MiniConfigReader *reader);
+
+int mini_config_reload (MiniConfigHandle *handle);
+
+int mini_config_wait (MiniConfigHandle *handle);
+
+#endif /* __MINI_CONFIG_H__ */
@@ -0,0 +1,295 @@
+/*
+ * mini-convert.c
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mini-convert.h"
+
+/* Multiplier of a unit */
+typedef struct _MiniConvertUnit MiniConvertUnit;
+struct _MiniConvertUnit {
+    const char *name;
+    uint64_t factor;
+};
+
+static const MiniConvertUnit mini_convert_duration_units[] = {
+    { "", 1000000000ULL },
+    { "ns", 1ULL },
+    { "us", 1000ULL },
+    { "ms", 1000000ULL },
+    { "s", 1000000000ULL },
+    { "m", 60000000000ULL },
+    { "h", 3600000000000ULL },
+    { "d", 86400000000000ULL },
+    { NULL, 0 }
+};
+
+static const MiniConvertUnit mini_convert_size_units[] = {
+    { "", 1ULL },
+    { "b", 1ULL },
+    { "k", 1ULL << 10 },
+    { "kib", 1ULL << 10 },
+    { "kb", 1000ULL },
+    { "m", 1ULL << 20 },
+    { "mib", 1ULL << 20 },
+    { "mb", 1000000ULL },
+    { "g", 1ULL << 30 },
+    { "gib", 1ULL << 30 },
+    { "gb", 1000000000ULL },
+    { "t", 1ULL << 40 },
+    { "tib", 1ULL << 40 },
+    { "tb", 1000000000000ULL },
+    { NULL, 0 }
+};
+
+static const char *mini_convert_true[] = { "1", "true", "yes", "on", NULL };
+static const char *mini_convert_false[] = { "0", "false", "no", "off", NULL };
+
+
+/**
+ *  Copies a value into a NUL terminated buffer, as the values borrowed 
+ *  from a buffer aren't.
+ *
+ *  @param value A value.
+ *  @param value_len Length of the value.
+ *  @param buffer Buffer of MINI_CONVERT_MAX_LEN + 1 bytes.
+ *  @return The function returns a negative number, if the value is empty 
+ *          or too long to be converted.
+ */
+static int
+mini_convert_copy (const char *value, size_t value_len, char *buffer)
+{
+    if ((value_len == 0) || (value_len > MINI_CONVERT_MAX_LEN))
+        return -1;
+
+    memcpy (buffer, value, value_len);
+    buffer[value_len] = '\0';
+
+    return 0;
+}
+
+/**
+ *  Searches a unit, case-insensitive.
+ *
+ *  @param units Units, ended by a NULL name.
+ *  @param name Name of the unit, after the number.
+ *  @return The return value is the factor of the unit.
+ *          The function returns zero, if the unit doesn't exist.
+ */
+static uint64_t
+mini_convert_get_factor (const MiniConvertUnit *units, const char *name)
+{
+    /* Unit can be separated from the number */
+    while (*name == ' ' || *name == '\t')
+        name++;
+
+    for (; units->name != NULL; units++)
+        if (strcasecmp (units->name, name) == 0)
+            return units->factor;
+
+    return 0;
+}
+
+/**
+ *  Converts a number followed by a unit into an integer, multiplying the 
+ *  number by the factor of the unit. Integers are converted exactly, 
+ *  numbers with decimals are rounded.
+ *
+ *  @param buffer A NUL terminated value.
+ *  @param units Units, ended by a NULL name.
+ *  @param max Biggest result.
+ *  @param result Pointer receiving the result.
+ *  @return The function returns a negative number, if the value isn't a 
+ *          non negative number with a known unit, or if it's too big.
+ */
+static int
+mini_convert_scaled (const char *buffer, const MiniConvertUnit *units, 
+                     uint64_t max, uint64_t *result)
+{
+    unsigned long long integer;
+    uint64_t factor;
+    double number;
+    char *end;
+
+    if ((buffer[0] == '-') || (buffer[0] == '+'))
+        return -1;
+
+    errno = 0;
+    integer = strtoull (buffer, &end, 10);
+    if ((end == buffer) || (errno != 0))
+        return -1;
+
+    /* Decimals or exponent */
+    if ((*end == '.') || (*end == 'e') || (*end == 'E')) {
+        number = strtod (buffer, &end);
+
+        factor = mini_convert_get_factor (units, end);
+        if (factor == 0)
+            return -1;
+
+        number = number * factor + 0.5;
+        if (!(number < (double) max))
+            return -1;
+
+        *result = (uint64_t) number;
+        return 0;
+    }
+
+    factor = mini_convert_get_factor (units, end);
+    if ((factor == 0) || (integer > max / factor))
+        return -1;
+
+    *result = integer * factor;
+
+    return 0;
+}
+
+/**
+ *  Searches a word of a list, case-insensitive.
+ *
+ *  @param words Words, ended by NULL.
+ *  @param buffer A NUL terminated value.
+ *  @return The function returns non-zero if the word is found.
+ */
+static int
+mini_convert_is_word (const char **words, const char *buffer)
+{
+    for (; *words != NULL; words++)
+        if (strcasecmp (*words, buffer) == 0)
+            return 1;
+
+    return 0;
+}
+
+
+/**
+ *  Converts a value into a typed value. The whole value must be converted:
+ *
+ *   - MINI_CONVERT_INT64: a decimal, hexadecimal ("0x") or octal ("0") 
+ *     integer.
+ *   - MINI_CONVERT_DOUBLE: a floating point number.
+ *   - MINI_CONVERT_BOOL: "true", "yes", "on" or "1", and "false", "no", 
+ *     "off" or "0".
+ *   - MINI_CONVERT_DURATION: a number followed by "ns", "us", "ms", "s", 
+ *     "m", "h" or "d" (seconds without unit), in nanoseconds.
+ *   - MINI_CONVERT_SIZE: a number followed by "B", "K", "M", "G", "T" or 
+ *     "KiB"... (powers of 1024) or by "KB"... (powers of 1000), in bytes.
+ *
+ *  Words and units are case-insensitive.
+ *
+ *  @param conversion Type of the conversion.
+ *  @param value A value.
+ *  @param value_len Length of the value.
+ *  @param converted Pointer receiving the converted value.
+ *  @return The function returns a negative number, if the value can't 
+ *          be converted.
+ */
+int
+mini_convert (int conversion, const char *value, size_t value_len, 
+              MiniConverted *converted)
+{
+    char buffer[MINI_CONVERT_MAX_LEN + 1], *end;
+    uint64_t result;
+
+    /* Value and converted can't be NULL */
+    assert (value != NULL);
+    assert (converted != NULL);
+
+    if (mini_convert_copy (value, value_len, buffer) < 0)
+        return -1;
+
+    switch (conversion) {
+        case MINI_CONVERT_INT64:
+            errno = 0;
+            converted->int64 = strtoll (buffer, &end, 0);
+            if ((end == buffer) || (*end != '\0') || (errno != 0))
+                return -1;
+            break;
+
+        case MINI_CONVERT_DOUBLE:
+            errno = 0;
+            converted->number = strtod (buffer, &end);
+            if ((end == buffer) || (*end != '\0') || 
+                ((errno == ERANGE) && isinf (converted->number)))
+                return -1;
+            break;
+
+        case MINI_CONVERT_BOOL:
+            if (mini_convert_is_word (mini_convert_true, buffer))
+                converted->boolean = 1;
+            else if (mini_convert_is_word (mini_convert_false, buffer))
+                converted->boolean = 0;
+            else
+                return -1;
+            break;
+
+        case MINI_CONVERT_DURATION:
+            if (mini_convert_scaled (buffer, mini_convert_duration_units, 
+                                     INT64_MAX, &result) < 0)
+                return -1;
+            converted->duration = (int64_t) result;
+            break;
+
+        case MINI_CONVERT_SIZE:
+            if (mini_convert_scaled (buffer, mini_convert_size_units, 
+                                     UINT64_MAX, &result) < 0)
+                return -1;
+            converted->size = result;
+            break;
+
+        default:
+            return -1;
+    }
+
+    return 0;
+}
+
+/**
+ *  Gets the name of the type of a conversion, for error messages.
+ *
+ *  @param conversion Type of the conversion.
+ *  @return The return value is the name.
+ */
+const char *
+mini_convert_get_name (int conversion)
+{
+    switch (conversion & ~MINI_CONVERT_FAILED) {
+        case MINI_CONVERT_INT64:
+            return "integer";
+        case MINI_CONVERT_DOUBLE:
+            return "number";
+        case MINI_CONVERT_BOOL:
+            return "boolean";
+        case MINI_CONVERT_DURATION:
+            return "duration";
+        case MINI_CONVERT_SIZE:
+            return "size";
+    }
+
+    return "value";
+}
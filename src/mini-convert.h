@@ -0,0 +1,71 @@
+/*
+ * mini-convert.h
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MINI_CONVERT_H__
+#define __MINI_CONVERT_H__
+
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/* Longest value converted to a number */
+#define MINI_CONVERT_MAX_LEN 63
+
+/* Conversions of a value, cached in SectionData */
+#define MINI_CONVERT_NONE 0
+#define MINI_CONVERT_INT64 1
+#define MINI_CONVERT_DOUBLE 2
+#define MINI_CONVERT_BOOL 3
+#define MINI_CONVERT_DURATION 4
+#define MINI_CONVERT_SIZE 5
+#define MINI_CONVERT_FAILED 0x100
+/* A thread is caching a conversion */
+#define MINI_CONVERT_PENDING 0x200
+
+typedef union _MiniConverted MiniConverted;
+union _MiniConverted {
+    int64_t int64;
+    double number;
+    int boolean;
+    int64_t duration;           /* nanoseconds */
+    uint64_t size;              /* bytes */
+};
+
+
+int mini_convert (int conversion, const char *value, size_t value_len, 
+                  MiniConverted *converted);
+
+const char *mini_convert_get_name (int conversion);
+
+#endif /* __MINI_CONVERT_H__ */
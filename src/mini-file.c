@@ -28,21 +28,50 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <stdatomic.h>
+#include <stdio.h>
+#include <sys/mman.h>
+
 #include "mini-file.h"
+#include "mini-frozen.h"
+#include "mini-include.h"
+#include "mini-lazy.h"
+#include "mini-seal.h"
+
+/* Last generation given to a MiniFile, see mini_file_touch() */
+static atomic_uint_least64_t mini_file_last_generation;
+
+/* A query of mini_file_get_values() being resolved */
+typedef struct _MiniFileBatch MiniFileBatch;
+struct _MiniFileBatch {
+    /* Section or MiniFrozenSection, NULL if it doesn't exist */
+    const void *section;
+    uint64_t hash;
+    size_t key_len;
+};
 
 
 /**
  *  Creates a new SectionData structure containing the given key and 
  *  the given value.
  *
+ *  @param arena Arena from which the SectionData structure is allocated.
+ *  @param intern Table in which copied keys are interned.
  *  @param key A key name.
+ *  @param key_len Length of the key name.
  *  @param value A value.
+ *  @param value_len Length of the value.
+ *  @param borrow If MINI_BORROW or MINI_BORROW_STABLE, the key and the 
+ *         value are referenced instead of copied (the key is interned, the 
+ *         value is copied into the arena).
  *  @return The return value is the new SectionData structure.
  *          The function returns NULL, if the SectionData structure 
  *          can't be created.
  */
 static SectionData *
-mini_file_section_data_new (const char *key, const char *value)
+mini_file_section_data_new (MiniArena *arena, MiniInternTable *intern, 
+                            const char *key, size_t key_len, const char *value,
+                            size_t value_len, int borrow)
 {
     SectionData *data;
 
@@ -50,141 +79,609 @@ mini_file_section_data_new (const char *key, const char *value)
     assert (key != NULL);
     assert (value != NULL);
 
-    data = (SectionData *) malloc (sizeof (SectionData));
+    data = (SectionData *) mini_arena_alloc (arena, sizeof (SectionData));
     if (data == NULL)
         return NULL;
 
-    data->key = strdup (key);
-    data->value = strdup (value);
-    data->next = NULL;
-
-    return data;
-}
-
-/**
- *  Frees an allocated SectionData structure.
- *
- *  @param data An allocated SectionData structure.
- */
-static void
-mini_file_section_data_free (SectionData *data)
-{
-    SectionData *p;
+    if (borrow != MINI_COPY) {
+        data->key = (char *) key;
+        data->value = (char *) value;
+        data->hash = mini_hash (key, key_len);
+    } else {
+        data->key = (char *) mini_intern (intern, key, key_len);
+        data->value = mini_arena_strndup (arena, value, value_len);
+        if ((data->key == NULL) || (data->value == NULL))
+            return NULL;
 
-    /* Do nothing with NULL pointers */
-    if (data == NULL)
-        return;
+        data->hash = mini_intern_get_hash (data->key);
+    }
 
-    while (data != NULL) {
-        p = data;
-        data = p->next;
-        p->next = NULL;
+    data->key_len = key_len;
+    data->value_len = value_len;
+    data->borrowed = (borrow == MINI_BORROW);
+    data->next = NULL;
+    data->lineno = 0;
+    data->file_name = NULL;
+    atomic_init (&data->conversion, MINI_CONVERT_NONE);
 
-        free (p->key);
-        free (p->value);
-        free (p);
-    }
+    return data;
 }
 
 /**
  *  Creates a new Section structure containing the given section.
  *
- *  @param section A section name.
+ *  @param arena Arena from which the Section structure is allocated.
+ *  @param intern Table in which copied section names are interned.
+ *  @param section_name A section name.
+ *  @param name_len Length of the section name.
+ *  @param borrow If MINI_BORROW or MINI_BORROW_STABLE, the section name 
+ *         is referenced instead of interned.
  *  @return The return value is the new Section structure.
  *          The function returns NULL, if the Section structure 
  *          can't be created.
  */
 static Section *
-mini_file_section_new (const char *section_name)
+mini_file_section_new (MiniArena *arena, MiniInternTable *intern, 
+                       const char *section_name, size_t name_len, int borrow)
 {
     Section *section;
 
     /* Section name can't be NULL */
     assert (section_name != NULL);
 
-    section = (Section *) malloc (sizeof (Section));
+    section = (Section *) mini_arena_alloc (arena, sizeof (Section));
     if (section == NULL)
         return NULL;
 
-    section->name = strdup (section_name);
+    if (borrow != MINI_COPY) {
+        section->name = (char *) section_name;
+        section->hash = mini_hash (section_name, name_len);
+    } else {
+        section->name = (char *) mini_intern (intern, section_name, name_len);
+        if (section->name == NULL)
+            return NULL;
+
+        section->hash = mini_intern_get_hash (section->name);
+    }
+
+    section->name_len = name_len;
     section->data = NULL;
+    section->last = NULL;
     section->next = NULL;
+    section->index = NULL;
+    section->index_size = 0;
+    section->index_used = 0;
+    section->num_keys = 0;
+    section->lazy = 0;
+    section->content_hash = 0;
 
     return section;
 }
 
 /**
- *  Frees an allocated Section structure.
+ *  Returns the slot of an open-addressing index in which a node with the 
+ *  given hash is stored, or in which it should be stored.
+ *
+ *  The index is a power of two sized array of pointers, probed linearly. 
+ *  The generic node is compared by hash first and by name afterwards.
  *
- *  @param data An allocated Section structure.
+ *  @param index An open-addressing index.
+ *  @param index_size Size of the index (a power of two).
+ *  @param hash Hash of the searched name.
+ *  @param name The searched name.
+ *  @param name_len Length of the searched name.
+ *  @param section Non-zero if the index stores sections, zero for keys.
+ *  @return The return value is the slot position.
  */
-static void
-mini_file_section_free (Section *section)
+static unsigned int
+mini_file_index_probe (void **index, unsigned int index_size, uint64_t hash, 
+                       const char *name, size_t name_len, int section)
 {
-    Section *p;
+    unsigned int mask = index_size - 1;
+    unsigned int pos;
 
-    /* Do nothing with NULL pointers */
-    if (section == NULL)
-        return;
+    for (pos = (unsigned int) hash & mask; index[pos] != NULL; 
+         pos = (pos + 1) & mask) {
+        /* Interned names are equal if they are the same pointer */
+        if (section) {
+            Section *sec = (Section *) index[pos];
 
-    while (section != NULL) {
-        p = section;
-        section = p->next;
-        p->next = NULL;
+            if ((sec->name_len == name_len) && ((sec->name == name) || 
+                ((sec->hash == hash) && 
+                 (memcmp (sec->name, name, name_len) == 0))))
+                break;
+        } else {
+            SectionData *data = (SectionData *) index[pos];
 
-        mini_file_section_data_free (p->data);
-        p->data = NULL;
-        free (p->name);
-        free (p);
+            if ((data->key_len == name_len) && ((data->key == name) || 
+                ((data->hash == hash) && 
+                 (memcmp (data->key, name, name_len) == 0))))
+                break;
+        }
     }
+
+    return pos;
 }
 
 /**
- *  Searches for a section in a given MiniFile.
+ *  Doubles the size of an open-addressing index (or creates it), 
+ *  reinserting all its nodes. The old index is left in the arena, growing 
+ *  geometrically it never wastes more than the final index size.
  *
- *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param arena Arena from which the index is allocated.
+ *  @param index Pointer to the index to be grown.
+ *  @param index_size Pointer to the size of the index.
+ *  @param section Non-zero if the index stores sections, zero for keys.
+ *  @return The function returns a negative number, if the index can't 
+ *          be grown.
+ */
+static int
+mini_file_index_grow (MiniArena *arena, void ***index, 
+                      unsigned int *index_size, int section)
+{
+    void **new_index;
+    unsigned int new_size, i, pos;
+
+    new_size = (*index_size == 0) ? MINI_INDEX_MIN_SIZE : *index_size * 2;
+
+    new_index = (void **) mini_arena_calloc (arena, 
+                                             new_size * sizeof (void *));
+    if (new_index == NULL)
+        return -1;
+
+    for (i = 0; i < *index_size; i++) {
+        uint64_t hash;
+
+        if ((*index)[i] == NULL)
+            continue;
+
+        if (section)
+            hash = ((Section *) (*index)[i])->hash;
+        else
+            hash = ((SectionData *) (*index)[i])->hash;
+
+        for (pos = (unsigned int) hash & (new_size - 1); new_index[pos] != NULL;
+             pos = (pos + 1) & (new_size - 1))
+            ;
+
+        new_index[pos] = (*index)[i];
+    }
+
+    *index = new_index;
+    *index_size = new_size;
+
+    return 0;
+}
+
+/**
+ *  Adds a node to an open-addressing index. A node with the same name 
+ *  is replaced, so the index always points to the last inserted one.
+ *
+ *  @param arena Arena from which the index is allocated.
+ *  @param index Pointer to the index.
+ *  @param index_size Pointer to the size of the index.
+ *  @param index_used Pointer to the number of used slots of the index.
+ *  @param node A Section or a SectionData structure.
+ *  @param hash Hash of the node name.
+ *  @param name The node name.
+ *  @param name_len Length of the node name.
+ *  @param section Non-zero if the index stores sections, zero for keys.
+ *  @return The function returns a negative number, if the node can't 
+ *          be indexed.
+ */
+static int
+mini_file_index_insert (MiniArena *arena, void ***index, 
+                        unsigned int *index_size, unsigned int *index_used, 
+                        void *node, uint64_t hash, const char *name, 
+                        size_t name_len, int section)
+{
+    unsigned int pos;
+
+    /* Keep the load factor under 1/2 */
+    if (2 * (*index_used + 1) > *index_size)
+        if (mini_file_index_grow (arena, index, index_size, section) < 0)
+            return -1;
+
+    pos = mini_file_index_probe (*index, *index_size, hash, name, name_len, 
+                                 section);
+    if ((*index)[pos] == NULL)
+        (*index_used)++;
+
+    (*index)[pos] = node;
+
+    return 0;
+}
+
+/**
+ *  Records a change of a MiniFile: the perfect hash can't hold the new 
+ *  nodes, and the MiniFile gets a new generation. Generations are unique 
+ *  in the process, so a generation never matches another MiniFile.
+ *
+ *  @param mini_file A MiniFile structure.
+ */
+static void
+mini_file_touch (MiniFile *mini_file)
+{
+    mini_file->seal = NULL;
+    mini_file->generation = atomic_fetch_add (&mini_file_last_generation, 
+                                              1) + 1;
+}
+
+/**
+ *  Links an indexed section after the last section of a MiniFile.
+ *
+ *  @param mini_file A MiniFile structure.
+ *  @param section A Section structure.
+ */
+static void
+mini_file_section_link (MiniFile *mini_file, Section *section)
+{
+    section->next = NULL;
+
+    if (mini_file->last != NULL)
+        mini_file->last->next = section;
+    else
+        mini_file->section = section;
+
+    mini_file->last = section;
+    mini_file->num_sections++;
+}
+
+/**
+ *  Gets a value from a section's key of a frozen image.
+ *
+ *  @param image A frozen image.
+ *  @param section A section name.
+ *  @param key A key name.
+ *  @return The return value is the value, inside the image.
+ *          The function returns NULL, if the given section or the given 
+ *          key doesn't exist.
+ */
+static char *
+mini_file_get_frozen_value (const MiniFrozenHeader *image, const char *section,
+                            const char *key)
+{
+    const MiniFrozenSection *sec;
+    const MiniFrozenKey *data;
+
+    sec = mini_frozen_find_section (image, section, strlen (section));
+    if (sec == NULL)
+        return NULL;
+
+    data = mini_frozen_find_key (image, sec, key, strlen (key));
+    if (data == NULL)
+        return NULL;
+
+    return (char *) image + data->value;
+}
+
+/**
+ *  Searches for a section in a MiniFile, parsing its body if it isn't 
+ *  parsed yet (see mini_file_open_lazy()).
+ *
+ *  @param mini_file A MiniFile structure, not frozen.
  *  @param section A section name.
+ *  @param section_len Length of the section name.
+ *  @param hash Hash of the section name.
  *  @return The function returns NULL, if the given section can't be found.
  */
 static Section *
-mini_file_find_section (const MiniFile *mini_file, const char *section)
+mini_file_get_section (MiniFile *mini_file, const char *section, 
+                       size_t section_len, uint64_t hash)
 {
-    Section *sec = NULL;
+    Section *sec;
 
-    /* MiniFile and section can't be NULL */
-    assert (mini_file != NULL);
-    assert (section != NULL);
+    if (mini_file->index == NULL)
+        return NULL;
 
-    /* Search the given section into the given mini file */
-    for (sec = mini_file->section; sec != NULL; sec = sec->next)
-        if (strcmp (sec->name, section) == 0)
-            break;
+    sec = mini_file->index[mini_file_index_probe ((void **) mini_file->index,
+                                                  mini_file->index_size, hash,
+                                                  section, section_len, 1)];
+
+    /* The keys before a wrong line are kept */
+    if ((sec != NULL) && (sec->lazy != 0))
+        mini_lazy_load_section (mini_file, sec);
 
     return sec;
 }
 
 /**
- *  Searches for a key in a given section of a MiniFile.
+ *  Searches for a section's key in a MiniFile, through its perfect hash 
+ *  if it's sealed.
  *
- *  @param data Section data in which the given key will be searched.
+ *  @param mini_file A MiniFile structure, not frozen.
+ *  @param section A section name.
  *  @param key A key name.
- *  @return The function returns NULL, if the given key can't be found.
+ *  @return The function returns NULL, if the given section or the given 
+ *          key doesn't exist.
  */
 static SectionData *
-mini_file_find_key (const Section *section, const char *key)
+mini_file_lookup (MiniFile *mini_file, const char *section, const char *key)
 {
-    SectionData *data = NULL;
+    Section *sec;
+    size_t section_len;
 
-    /* Data and key can't be NULL */
+    if (mini_file->seal != NULL)
+        return mini_seal_find (mini_file->seal, section, strlen (section), 
+                               key, strlen (key));
+
+    /* Search the given section */
+    section_len = strlen (section);
+    sec = mini_file_get_section (mini_file, section, section_len, 
+                                 mini_hash (section, section_len));
+    if (sec == NULL)
+        return NULL;
+
+    /* Search the given key */
+    return mini_file_find_key (sec, key, strlen (key));
+}
+
+/**
+ *  Reports a value that can't be converted.
+ *
+ *  @param mini_file A MiniFile structure.
+ *  @param section A section name.
+ *  @param key A key name.
+ *  @param data The key, or NULL if its line is unknown.
+ *  @param conversion Type of the conversion, see mini_convert().
+ */
+static void
+mini_file_conversion_error (const MiniFile *mini_file, const char *section,
+                            const char *key, const SectionData *data, 
+                            int conversion)
+{
+    const char *file_name = mini_file->file_name;
+
+    /* Included keys are reported in their own file */
+    if ((data != NULL) && (data->file_name != NULL))
+        file_name = data->file_name;
+
+    if ((data != NULL) && (data->lineno > 0))
+        fprintf (stderr, "conversion error in %s, [%s] %s at line %d: "
+                 "%s expected\n", file_name, section, key, data->lineno,
+                 mini_convert_get_name (conversion));
+    else
+        fprintf (stderr, "conversion error in %s, [%s] %s: %s expected\n", 
+                 file_name, section, key, mini_convert_get_name (conversion));
+}
+
+/**
+ *  Gets a section's key value converted into a typed value. The first 
+ *  conversion of a value is cached in its SectionData, and reported once 
+ *  if it fails; a value converted into another type isn't cached.
+ *
+ *  The cache is safe for concurrent lookups: the thread moving it out of 
+ *  MINI_CONVERT_NONE writes the converted value and then publishes its 
+ *  type, which is never changed again. Other threads meanwhile convert 
+ *  on their own.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param section A section name.
+ *  @param key A key name.
+ *  @param conversion Type of the conversion, see mini_convert().
+ *  @param converted Pointer receiving the converted value.
+ *  @return The function returns a negative number, if the given section 
+ *          or the given key doesn't exist, or the value can't be converted.
+ */
+static int
+mini_file_get_converted (MiniFile *mini_file, const char *section, 
+                         const char *key, int conversion, 
+                         MiniConverted *converted)
+{
+    SectionData *data;
+    const char *value;
+    int cached, expected = MINI_CONVERT_NONE;
+
+    /* MiniFile, section and key can't be NULL */
+    assert (mini_file != NULL);
     assert (section != NULL);
     assert (key != NULL);
 
-    /* Search the given key into the data of the given section */
-    for (data = section->data; data != NULL; data = data->next)
-        if (strcmp (data->key, key) == 0)
-            break;
+    /* Frozen images are read-only, nothing is cached */
+    if (mini_file->frozen != NULL) {
+        value = mini_file_get_frozen_value (mini_file->frozen, section, key);
+        if (value == NULL)
+            return -1;
 
-    return data;
+        if (mini_convert (conversion, value, strlen (value), converted) < 0) {
+            mini_file_conversion_error (mini_file, section, key, NULL, 
+                                        conversion);
+            return -1;
+        }
+
+        return 0;
+    }
+
+    data = mini_file_lookup (mini_file, section, key);
+    if (data == NULL)
+        return -1;
+
+    cached = atomic_load_explicit (&data->conversion, memory_order_acquire);
+    if ((cached & ~MINI_CONVERT_FAILED) == conversion) {
+        if (cached & MINI_CONVERT_FAILED)
+            return -1;
+
+        *converted = data->converted;
+        return 0;
+    }
+
+    /* Another type is cached, or being cached: convert without caching */
+    if ((cached != MINI_CONVERT_NONE) || 
+        !atomic_compare_exchange_strong (&data->conversion, &expected, 
+                                         MINI_CONVERT_PENDING)) {
+        if (mini_convert (conversion, data->value, data->value_len, 
+                          converted) < 0) {
+            mini_file_conversion_error (mini_file, section, key, data, 
+                                        conversion);
+            return -1;
+        }
+
+        return 0;
+    }
+
+    if (mini_convert (conversion, data->value, data->value_len, 
+                      &data->converted) < 0) {
+        mini_file_conversion_error (mini_file, section, key, data, 
+                                    conversion);
+        atomic_store_explicit (&data->conversion, 
+                               conversion | MINI_CONVERT_FAILED, 
+                               memory_order_release);
+        return -1;
+    }
+
+    atomic_store_explicit (&data->conversion, conversion, 
+                           memory_order_release);
+    *converted = data->converted;
+
+    return 0;
+}
+
+/**
+ *  Resolves the sections of a batch of queries, searching each distinct 
+ *  section once. The sections already searched are found again through 
+ *  a small open-addressing table of query positions.
+ *
+ *  @param mini_file A MiniFile structure, not sealed.
+ *  @param queries Array of queries.
+ *  @param n Number of queries.
+ *  @param batch Array receiving the section of each query.
+ *  @param table Zeroed array of query positions plus one.
+ *  @param table_size Size of the table (a power of two, bigger than n).
+ */
+static void
+mini_file_batch_sections (MiniFile *mini_file, const MiniQuery *queries, 
+                          size_t n, MiniFileBatch *batch, size_t *table, 
+                          size_t table_size)
+{
+    size_t mask = table_size - 1;
+    size_t i, pos, len;
+    const char *name;
+    uint64_t hash;
+
+    for (i = 0; i < n; i++) {
+        name = queries[i].section;
+
+        /* Queries are usually grouped by section already */
+        if ((i > 0) && ((queries[i - 1].section == name) || 
+                        (strcmp (queries[i - 1].section, name) == 0))) {
+            batch[i].section = batch[i - 1].section;
+            continue;
+        }
+
+        len = strlen (name);
+        hash = mini_hash (name, len);
+
+        for (pos = (size_t) hash & mask; table[pos] != 0; 
+             pos = (pos + 1) & mask)
+            if (strcmp (queries[table[pos] - 1].section, name) == 0)
+                break;
+
+        if (table[pos] != 0) {
+            batch[i].section = batch[table[pos] - 1].section;
+            continue;
+        }
+
+        table[pos] = i + 1;
+
+        if (mini_file->frozen != NULL)
+            batch[i].section = mini_frozen_find_section (mini_file->frozen, 
+                                                         name, len);
+        else
+            batch[i].section = mini_file_get_section (mini_file, name, len, 
+                                                      hash);
+    }
+}
+
+/**
+ *  Resolves the keys of a batch of queries whose sections are resolved. 
+ *  The key of the query MINI_BATCH_PREFETCH positions ahead is hashed and 
+ *  its index slot prefetched, and the key in the slot of the query half 
+ *  way ahead is prefetched too, so the probes rarely wait for the memory.
+ *
+ *  @param mini_file A MiniFile structure, neither sealed nor frozen.
+ *  @param queries Array of queries.
+ *  @param n Number of queries.
+ *  @param batch Array of the resolved queries.
+ *  @param out Array receiving the value of each query.
+ *  @return The return value is the number of values found.
+ */
+static size_t
+mini_file_batch_keys (MiniFile *mini_file, const MiniQuery *queries, 
+                      size_t n, MiniFileBatch *batch, const char **out)
+{
+    const size_t half = MINI_BATCH_PREFETCH / 2;
+    const Section *sec;
+    SectionData *data;
+    size_t i, j, found = 0;
+    unsigned int pos;
+
+    for (i = 0; i < n + MINI_BATCH_PREFETCH; i++) {
+        /* Hash the key ahead and prefetch its slot */
+        if (i < n) {
+            sec = (const Section *) batch[i].section;
+            if ((sec != NULL) && (sec->index != NULL)) {
+                batch[i].key_len = strlen (queries[i].key);
+                batch[i].hash = mini_hash (queries[i].key, batch[i].key_len);
+                __builtin_prefetch (&sec->index[batch[i].hash & 
+                                                (sec->index_size - 1)]);
+            }
+        }
+
+        /* Prefetch the key in the slot, loaded by now */
+        if ((i >= half) && (i - half < n)) {
+            j = i - half;
+            sec = (const Section *) batch[j].section;
+            if ((sec != NULL) && (sec->index != NULL)) {
+                data = sec->index[batch[j].hash & (sec->index_size - 1)];
+                if (data != NULL)
+                    __builtin_prefetch (data);
+            }
+        }
+
+        if (i < MINI_BATCH_PREFETCH)
+            continue;
+
+        j = i - MINI_BATCH_PREFETCH;
+        sec = (const Section *) batch[j].section;
+        if ((sec == NULL) || (sec->index == NULL)) {
+            out[j] = NULL;
+            continue;
+        }
+
+        pos = mini_file_index_probe ((void **) sec->index, sec->index_size, 
+                                     batch[j].hash, queries[j].key, 
+                                     batch[j].key_len, 0);
+        out[j] = mini_file_get_data_value (mini_file, sec->index[pos]);
+        if (out[j] != NULL)
+            found++;
+    }
+
+    return found;
+}
+
+/**
+ *  Gets the values of a batch of queries one by one.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param queries Array of queries.
+ *  @param n Number of queries.
+ *  @param out Array receiving the value of each query.
+ *  @return The return value is the number of values found.
+ */
+static size_t
+mini_file_get_values_each (MiniFile *mini_file, const MiniQuery *queries, 
+                           size_t n, const char **out)
+{
+    size_t i, found = 0;
+
+    for (i = 0; i < n; i++) {
+        out[i] = mini_file_get_value (mini_file, queries[i].section, 
+                                      queries[i].key);
+        if (out[i] != NULL)
+            found++;
+    }
+
+    return found;
 }
 
 
@@ -199,20 +696,67 @@ mini_file_find_key (const Section *section, const char *key)
 MiniFile *
 mini_file_new (const char *file_name)
 {
+    return mini_file_new_with_allocator (file_name, NULL);
+}
+
+/**
+ *  Creates a new MiniFile structure, as mini_file_new() does, whose 
+ *  memory (its arena, its intern table and the temporary memory of its 
+ *  functions) comes from the given allocator.
+ *
+ *  @param file_name INI file name.
+ *  @param allocator A MiniAllocator structure, which is copied, or NULL 
+ *         for the allocator of the library.
+ *  @return The return value is the new MiniFile structure.
+ *          The function returns NULL, if the MiniFile structure 
+ *          can't be created.
+ */
+MiniFile *
+mini_file_new_with_allocator (const char *file_name, 
+                              const MiniAllocator *allocator)
+{
+    MiniArena *arena;
     MiniFile *mini_file;
 
-    mini_file = (MiniFile *) malloc (sizeof (MiniFile));
-    if (mini_file == NULL)
+    /* The MiniFile structure lives in its own arena */
+    arena = mini_arena_new (allocator);
+    if (arena == NULL)
+        return NULL;
+
+    mini_file = (MiniFile *) mini_arena_alloc (arena, sizeof (MiniFile));
+    if (mini_file == NULL) {
+        mini_arena_free (arena);
+        return NULL;
+    }
+
+    mini_file->arena = arena;
+    mini_file->file_name = mini_arena_strdup (arena, file_name);
+    if (mini_file->file_name == NULL) {
+        mini_arena_free (arena);
         return NULL;
+    }
 
-    mini_file->file_name = strdup (file_name);
+    mini_file->mapping = NULL;
+    mini_file->mapping_size = 0;
+    mini_file->frozen = NULL;
+    mini_file->seal = NULL;
+    mini_file->lazy = NULL;
+    mini_file->fragments = NULL;
+    mini_file->intern = NULL;
     mini_file->section = NULL;
+    mini_file->last = NULL;
+    mini_file->index = NULL;
+    mini_file->index_size = 0;
+    mini_file->index_used = 0;
+    mini_file->num_sections = 0;
+    mini_file_touch (mini_file);
 
     return mini_file;
 }
 
 /**
- *  Frees an allocated MiniFile structure.
+ *  Frees an allocated MiniFile structure. All its sections, keys and 
+ *  values are released with it.
  *
  *  @param mini_file A MiniFile structure generated from an INI file.
  */
@@ -223,95 +767,619 @@ mini_file_free (MiniFile *mini_file)
     if (mini_file == NULL)
         return;
 
-    mini_file_section_free (mini_file->section);
-    mini_file->section = NULL;
-
-    free (mini_file->file_name);
-    mini_file->file_name = NULL;
+    if (mini_file->mapping != NULL)
+        munmap (mini_file->mapping, mini_file->mapping_size);
 
-    free (mini_file);
+    mini_include_release (mini_file);
+    mini_intern_table_unref (mini_file->intern);
+    mini_arena_free (mini_file->arena);
 }
 
 /**
- *  Inserts a section in a MiniFile structure.
+ *  Adds a section to a MiniFile structure.
+ *
+ *  When borrowing, the section name isn't copied: it must outlive the 
+ *  MiniFile and it doesn't need to be NUL terminated (unless it's 
+ *  MINI_BORROW_STABLE).
  *
  *  @param mini_file A MiniFile structure generated from an INI file.
  *  @param section_name A section name.
- *  @return The return value is the MiniFile structure.
+ *  @param name_len Length of the section name.
+ *  @param borrow MINI_COPY, MINI_BORROW or MINI_BORROW_STABLE.
+ *  @return The return value is the new Section structure.
  *          The function returns NULL, if the section can't be inserted.
  */
-MiniFile *
-mini_file_insert_section (MiniFile *mini_file, const char *section_name)
+Section *
+mini_file_add_section (MiniFile *mini_file, const char *section_name, 
+                       size_t name_len, int borrow)
 {
     Section *section;
 
     /* MiniFile can't be NULL */
     assert (mini_file != NULL);
 
-    section = mini_file_section_new (section_name);
+    /* Frozen MiniFiles can't be modified */
+    if (mini_file->frozen != NULL)
+        return NULL;
+
+    mini_file_touch (mini_file);
+
+    /* Copied names are interned */
+    if ((borrow == MINI_COPY) && 
+        (mini_file_get_intern_table (mini_file) == NULL))
+        return NULL;
+
+    section = mini_file_section_new (mini_file->arena, mini_file->intern, 
+                                     section_name, name_len, borrow);
     if (section == NULL)
         return NULL;
 
-    /* Insert at first position */
-    section->next = mini_file->section;
-    mini_file->section = section;
+    if (mini_file_index_insert (mini_file->arena, (void ***) &mini_file->index,
+                                &mini_file->index_size, &mini_file->index_used,
+                                section, section->hash, section->name, 
+                                section->name_len, 1) < 0)
+        return NULL;
+
+    /* Insert at last position */
+    mini_file_section_link (mini_file, section);
 
-    return mini_file;
+    return section;
 }
 
 /**
- *  Inserts a key-value pair in the last readed section from an INI file.
+ *  Adds a key-value pair to the last readed section from an INI file.
+ *
+ *  When borrowing, the key and the value aren't copied: they must outlive 
+ *  the MiniFile and they don't need to be NUL terminated. With 
+ *  MINI_BORROW_STABLE they must be NUL terminated and never modified, so 
+ *  lookups return them as they are instead of copying them.
  *
  *  @param mini_file A MiniFile structure generated from an INI file.
  *  @param key A key name.
+ *  @param key_len Length of the key name.
  *  @param value The value of the key.
- *  @return The return value is the MiniFile structure.
+ *  @param value_len Length of the value.
+ *  @param borrow MINI_COPY, MINI_BORROW or MINI_BORROW_STABLE.
+ *  @return The return value is the new SectionData structure.
  *          The function returns NULL, if the key-value pair can't be inserted.
  */
-MiniFile *
-mini_file_insert_key_and_value (MiniFile *mini_file, const char *key, 
-                                const char *value)
+SectionData *
+mini_file_add_key_and_value (MiniFile *mini_file, const char *key, 
+                             size_t key_len, const char *value, 
+                             size_t value_len, int borrow)
 {
-    SectionData *data;
-
     /* MiniFile can't be NULL */
     assert (mini_file != NULL);
 
     /* There isn't a section */
-    if (mini_file->section == NULL)
+    if (mini_file->last == NULL)
         return NULL;
 
-    data = mini_file_section_data_new (key, value);
-    if (data == NULL)
-        return NULL;
-
-    data->next = mini_file->section->data;
-    mini_file->section->data = data;
-
-    return mini_file;
+    return mini_file_add_key_to_section (mini_file, mini_file->last, key, 
+                                         key_len, value, value_len, borrow);
 }
 
 /**
- *  Gets the number of sections in an INI file.
+ *  Adds a key-value pair to a given section of a MiniFile structure, as 
+ *  mini_file_add_key_and_value() does with the last one.
  *
  *  @param mini_file A MiniFile structure generated from an INI file.
- *  @return The return value is the number of sections in the given INI file.
+ *  @param section A section of the MiniFile.
+ *  @param key A key name.
+ *  @param key_len Length of the key name.
+ *  @param value The value of the key.
+ *  @param value_len Length of the value.
+ *  @param borrow MINI_COPY, MINI_BORROW or MINI_BORROW_STABLE.
+ *  @return The return value is the new SectionData structure.
+ *          The function returns NULL, if the key-value pair can't be inserted.
  */
-unsigned int
-mini_file_get_number_of_sections (MiniFile *mini_file)
+SectionData *
+mini_file_add_key_to_section (MiniFile *mini_file, Section *section, 
+                              const char *key, size_t key_len, 
+                              const char *value, size_t value_len, 
+                              int borrow)
 {
-    unsigned int num_sections = 0;
-    Section *sec;
+    SectionData *data;
 
-    /* MiniFile can't be NULL */
+    /* MiniFile and section can't be NULL */
     assert (mini_file != NULL);
+    assert (section != NULL);
 
-    /* Count sections of the MiniFile */
-    for (sec = mini_file->section; sec != NULL; sec = sec->next)
-        num_sections++;
+    /* Frozen MiniFiles can't be modified */
+    if (mini_file->frozen != NULL)
+        return NULL;
 
-    return num_sections;
-}
+    mini_file_touch (mini_file);
+
+    /* Copied keys are interned */
+    if ((borrow == MINI_COPY) && 
+        (mini_file_get_intern_table (mini_file) == NULL))
+        return NULL;
+
+    data = mini_file_section_data_new (mini_file->arena, mini_file->intern, 
+                                       key, key_len, value, value_len, 
+                                       borrow);
+    if (data == NULL)
+        return NULL;
+
+    if (mini_file_index_insert (mini_file->arena, (void ***) &section->index, 
+                                &section->index_size, &section->index_used,
+                                data, data->hash, data->key, data->key_len,
+                                0) < 0)
+        return NULL;
+
+    /* Insert at last position */
+    if (section->last != NULL)
+        section->last->next = data;
+    else
+        section->data = data;
+
+    section->last = data;
+    section->num_keys++;
+
+    return data;
+}
+
+/**
+ *  Inserts a section in a MiniFile structure.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param section_name A section name.
+ *  @return The return value is the MiniFile structure.
+ *          The function returns NULL, if the section can't be inserted.
+ */
+MiniFile *
+mini_file_insert_section (MiniFile *mini_file, const char *section_name)
+{
+    /* Section name can't be NULL */
+    assert (section_name != NULL);
+
+    if (mini_file_add_section (mini_file, section_name, strlen (section_name),
+                               MINI_COPY) == NULL)
+        return NULL;
+
+    return mini_file;
+}
+
+/**
+ *  Inserts a key-value pair in the last readed section from an INI file.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param key A key name.
+ *  @param value The value of the key.
+ *  @return The return value is the MiniFile structure.
+ *          The function returns NULL, if the key-value pair can't be inserted.
+ */
+MiniFile *
+mini_file_insert_key_and_value (MiniFile *mini_file, const char *key, 
+                                const char *value)
+{
+    /* Key and value can't be NULL */
+    assert (key != NULL);
+    assert (value != NULL);
+
+    if (mini_file_add_key_and_value (mini_file, key, strlen (key), value, 
+                                     strlen (value), MINI_COPY) == NULL)
+        return NULL;
+
+    return mini_file;
+}
+
+/**
+ *  Appends all the sections of a MiniFile to the end of another one, as 
+ *  if they were parsed after its last section. The appended MiniFile is 
+ *  consumed: its memory is moved into the first one and it can't be used 
+ *  anymore.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param tail A MiniFile structure to be appended.
+ *  @param continued Section of tail whose keys belong to the last section 
+ *         of mini_file instead of being a section on its own, or NULL.
+ *         Both MiniFiles must have the same allocator, and the same 
+ *         intern table unless one of them has none.
+ *  @return The function returns a negative number, if the sections 
+ *          can't be appended. The tail isn't consumed then.
+ */
+int
+mini_file_append (MiniFile *mini_file, MiniFile *tail, Section *continued)
+{
+    Section *sec, *next;
+    SectionData *data;
+    unsigned int i;
+
+    /* MiniFiles can't be NULL */
+    assert (mini_file != NULL);
+    assert (tail != NULL);
+
+    /* Frozen MiniFiles can't be modified */
+    if ((mini_file->frozen != NULL) || (tail->frozen != NULL))
+        return -1;
+
+    /* The bodies of a lazy tail are parsed from its own mapping */
+    if (tail->lazy != NULL)
+        return -1;
+
+    /* Keys without section */
+    if ((continued != NULL) && (continued->data != NULL) && 
+        (mini_file->last == NULL))
+        return -1;
+
+    /* The memory of the tail is released by the arena of mini_file */
+    if (memcmp (&mini_file->arena->allocator, &tail->arena->allocator, 
+                sizeof (MiniAllocator)) != 0)
+        return -1;
+
+    /* The interned names of the tail must stay in a table of mini_file */
+    if ((tail->intern != NULL) && (mini_file->intern != NULL) && 
+        (tail->intern != mini_file->intern))
+        return -1;
+
+    mini_file_touch (mini_file);
+
+    /* Index the appended nodes, the index of the tail keeps the last ones */
+    for (i = 0; i < tail->index_size; i++) {
+        sec = tail->index[i];
+        if ((sec == NULL) || (sec == continued))
+            continue;
+
+        if (mini_file_index_insert (mini_file->arena, 
+                                    (void ***) &mini_file->index,
+                                    &mini_file->index_size, 
+                                    &mini_file->index_used, sec, sec->hash, 
+                                    sec->name, sec->name_len, 1) < 0)
+            return -1;
+    }
+
+    if (continued != NULL) {
+        sec = mini_file->last;
+
+        for (i = 0; i < continued->index_size; i++) {
+            data = continued->index[i];
+            if (data == NULL)
+                continue;
+
+            if (mini_file_index_insert (mini_file->arena, 
+                                        (void ***) &sec->index,
+                                        &sec->index_size, &sec->index_used,
+                                        data, data->hash, data->key, 
+                                        data->key_len, 0) < 0)
+                return -1;
+        }
+
+        /* The continued keys go after the keys of the last section */
+        if (continued->data != NULL) {
+            if (sec->last != NULL)
+                sec->last->next = continued->data;
+            else
+                sec->data = continued->data;
+
+            sec->last = continued->last;
+            sec->num_keys += continued->num_keys;
+        }
+    }
+
+    /* Link the sections of the tail after the current ones */
+    for (sec = tail->section; sec != NULL; sec = next) {
+        next = sec->next;
+        if (sec != continued)
+            mini_file_section_link (mini_file, sec);
+    }
+
+    /* The table of the tail is taken over, or it's the same one */
+    if (mini_file->intern == NULL)
+        mini_file->intern = tail->intern;
+    else
+        mini_intern_table_unref (tail->intern);
+
+    /* The fragments borrowed by the tail are released with mini_file */
+    if (tail->fragments != NULL) {
+        MiniFragmentRef *ref = tail->fragments;
+
+        while (ref->next != NULL)
+            ref = ref->next;
+        ref->next = mini_file->fragments;
+        mini_file->fragments = tail->fragments;
+    }
+
+    if (tail->mapping != NULL)
+        munmap (tail->mapping, tail->mapping_size);
+
+    mini_arena_merge (mini_file->arena, tail->arena);
+
+    return 0;
+}
+
+/**
+ *  Empties a MiniFile structure. Its sections aren't freed: they stay in 
+ *  the arena of the MiniFile, so they can be linked again. The index of 
+ *  the sections is cleared and reused by the linked ones.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ */
+void
+mini_file_reset (MiniFile *mini_file)
+{
+    /* MiniFile can't be NULL */
+    assert (mini_file != NULL);
+
+    mini_file_touch (mini_file);
+    mini_file->section = NULL;
+    mini_file->last = NULL;
+    if (mini_file->index != NULL)
+        memset (mini_file->index, 0, 
+                mini_file->index_size * sizeof (Section *));
+    mini_file->index_used = 0;
+    mini_file->num_sections = 0;
+}
+
+/**
+ *  Adds an existing section, with all its keys, after the last section of 
+ *  a MiniFile structure. The section must live as long as the MiniFile.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param section A Section structure, not linked into any MiniFile.
+ *  @return The function returns a negative number, if the section can't 
+ *          be linked.
+ */
+int
+mini_file_link_section (MiniFile *mini_file, Section *section)
+{
+    /* MiniFile and section can't be NULL */
+    assert (mini_file != NULL);
+    assert (section != NULL);
+
+    /* Frozen MiniFiles can't be modified */
+    if (mini_file->frozen != NULL)
+        return -1;
+
+    mini_file_touch (mini_file);
+
+    if (mini_file_index_insert (mini_file->arena, (void ***) &mini_file->index,
+                                &mini_file->index_size, &mini_file->index_used,
+                                section, section->hash, section->name, 
+                                section->name_len, 1) < 0)
+        return -1;
+
+    mini_file_section_link (mini_file, section);
+
+    return 0;
+}
+
+/**
+ *  Gets the table in which the copied section names and keys of a 
+ *  MiniFile are interned, creating it if needed. Lookup keys interned in 
+ *  it are found by pointer, see mini_file_find_interned_key().
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @return The return value is the intern table of the MiniFile.
+ *          The function returns NULL, if the table can't be created.
+ */
+MiniInternTable *
+mini_file_get_intern_table (MiniFile *mini_file)
+{
+    /* MiniFile can't be NULL */
+    assert (mini_file != NULL);
+
+    if (mini_file->intern == NULL)
+        mini_file->intern = mini_intern_table_new_with_allocator (0, 
+            &mini_file->arena->allocator);
+
+    return mini_file->intern;
+}
+
+/**
+ *  Makes a MiniFile intern its copied section names and keys in a given 
+ *  table, as a table shared by many MiniFiles (see 
+ *  mini_intern_table_new()). It must be set before copying any string.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param table A MiniInternTable structure, the MiniFile takes a 
+ *         reference to it.
+ *  @return The function returns a negative number, if the MiniFile 
+ *          already copied strings into another table.
+ */
+int
+mini_file_set_intern_table (MiniFile *mini_file, MiniInternTable *table)
+{
+    /* MiniFile and table can't be NULL */
+    assert (mini_file != NULL);
+    assert (table != NULL);
+
+    if (mini_file->intern == table)
+        return 0;
+
+    if ((mini_file->intern != NULL) && (mini_file->intern->num_strings > 0))
+        return -1;
+
+    mini_intern_table_unref (mini_file->intern);
+    mini_file->intern = mini_intern_table_ref (table);
+
+    return 0;
+}
+
+/**
+ *  Searches for a section in a given MiniFile.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param section A section name.
+ *  @param section_len Length of the section name.
+ *  @return The function returns NULL, if the given section can't be found.
+ */
+Section *
+mini_file_find_section (const MiniFile *mini_file, const char *section, 
+                        size_t section_len)
+{
+    unsigned int pos;
+
+    /* MiniFile and section can't be NULL */
+    assert (mini_file != NULL);
+    assert (section != NULL);
+
+    if (mini_file->index == NULL)
+        return NULL;
+
+    /* Search the given section into the index of the given mini file */
+    pos = mini_file_index_probe ((void **) mini_file->index, 
+                                 mini_file->index_size,
+                                 mini_hash (section, section_len),
+                                 section, section_len, 1);
+
+    return mini_file->index[pos];
+}
+
+/**
+ *  Searches for a key in a given section of a MiniFile.
+ *
+ *  @param section Section in which the given key will be searched.
+ *  @param key A key name.
+ *  @param key_len Length of the key name.
+ *  @return The function returns NULL, if the given key can't be found.
+ */
+SectionData *
+mini_file_find_key (const Section *section, const char *key, size_t key_len)
+{
+    unsigned int pos;
+
+    /* Data and key can't be NULL */
+    assert (section != NULL);
+    assert (key != NULL);
+
+    if (section->index == NULL)
+        return NULL;
+
+    /* Search the given key into the index of the given section */
+    pos = mini_file_index_probe ((void **) section->index, section->index_size,
+                                 mini_hash (key, key_len), key, key_len, 0);
+
+    return section->index[pos];
+}
+
+/**
+ *  Searches for a section in a given MiniFile by an interned name. Its 
+ *  hash isn't computed again and, if the name was interned in the table 
+ *  of the MiniFile, the section is found by pointer.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param section A section name returned by mini_intern().
+ *  @return The function returns NULL, if the given section can't be found.
+ */
+Section *
+mini_file_find_interned_section (const MiniFile *mini_file, 
+                                 const char *section)
+{
+    unsigned int pos;
+
+    /* MiniFile and section can't be NULL */
+    assert (mini_file != NULL);
+    assert (section != NULL);
+
+    if (mini_file->index == NULL)
+        return NULL;
+
+    pos = mini_file_index_probe ((void **) mini_file->index, 
+                                 mini_file->index_size,
+                                 mini_intern_get_hash (section), section, 
+                                 mini_intern_get_len (section), 1);
+
+    return mini_file->index[pos];
+}
+
+/**
+ *  Searches for a key in a given section of a MiniFile by an interned 
+ *  name. Its hash isn't computed again and, if the name was interned in 
+ *  the table of the MiniFile, the key is found by pointer.
+ *
+ *  @param section Section in which the given key will be searched.
+ *  @param key A key name returned by mini_intern().
+ *  @return The function returns NULL, if the given key can't be found.
+ */
+SectionData *
+mini_file_find_interned_key (const Section *section, const char *key)
+{
+    unsigned int pos;
+
+    /* Data and key can't be NULL */
+    assert (section != NULL);
+    assert (key != NULL);
+
+    if (section->index == NULL)
+        return NULL;
+
+    pos = mini_file_index_probe ((void **) section->index, section->index_size,
+                                 mini_intern_get_hash (key), key, 
+                                 mini_intern_get_len (key), 0);
+
+    return section->index[pos];
+}
+
+/**
+ *  Iterates over the sections of a MiniFile in file order, duplicated
+ *  sections included:
+ *
+ *      for (sec = mini_file_section_iter (mf, NULL); sec != NULL;
+ *           sec = mini_file_section_iter (mf, sec))
+ *
+ *  Frozen MiniFiles have no sections to iterate over. The returned 
+ *  section is parsed if it isn't parsed yet (see mini_file_open_lazy()).
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param section The previous section, or NULL to get the first one.
+ *  @return The return value is the next section.
+ *          The function returns NULL, if there are no more sections.
+ */
+Section *
+mini_file_section_iter (MiniFile *mini_file, const Section *section)
+{
+    Section *next;
+
+    /* MiniFile can't be NULL */
+    assert (mini_file != NULL);
+
+    next = (section == NULL) ? mini_file->section : section->next;
+    if ((next != NULL) && (next->lazy != 0))
+        mini_lazy_load_section (mini_file, next);
+
+    return next;
+}
+
+/**
+ *  Iterates over the keys of a section in file order, duplicated keys
+ *  included, like mini_file_section_iter(). The section must be parsed: 
+ *  sections of a MiniFile opened by mini_file_open_lazy() must come from 
+ *  mini_file_section_iter() or be loaded by mini_lazy_load_section().
+ *
+ *  @param section A Section structure.
+ *  @param data The previous key, or NULL to get the first one.
+ *  @return The return value is the next key.
+ *          The function returns NULL, if there are no more keys.
+ */
+SectionData *
+mini_section_key_iter (const Section *section, const SectionData *data)
+{
+    /* Section can't be NULL nor pending to be parsed */
+    assert (section != NULL);
+    assert (section->lazy == 0);
+
+    if (data == NULL)
+        return section->data;
+
+    return data->next;
+}
+
+/**
+ *  Gets the number of sections in an INI file.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @return The return value is the number of sections in the given INI file.
+ */
+unsigned int
+mini_file_get_number_of_sections (MiniFile *mini_file)
+{
+    /* MiniFile can't be NULL */
+    assert (mini_file != NULL);
+
+    return mini_file->num_sections;
+}
 
 /**
  *  Gets the number of keys in a given section.
@@ -323,23 +1391,28 @@ mini_file_get_number_of_sections (MiniFile *mini_file)
 unsigned int
 mini_file_get_number_of_keys (MiniFile *mini_file, const char *section)
 {
-    unsigned int num_keys = 0;
     Section *sec;
-    SectionData *data;
+    size_t section_len;
 
     /* MiniFile can't be NULL */
     assert (mini_file != NULL);
 
+    if (mini_file->frozen != NULL) {
+        const MiniFrozenSection *fsec;
+
+        fsec = mini_frozen_find_section (mini_file->frozen, section, 
+                                         strlen (section));
+        return (fsec != NULL) ? fsec->num_keys : 0;
+    }
+
     /* Search the given section */
-    sec = mini_file_find_section (mini_file, section);
+    section_len = strlen (section);
+    sec = mini_file_get_section (mini_file, section, section_len, 
+                                 mini_hash (section, section_len));
     if (sec == NULL)
         return 0;
 
-    /* Count keys of the section */
-    for (data = sec->data; data != NULL; data = data->next)
-        num_keys++;
-
-    return num_keys;
+    return sec->num_keys;
 }
 
 /**
@@ -351,26 +1424,314 @@ mini_file_get_number_of_keys (MiniFile *mini_file, const char *section)
  *  @return The return value is the value from the given section's key.
  *          The function returns NULL, if the given section or the given 
  *          key doesn't exist.
+ *          Values borrowed from a buffer (see mini_parse_buffer() and 
+ *          mini_parse_mmap()) are copied into the MiniFile the first time 
+ *          they are requested, to NUL terminate them: lookups then modify 
+ *          the MiniFile and concurrent ones must be serialized. 
+ *          mini_file_get_value_view() never copies.
  */
 char *
 mini_file_get_value (MiniFile *mini_file, const char *section, const char *key)
 {
-    Section *sec;
     SectionData *data;
 
     /* MiniFile can't be NULL */
     assert (mini_file != NULL);
 
-    /* Search the given section */
-    sec = mini_file_find_section (mini_file, section);
-    if (sec == NULL)
+    if (mini_file->frozen != NULL)
+        return mini_file_get_frozen_value (mini_file->frozen, section, key);
+
+    data = mini_file_lookup (mini_file, section, key);
+
+    return mini_file_get_data_value (mini_file, data);
+}
+
+/**
+ *  Gets a value from a section's key without copying it: the value is 
+ *  returned as a view with its length, and it's NUL terminated only if 
+ *  the MiniFile copied it. Unlike mini_file_get_value(), the lookup 
+ *  doesn't modify the MiniFile, unless it's opened lazily and the 
+ *  section isn't parsed yet (see mini_file_open_lazy()).
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param section A section name.
+ *  @param key A key name.
+ *  @param len Pointer receiving the length of the value.
+ *  @return The return value is the start of the value, valid while the 
+ *          MiniFile isn't modified.
+ *          The function returns NULL, if the given section or the given 
+ *          key doesn't exist.
+ */
+const char *
+mini_file_get_value_view (MiniFile *mini_file, const char *section, 
+                          const char *key, size_t *len)
+{
+    const MiniFrozenSection *fsec;
+    const MiniFrozenKey *fdata;
+    const SectionData *data;
+
+    /* MiniFile, section, key and len can't be NULL */
+    assert (mini_file != NULL);
+    assert (section != NULL);
+    assert (key != NULL);
+    assert (len != NULL);
+
+    if (mini_file->frozen != NULL) {
+        fsec = mini_frozen_find_section (mini_file->frozen, section, 
+                                         strlen (section));
+        fdata = (fsec != NULL) ? mini_frozen_find_key (mini_file->frozen, 
+                                                       fsec, key, 
+                                                       strlen (key)) : NULL;
+        if (fdata == NULL)
+            return NULL;
+
+        *len = fdata->value_len;
+        return (const char *) mini_file->frozen + fdata->value;
+    }
+
+    data = mini_file_lookup (mini_file, section, key);
+    if (data == NULL)
         return NULL;
 
-    /* Search the given key */
-    data = mini_file_find_key (sec, key);
+    *len = data->value_len;
+    return data->value;
+}
+
+/**
+ *  Gets the value of a key, copying it into the arena the first time if 
+ *  it's borrowed (borrowed values aren't NUL terminated). The copy 
+ *  modifies the MiniFile, as mini_file_get_value() does.
+ *
+ *  @param mini_file A MiniFile structure, not frozen.
+ *  @param data A key of the MiniFile, or NULL.
+ *  @return The return value is the value of the key.
+ *          The function returns NULL, if the key is NULL or its value 
+ *          can't be copied.
+ */
+char *
+mini_file_get_data_value (MiniFile *mini_file, SectionData *data)
+{
+    char *value;
+
+    /* MiniFile can't be NULL */
+    assert (mini_file != NULL);
+
     if (data == NULL)
         return NULL;
 
+    if (data->borrowed) {
+        value = mini_arena_strndup (mini_file->arena, data->value, 
+                                    data->value_len);
+        if (value == NULL)
+            return NULL;
+
+        data->value = value;
+        data->borrowed = 0;
+    }
+
     return data->value;
 }
 
+/**
+ *  Gets the values of many section's keys at once, as mini_file_get_value() 
+ *  does for each query. Each distinct section is searched once, and the 
+ *  key probes are prefetched across the batch, so it's faster than a 
+ *  mini_file_get_value() call per query.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param queries Array of the section and key names to search.
+ *  @param n Number of queries.
+ *  @param out Array of n values receiving the value of each query, or 
+ *         NULL if the section or the key doesn't exist.
+ *  @return The return value is the number of values found.
+ */
+size_t
+mini_file_get_values (MiniFile *mini_file, const MiniQuery *queries, 
+                      size_t n, const char **out)
+{
+    const MiniAllocator *allocator;
+    const MiniFrozenKey *fdata;
+    MiniFileBatch *batch;
+    size_t i, table_size, *table, found = 0;
+
+    /* MiniFile, queries and out can't be NULL */
+    assert (mini_file != NULL);
+    assert ((queries != NULL) || (n == 0));
+    assert ((out != NULL) || (n == 0));
+
+    /* The perfect hash searches the section and the key at once */
+    if (mini_file->seal != NULL)
+        return mini_file_get_values_each (mini_file, queries, n, out);
+
+    for (table_size = MINI_INDEX_MIN_SIZE; table_size < 2 * n; 
+         table_size <<= 1)
+        ;
+
+    allocator = &mini_file->arena->allocator;
+    batch = (MiniFileBatch *) mini_calloc (allocator, n, 
+                                           sizeof (MiniFileBatch));
+    table = (size_t *) mini_calloc (allocator, table_size, sizeof (size_t));
+    if ((batch == NULL) || (table == NULL)) {
+        mini_free (allocator, batch);
+        mini_free (allocator, table);
+
+        /* Search them one by one */
+        return mini_file_get_values_each (mini_file, queries, n, out);
+    }
+
+    mini_file_batch_sections (mini_file, queries, n, batch, table, 
+                              table_size);
+
+    if (mini_file->frozen != NULL) {
+        for (i = 0; i < n; i++) {
+            out[i] = NULL;
+            if (batch[i].section == NULL)
+                continue;
+
+            fdata = mini_frozen_find_key (mini_file->frozen, 
+                                          batch[i].section, queries[i].key, 
+                                          strlen (queries[i].key));
+            if (fdata != NULL) {
+                out[i] = (const char *) mini_file->frozen + fdata->value;
+                found++;
+            }
+        }
+    } else {
+        found = mini_file_batch_keys (mini_file, queries, n, batch, out);
+    }
+
+    mini_free (allocator, table);
+    mini_free (allocator, batch);
+
+    return found;
+}
+
+/**
+ *  Gets a section's key value as an integer (decimal, hexadecimal with 
+ *  "0x" or octal with "0"). The conversion is cached.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param section A section name.
+ *  @param key A key name.
+ *  @param value Pointer receiving the integer.
+ *  @return The function returns a negative number, if the given section 
+ *          or the given key doesn't exist, or the value isn't an integer.
+ */
+int
+mini_file_get_int64 (MiniFile *mini_file, const char *section, 
+                     const char *key, int64_t *value)
+{
+    MiniConverted converted;
+
+    if (mini_file_get_converted (mini_file, section, key, MINI_CONVERT_INT64,
+                                 &converted) < 0)
+        return -1;
+
+    *value = converted.int64;
+
+    return 0;
+}
+
+/**
+ *  Gets a section's key value as a floating point number. The conversion 
+ *  is cached.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param section A section name.
+ *  @param key A key name.
+ *  @param value Pointer receiving the number.
+ *  @return The function returns a negative number, if the given section 
+ *          or the given key doesn't exist, or the value isn't a number.
+ */
+int
+mini_file_get_double (MiniFile *mini_file, const char *section, 
+                      const char *key, double *value)
+{
+    MiniConverted converted;
+
+    if (mini_file_get_converted (mini_file, section, key, MINI_CONVERT_DOUBLE,
+                                 &converted) < 0)
+        return -1;
+
+    *value = converted.number;
+
+    return 0;
+}
+
+/**
+ *  Gets a section's key value as a boolean ("true", "yes", "on" or "1", 
+ *  and "false", "no", "off" or "0"). The conversion is cached.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param section A section name.
+ *  @param key A key name.
+ *  @param value Pointer receiving 1 (true) or 0 (false).
+ *  @return The function returns a negative number, if the given section 
+ *          or the given key doesn't exist, or the value isn't a boolean.
+ */
+int
+mini_file_get_bool (MiniFile *mini_file, const char *section, 
+                    const char *key, int *value)
+{
+    MiniConverted converted;
+
+    if (mini_file_get_converted (mini_file, section, key, MINI_CONVERT_BOOL,
+                                 &converted) < 0)
+        return -1;
+
+    *value = converted.boolean;
+
+    return 0;
+}
+
+/**
+ *  Gets a section's key value as a duration, like "250ms" or "1.5h" 
+ *  (see mini_convert() for the units). The conversion is cached.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param section A section name.
+ *  @param key A key name.
+ *  @param value Pointer receiving the duration, in nanoseconds.
+ *  @return The function returns a negative number, if the given section 
+ *          or the given key doesn't exist, or the value isn't a duration.
+ */
+int
+mini_file_get_duration (MiniFile *mini_file, const char *section, 
+                        const char *key, int64_t *value)
+{
+    MiniConverted converted;
+
+    if (mini_file_get_converted (mini_file, section, key, 
+                                 MINI_CONVERT_DURATION, &converted) < 0)
+        return -1;
+
+    *value = converted.duration;
+
+    return 0;
+}
+
+/**
+ *  Gets a section's key value as a size, like "4KiB" or "10MB" (see 
+ *  mini_convert() for the units). The conversion is cached.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param section A section name.
+ *  @param key A key name.
+ *  @param value Pointer receiving the size, in bytes.
+ *  @return The function returns a negative number, if the given section 
+ *          or the given key doesn't exist, or the value isn't a size.
+ */
+int
+mini_file_get_size (MiniFile *mini_file, const char *section, 
+                    const char *key, uint64_t *value)
+{
+    MiniConverted converted;
+
+    if (mini_file_get_converted (mini_file, section, key, MINI_CONVERT_SIZE,
+                                 &converted) < 0)
+        return -1;
+
+    *value = converted.size;
+
+    return 0;
+}
@@ -32,39 +32,178 @@
 #define __MINI_FILE_H__
 
 #include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "mini-alloc.h"
+#include "mini-arena.h"
+#include "mini-convert.h"
+#include "mini-hash.h"
+#include "mini-intern.h"
+
+#define MINI_INDEX_MIN_SIZE 8
+/* Queries looked ahead by mini_file_get_values() to prefetch their keys */
+#define MINI_BATCH_PREFETCH 8
+
+/* Frozen image, see mini-frozen.h */
+typedef struct _MiniFrozenHeader MiniFrozenHeader;
+
+/* Perfect hash of a sealed MiniFile, see mini-seal.h */
+typedef struct _MiniSeal MiniSeal;
+
+/* Sections parsed on demand, see mini-lazy.h */
+typedef struct _MiniLazy MiniLazy;
+
+/* Files included with "!include path", see mini-include.h */
+typedef struct _MiniFragment MiniFragment;
+typedef struct _MiniFragmentRef MiniFragmentRef;
+
+/* 
+ * Ownership of the strings given to mini_file_add_*(): copied, borrowed, 
+ * or borrowed NUL terminated and immutable, so lookups never copy them.
+ */
+#define MINI_COPY 0
+#define MINI_BORROW 1
+#define MINI_BORROW_STABLE 2
+
+/* 
+ * Names and values may be borrowed from a buffer (see mini_parse_buffer()),
+ * so they aren't always NUL terminated: use their lengths.
+ */
 typedef struct _SectionData SectionData;
 struct _SectionData {
     char *key;
     char *value;
+    size_t key_len;
+    size_t value_len;
+    /* The value isn't NUL terminated, lookups copy it (see MINI_BORROW) */
+    int borrowed;
     SectionData *next;
+    uint64_t hash;
+    /* Line of the key in the INI file (0 if unknown) */
+    int lineno;
+    /* Included file holding the key, borrowed (NULL for the INI file) */
+    const char *file_name;
+    /* 
+     * First conversion of the value, see mini_file_get_int64(): converted 
+     * is written once, before conversion is published.
+     */
+    atomic_int conversion;
+    MiniConverted converted;
 };
 
 typedef struct _Section Section;
 struct _Section {
     char *name;
+    size_t name_len;
+    /* Keys in file order, new keys are added after the last one */
     SectionData *data;
+    SectionData *last;
     Section *next;
+    uint64_t hash;
+    /* Open-addressing index of the keys (the last inserted key wins) */
+    SectionData **index;
+    unsigned int index_size;
+    unsigned int index_used;
+    unsigned int num_keys;
+    /* Span of the body not parsed yet plus one, see mini-lazy.h (or 0) */
+    unsigned int lazy;
+    /* Hash of the keys and values, see mini_watch (0 if not computed) */
+    uint64_t content_hash;
+};
+
+/* A lookup of mini_file_get_values() */
+typedef struct _MiniQuery MiniQuery;
+struct _MiniQuery {
+    const char *section;
+    const char *key;
 };
 
 typedef struct _MiniFile MiniFile;
 struct _MiniFile {
+    /* Arena holding the MiniFile and all its sections, keys and values */
+    MiniArena *arena;
+    /* File mapping borrowed by the sections, keys and values (if any) */
+    void *mapping;
+    size_t mapping_size;
+    /* Frozen image answering the lookups (if any), read-only */
+    const MiniFrozenHeader *frozen;
+    /* Perfect hash answering the lookups (if sealed) */
+    MiniSeal *seal;
+    /* Bodies of the sections not parsed yet (if opened lazily) */
+    MiniLazy *lazy;
+    /* Included fragments borrowed by the sections, keys and values */
+    MiniFragmentRef *fragments;
+    /* Table of the copied section names and keys (created on first use) */
+    MiniInternTable *intern;
     char *file_name;
+    /* Sections in file order, new keys are added to the last one */
     Section *section;
+    Section *last;
+    /* Open-addressing index of the sections (the last inserted one wins) */
+    Section **index;
+    unsigned int index_size;
+    unsigned int index_used;
+    unsigned int num_sections;
+    /* Changed on every modification, unique in the process */
+    uint64_t generation;
 };
 
 
 MiniFile *mini_file_new (const char *file_name);
 
+MiniFile *mini_file_new_with_allocator (const char *file_name, 
+                                        const MiniAllocator *allocator);
+
 void mini_file_free (MiniFile *mini_file);
 
+Section *mini_file_add_section (MiniFile *mini_file, const char *section_name,
+                                size_t name_len, int borrow);
+
+SectionData *mini_file_add_key_and_value (MiniFile *mini_file, const char *key,
+                                          size_t key_len, const char *value, 
+                                          size_t value_len, int borrow);
+
+SectionData *mini_file_add_key_to_section (MiniFile *mini_file, 
+                                           Section *section, const char *key,
+                                           size_t key_len, const char *value,
+                                           size_t value_len, int borrow);
+
 MiniFile *mini_file_insert_section (MiniFile *mini_file, const char *section);
 
 MiniFile *mini_file_insert_key_and_value (MiniFile *mini_file, const char *key, 
                                           const char *value);
 
+int mini_file_append (MiniFile *mini_file, MiniFile *tail, 
+                      Section *continued);
+
+void mini_file_reset (MiniFile *mini_file);
+
+int mini_file_link_section (MiniFile *mini_file, Section *section);
+
+MiniInternTable *mini_file_get_intern_table (MiniFile *mini_file);
+
+int mini_file_set_intern_table (MiniFile *mini_file, MiniInternTable *table);
+
+Section *mini_file_find_section (const MiniFile *mini_file, const char *section,
+                                 size_t section_len);
+
+SectionData *mini_file_find_key (const Section *section, const char *key, 
+                                 size_t key_len);
+
+Section *mini_file_find_interned_section (const MiniFile *mini_file, 
+                                          const char *section);
+
+SectionData *mini_file_find_interned_key (const Section *section, 
+                                          const char *key);
+
+Section *mini_file_section_iter (MiniFile *mini_file, const Section *section);
+
+SectionData *mini_section_key_iter (const Section *section,
+                                    const SectionData *data);
+
 unsigned int mini_file_get_number_of_sections (MiniFile *mini_file);
 
 unsigned int mini_file_get_number_of_keys (MiniFile *mini_file, 
@@ -73,5 +212,29 @@ unsigned int mini_file_get_number_of_keys (MiniFile *mini_file,
 char *mini_file_get_value (MiniFile *mini_file, const char *section, 
                            const char *key);
 
+const char *mini_file_get_value_view (MiniFile *mini_file, 
+                                      const char *section, const char *key, 
+                                      size_t *len);
+
+char *mini_file_get_data_value (MiniFile *mini_file, SectionData *data);
+
+size_t mini_file_get_values (MiniFile *mini_file, const MiniQuery *queries, 
+                             size_t n, const char **out);
+
+int mini_file_get_int64 (MiniFile *mini_file, const char *section, 
+                         const char *key, int64_t *value);
+
+int mini_file_get_double (MiniFile *mini_file, const char *section, 
+                          const char *key, double *value);
+
+int mini_file_get_bool (MiniFile *mini_file, const char *section, 
+                        const char *key, int *value);
+
+int mini_file_get_duration (MiniFile *mini_file, const char *section, 
+                            const char *key, int64_t *value);
+
+int mini_file_get_size (MiniFile *mini_file, const char *section, 
+                        const char *key, uint64_t *value);
+
 #endif /* __MINI_FILE_H__ */
 
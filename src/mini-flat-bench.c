@@ -0,0 +1,190 @@
+/*
+ * mini-flat-bench.c
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "mini-flat.h"
+#include "mini-parser.h"
+
+#define DEFAULT_LOOKUPS 1000000
+#define ITERATIONS 10
+
+
+/**
+ *  Prints the program's usage.
+ */
+static void
+print_usage (const char *program_name)
+{
+    printf ("usage: %s INI-FILE [LOOKUPS]\n", program_name);
+    exit (0);
+}
+
+/**
+ *  Gets the current time, in seconds.
+ */
+static double
+get_time (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ *  Prints the time per operation of both layouts.
+ */
+static void
+print_result (const char *name, double linked, double flat, double ops)
+{
+    printf ("%-10s linked %8.2f ns/op   flat %8.2f ns/op   speedup %.2fx\n",
+            name, linked * 1e9 / ops, flat * 1e9 / ops, linked / flat);
+}
+
+
+/**
+ *  Compares the linked layout of a MiniFile with its flat layout: 
+ *  iterating all the keys and searching random existing keys.
+ */
+int
+main (int argc, char *argv[])
+{
+    MiniFile *mini_file;
+    MiniFlat *flat;
+    const Section *section;
+    const SectionData *data;
+    const Section *sec;
+    uint32_t *sections, *keys, i, j, s, k;
+    unsigned long lookups, n;
+    size_t sum_linked = 0, sum_flat = 0;
+    double start, linked, flat_time;
+
+    if ((argc != 2) && (argc != 3))
+        print_usage (argv[0]);
+
+    lookups = (argc == 3) ? strtoul (argv[2], NULL, 10) : DEFAULT_LOOKUPS;
+
+    mini_file = mini_parse_file (argv[1]);
+    if (mini_file == NULL) {
+        fprintf (stderr, "%s: Can't parse '%s' INI file!\n", argv[0], argv[1]);
+        return -1;
+    }
+
+    flat = mini_flat_new (mini_file);
+    if (flat == NULL) {
+        fprintf (stderr, "%s: Can't flatten '%s' INI file!\n", argv[0], 
+                 argv[1]);
+        return -1;
+    }
+
+    printf ("%u sections, %u keys\n", flat->num_sections, flat->num_keys);
+    if ((flat->num_keys == 0) || (lookups == 0))
+        return 0;
+
+    /* Iteration over all the keys */
+    start = get_time ();
+    for (i = 0; i < ITERATIONS; i++)
+        for (section = mini_file->section; section != NULL; 
+             section = section->next)
+            for (data = section->data; data != NULL; data = data->next)
+                sum_linked += data->value_len;
+    linked = get_time () - start;
+
+    start = get_time ();
+    for (i = 0; i < ITERATIONS; i++)
+        for (s = 0; s < flat->num_sections; s++)
+            for (k = flat->sections[s].first_key; 
+                 k < flat->sections[s].first_key + flat->sections[s].num_keys;
+                 k++)
+                sum_flat += flat->value_lens[k];
+    flat_time = get_time () - start;
+
+    if (sum_linked != sum_flat)
+        fprintf (stderr, "%s: Both layouts differ!\n", argv[0]);
+
+    print_result ("iterate", linked, flat_time, 
+                  (double) ITERATIONS * flat->num_keys);
+
+    /* Random existing keys, found by both layouts */
+    sections = (uint32_t *) malloc (lookups * sizeof (uint32_t));
+    keys = (uint32_t *) malloc (lookups * sizeof (uint32_t));
+    if ((sections == NULL) || (keys == NULL))
+        return -1;
+
+    srand (1);
+    for (n = 0; n < lookups; n++) {
+        s = (uint32_t) rand () % flat->num_sections;
+        while (flat->sections[s].num_keys == 0)
+            s = (s + 1) % flat->num_sections;
+
+        sections[n] = s;
+        keys[n] = flat->sections[s].first_key + 
+                  (uint32_t) rand () % flat->sections[s].num_keys;
+    }
+
+    j = 0;
+    start = get_time ();
+    for (n = 0; n < lookups; n++) {
+        s = sections[n];
+        k = keys[n];
+        sec = mini_file_find_section (mini_file, flat->sections[s].name, 
+                                      flat->sections[s].name_len);
+        if (mini_file_find_key (sec, flat->keys[k], flat->key_lens[k]) != NULL)
+            j++;
+    }
+    linked = get_time () - start;
+
+    start = get_time ();
+    for (n = 0; n < lookups; n++) {
+        s = sections[n];
+        k = keys[n];
+        s = mini_flat_find_section (flat, flat->sections[s].name, 
+                                    flat->sections[s].name_len);
+        if (mini_flat_find_key (flat, s, flat->keys[k], 
+                                flat->key_lens[k]) != MINI_FLAT_NOT_FOUND)
+            j--;
+    }
+    flat_time = get_time () - start;
+
+    if (j != 0)
+        fprintf (stderr, "%s: Both layouts differ!\n", argv[0]);
+
+    print_result ("lookup", linked, flat_time, (double) lookups);
+
+    free (sections);
+    free (keys);
+    mini_flat_free (flat);
+    mini_file_free (mini_file);
+
+    return 0;
+}
@@ -0,0 +1,401 @@
+/*
+ * mini-flat.c
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mini-flat.h"
+#include "mini-lazy.h"
+
+
+/**
+ *  Gets the size of an open-addressing index for some nodes, keeping its 
+ *  load factor under 1/2.
+ *
+ *  @param num_nodes Number of nodes.
+ *  @return The return value is the size (a power of two).
+ */
+static uint32_t
+mini_flat_index_size (uint32_t num_nodes)
+{
+    uint32_t size = MINI_INDEX_MIN_SIZE;
+
+    while (size < 2 * num_nodes)
+        size *= 2;
+
+    return size;
+}
+
+/**
+ *  Copies a string into the string block of a flat layout.
+ *
+ *  @param strings Pointer to the free space of the string block.
+ *  @param string String to be copied.
+ *  @param len Length of the string.
+ *  @return The return value is the NUL terminated copy.
+ */
+static const char *
+mini_flat_copy (char **strings, const char *string, size_t len)
+{
+    char *copy = *strings;
+
+    memcpy (copy, string, len);
+    copy[len] = '\0';
+    *strings += len + 1;
+
+    return copy;
+}
+
+/**
+ *  Indexes the keys of a section, the last one of every name wins.
+ *
+ *  @param flat A MiniFlat structure.
+ *  @param section A section with index slots.
+ */
+static void
+mini_flat_index_keys (MiniFlat *flat, const MiniFlatSection *section)
+{
+    uint32_t *index = &flat->key_index[section->index_first];
+    uint32_t mask = section->index_size - 1;
+    uint32_t i, pos, other;
+
+    for (i = section->first_key; i < section->first_key + section->num_keys;
+         i++) {
+        for (pos = flat->key_hashes[i] & mask; index[pos] != 0; 
+             pos = (pos + 1) & mask) {
+            other = index[pos] - 1;
+            if ((flat->key_hashes[other] == flat->key_hashes[i]) && 
+                (flat->key_lens[other] == flat->key_lens[i]) &&
+                (memcmp (flat->keys[other], flat->keys[i], 
+                         flat->key_lens[i]) == 0))
+                break;
+        }
+
+        index[pos] = i + 1;
+    }
+}
+
+/**
+ *  Indexes the sections, the last one of every name wins.
+ *
+ *  @param flat A MiniFlat structure.
+ */
+static void
+mini_flat_index_sections (MiniFlat *flat)
+{
+    const MiniFlatSection *sec, *other;
+    uint32_t mask = flat->section_index_size - 1;
+    uint32_t i, pos;
+
+    for (i = 0; i < flat->num_sections; i++) {
+        sec = &flat->sections[i];
+
+        for (pos = sec->hash & mask; flat->section_index[pos] != 0; 
+             pos = (pos + 1) & mask) {
+            other = &flat->sections[flat->section_index[pos] - 1];
+            if ((other->hash == sec->hash) && 
+                (other->name_len == sec->name_len) &&
+                (memcmp (other->name, sec->name, sec->name_len) == 0))
+                break;
+        }
+
+        flat->section_index[pos] = i + 1;
+    }
+}
+
+/**
+ *  Fills the sections and keys of a flat layout, in file order.
+ *
+ *  @param flat A MiniFlat structure with its arrays allocated.
+ *  @param mini_file The MiniFile being flattened.
+ *  @param strings String block.
+ */
+static void
+mini_flat_fill (MiniFlat *flat, const MiniFile *mini_file, char *strings)
+{
+    MiniFlatSection *sec;
+    const Section *section;
+    const SectionData *data;
+    uint32_t i, k, index_first;
+
+    k = 0;
+    index_first = 0;
+    for (section = mini_file->section, i = 0; section != NULL; 
+         section = section->next, i++) {
+        sec = &flat->sections[i];
+
+        sec->name = mini_flat_copy (&strings, section->name, 
+                                    section->name_len);
+        sec->name_len = section->name_len;
+        sec->hash = (uint32_t) section->hash;
+        sec->first_key = k;
+        sec->num_keys = section->num_keys;
+        sec->index_first = index_first;
+        sec->index_size = 0;
+        if (sec->num_keys > MINI_FLAT_SCAN_KEYS) {
+            sec->index_size = mini_flat_index_size (sec->num_keys);
+            index_first += sec->index_size;
+        }
+
+        for (data = section->data; data != NULL; data = data->next, k++) {
+            flat->key_hashes[k] = (uint32_t) data->hash;
+            flat->key_lens[k] = data->key_len;
+            flat->value_lens[k] = data->value_len;
+            flat->keys[k] = mini_flat_copy (&strings, data->key, 
+                                            data->key_len);
+            flat->values[k] = mini_flat_copy (&strings, data->value, 
+                                              data->value_len);
+        }
+
+        if (sec->index_size > 0)
+            mini_flat_index_keys (flat, sec);
+    }
+
+    mini_flat_index_sections (flat);
+}
+
+
+/**
+ *  Creates the flat layout of a MiniFile. The flat layout is a copy: it 
+ *  doesn't change with the MiniFile, and it can outlive it.
+ *
+ *  The sections of a MiniFile opened by mini_file_open_lazy() are parsed 
+ *  first, see mini_lazy_load_all().
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file, 
+ *         not frozen.
+ *  @return The return value is the new MiniFlat structure.
+ *          The function returns NULL, if the MiniFlat can't be created.
+ */
+MiniFlat *
+mini_flat_new (MiniFile *mini_file)
+{
+    MiniArena *arena;
+    MiniFlat *flat;
+    const Section *section;
+    const SectionData *data;
+    size_t strings_size = 0;
+    uint32_t num_keys = 0, index_size = 0;
+    char *strings;
+
+    /* MiniFile can't be NULL */
+    assert (mini_file != NULL);
+
+    /* Frozen images are flat already */
+    if (mini_file->frozen != NULL)
+        return NULL;
+
+    /* Every key is copied */
+    mini_lazy_load_all (mini_file);
+
+    for (section = mini_file->section; section != NULL; 
+         section = section->next) {
+        strings_size += section->name_len + 1;
+        for (data = section->data; data != NULL; data = data->next)
+            strings_size += data->key_len + data->value_len + 2;
+
+        num_keys += section->num_keys;
+        if (section->num_keys > MINI_FLAT_SCAN_KEYS)
+            index_size += mini_flat_index_size (section->num_keys);
+    }
+
+    arena = mini_arena_new (NULL);
+    if (arena == NULL)
+        return NULL;
+
+    flat = (MiniFlat *) mini_arena_alloc (arena, sizeof (MiniFlat));
+    if (flat == NULL)
+        goto error;
+
+    flat->arena = arena;
+    flat->num_sections = mini_file->num_sections;
+    flat->num_keys = num_keys;
+    flat->section_index_size = mini_flat_index_size (flat->num_sections);
+
+    flat->sections = (MiniFlatSection *) mini_arena_alloc (arena, 
+        flat->num_sections * sizeof (MiniFlatSection));
+    flat->key_hashes = (uint32_t *) mini_arena_alloc (arena, 
+        num_keys * sizeof (uint32_t));
+    flat->key_lens = (uint32_t *) mini_arena_alloc (arena, 
+        num_keys * sizeof (uint32_t));
+    flat->value_lens = (uint32_t *) mini_arena_alloc (arena, 
+        num_keys * sizeof (uint32_t));
+    flat->keys = (const char **) mini_arena_alloc (arena, 
+        num_keys * sizeof (char *));
+    flat->values = (const char **) mini_arena_alloc (arena, 
+        num_keys * sizeof (char *));
+    flat->section_index = (uint32_t *) mini_arena_calloc (arena, 
+        flat->section_index_size * sizeof (uint32_t));
+    flat->key_index = (uint32_t *) mini_arena_calloc (arena, 
+        index_size * sizeof (uint32_t));
+    strings = (char *) mini_arena_alloc (arena, strings_size);
+
+    if ((flat->sections == NULL) || (flat->key_hashes == NULL) || 
+        (flat->key_lens == NULL) || (flat->value_lens == NULL) || 
+        (flat->keys == NULL) || (flat->values == NULL) || 
+        (flat->section_index == NULL) || (flat->key_index == NULL) || 
+        (strings == NULL))
+        goto error;
+
+    mini_flat_fill (flat, mini_file, strings);
+
+    return flat;
+
+error:
+    mini_arena_free (arena);
+
+    return NULL;
+}
+
+/**
+ *  Frees a MiniFlat structure.
+ *
+ *  @param flat A MiniFlat structure.
+ */
+void
+mini_flat_free (MiniFlat *flat)
+{
+    /* Do nothing with NULL pointers */
+    if (flat == NULL)
+        return;
+
+    mini_arena_free (flat->arena);
+}
+
+/**
+ *  Searches for a section in a flat layout.
+ *
+ *  @param flat A MiniFlat structure.
+ *  @param section A section name.
+ *  @param section_len Length of the section name.
+ *  @return The return value is the position of the section.
+ *          The function returns MINI_FLAT_NOT_FOUND, if the given section 
+ *          can't be found.
+ */
+uint32_t
+mini_flat_find_section (const MiniFlat *flat, const char *section,
+                        size_t section_len)
+{
+    const MiniFlatSection *sec;
+    uint32_t mask, pos, hash;
+
+    /* MiniFlat and section can't be NULL */
+    assert (flat != NULL);
+    assert (section != NULL);
+
+    hash = (uint32_t) mini_hash (section, section_len);
+    mask = flat->section_index_size - 1;
+
+    for (pos = hash & mask; flat->section_index[pos] != 0; 
+         pos = (pos + 1) & mask) {
+        sec = &flat->sections[flat->section_index[pos] - 1];
+        if ((sec->hash == hash) && (sec->name_len == section_len) && 
+            (memcmp (sec->name, section, section_len) == 0))
+            return flat->section_index[pos] - 1;
+    }
+
+    return MINI_FLAT_NOT_FOUND;
+}
+
+/**
+ *  Searches for a key in a section of a flat layout. Small sections are 
+ *  scanned backwards through the short hashes of their keys, so the last 
+ *  key of every name wins; big ones are searched with their index.
+ *
+ *  @param flat A MiniFlat structure.
+ *  @param section Position of the section.
+ *  @param key A key name.
+ *  @param key_len Length of the key name.
+ *  @return The return value is the position of the key.
+ *          The function returns MINI_FLAT_NOT_FOUND, if the given key 
+ *          can't be found.
+ */
+uint32_t
+mini_flat_find_key (const MiniFlat *flat, uint32_t section, const char *key,
+                    size_t key_len)
+{
+    const MiniFlatSection *sec;
+    const uint32_t *index;
+    uint32_t mask, pos, hash, i;
+
+    /* MiniFlat and key can't be NULL */
+    assert (flat != NULL);
+    assert (section < flat->num_sections);
+    assert (key != NULL);
+
+    sec = &flat->sections[section];
+    hash = (uint32_t) mini_hash (key, key_len);
+
+    if (sec->index_size == 0) {
+        for (i = sec->first_key + sec->num_keys; i > sec->first_key; i--)
+            if ((flat->key_hashes[i - 1] == hash) && 
+                (flat->key_lens[i - 1] == key_len) &&
+                (memcmp (flat->keys[i - 1], key, key_len) == 0))
+                return i - 1;
+
+        return MINI_FLAT_NOT_FOUND;
+    }
+
+    index = &flat->key_index[sec->index_first];
+    mask = sec->index_size - 1;
+
+    for (pos = hash & mask; index[pos] != 0; pos = (pos + 1) & mask) {
+        i = index[pos] - 1;
+        if ((flat->key_hashes[i] == hash) && (flat->key_lens[i] == key_len) &&
+            (memcmp (flat->keys[i], key, key_len) == 0))
+            return i;
+    }
+
+    return MINI_FLAT_NOT_FOUND;
+}
+
+/**
+ *  Gets a value from a section's key of a flat layout.
+ *
+ *  @param flat A MiniFlat structure.
+ *  @param section A section name.
+ *  @param key A key name.
+ *  @return The return value is the value from the given section's key.
+ *          The function returns NULL, if the given section or the given 
+ *          key doesn't exist.
+ */
+const char *
+mini_flat_get_value (const MiniFlat *flat, const char *section, 
+                     const char *key)
+{
+    uint32_t sec, k;
+
+    sec = mini_flat_find_section (flat, section, strlen (section));
+    if (sec == MINI_FLAT_NOT_FOUND)
+        return NULL;
+
+    k = mini_flat_find_key (flat, sec, key, strlen (key));
+    if (k == MINI_FLAT_NOT_FOUND)
+        return NULL;
+
+    return flat->values[k];
+}
@@ -0,0 +1,99 @@
+/*
+ * mini-flat.h
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MINI_FLAT_H__
+#define __MINI_FLAT_H__
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mini-arena.h"
+#include "mini-file.h"
+#include "mini-hash.h"
+
+/* Sections with more keys are searched with an index, not scanned */
+#define MINI_FLAT_SCAN_KEYS 16
+
+#define MINI_FLAT_NOT_FOUND UINT32_MAX
+
+typedef struct _MiniFlatSection MiniFlatSection;
+struct _MiniFlatSection {
+    const char *name;
+    uint32_t name_len;
+    uint32_t hash;
+    uint32_t first_key;
+    uint32_t num_keys;
+    /* Slots of the key index, 0 if the keys are scanned */
+    uint32_t index_first;
+    uint32_t index_size;
+};
+
+/* 
+ * Flat layout of a MiniFile: the sections in file order in one array, and 
+ * the keys of every section as a range of a structure of arrays, so 
+ * scanning a section or searching its short hashes reads sequential 
+ * memory. Keys and values are copied into one block of NUL terminated 
+ * strings.
+ */
+typedef struct _MiniFlat MiniFlat;
+struct _MiniFlat {
+    MiniArena *arena;
+    uint32_t num_sections;
+    uint32_t num_keys;
+    MiniFlatSection *sections;
+    /* Keys, by position */
+    uint32_t *key_hashes;
+    uint32_t *key_lens;
+    uint32_t *value_lens;
+    const char **keys;
+    const char **values;
+    /* Open-addressing indexes of positions plus one (0 is empty) */
+    uint32_t *section_index;
+    uint32_t section_index_size;
+    uint32_t *key_index;
+};
+
+
+MiniFlat *mini_flat_new (MiniFile *mini_file);
+
+void mini_flat_free (MiniFlat *flat);
+
+uint32_t mini_flat_find_section (const MiniFlat *flat, const char *section,
+                                 size_t section_len);
+
+uint32_t mini_flat_find_key (const MiniFlat *flat, uint32_t section, 
+                             const char *key, size_t key_len);
+
+const char *mini_flat_get_value (const MiniFlat *flat, const char *section, 
+                                 const char *key);
+
+#endif /* __MINI_FLAT_H__ */
@@ -0,0 +1,683 @@
+/*
+ * mini-frozen.c
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mini-frozen.h"
+#include "mini-lazy.h"
+#include "mini-write.h"
+
+#define ALIGN8(n) (((n) + 7) & ~((uint64_t) 7))
+
+#define CHECKSUM_PRIME 0x9e3779b97f4a7c15ULL
+
+
+/**
+ *  Computes the checksum of a frozen image. The data is consumed 8 bytes 
+ *  at a time in four independent lanes, so big images are checked at 
+ *  memory speed.
+ *
+ *  @param data Bytes to be checked.
+ *  @param len Number of bytes.
+ *  @return The return value is the checksum.
+ */
+static uint64_t
+mini_frozen_checksum (const void *data, size_t len)
+{
+    const unsigned char *p = (const unsigned char *) data;
+    uint64_t lane[4] = { 1, 2, 3, 4 };
+    uint64_t word, sum;
+    size_t i, n;
+
+    n = len / 32;
+    for (i = 0; i < n; i++, p += 32) {
+        int j;
+
+        for (j = 0; j < 4; j++) {
+            memcpy (&word, &p[j * 8], sizeof (word));
+            lane[j] = (lane[j] ^ word) * CHECKSUM_PRIME;
+            lane[j] ^= lane[j] >> 29;
+        }
+    }
+
+    sum = mini_hash_update (MINI_HASH_INIT, p, len % 32);
+    for (i = 0; i < 4; i++)
+        sum = (sum ^ lane[i]) * CHECKSUM_PRIME;
+
+    return mini_hash_final (sum ^ len);
+}
+
+/**
+ *  Gets the size of an open-addressing index for the given number of 
+ *  entries (a power of two, at most half full).
+ *
+ *  @param num_entries Number of entries.
+ *  @return The return value is the number of slots.
+ */
+static uint32_t
+mini_frozen_index_size (uint32_t num_entries)
+{
+    uint32_t size;
+
+    if (num_entries == 0)
+        return 0;
+
+    for (size = 2; size < 2 * num_entries; size *= 2)
+        ;
+
+    return size;
+}
+
+/**
+ *  Adds an entry to an open-addressing index of a frozen image.
+ *
+ *  @param index The index.
+ *  @param index_size Number of slots of the index.
+ *  @param hash Hash of the entry.
+ *  @param entry Number of the entry.
+ */
+static void
+mini_frozen_index_insert (uint32_t *index, uint32_t index_size, uint64_t hash,
+                          uint32_t entry)
+{
+    uint32_t pos;
+
+    for (pos = (uint32_t) hash & (index_size - 1); index[pos] != 0; 
+         pos = (pos + 1) & (index_size - 1))
+        ;
+
+    index[pos] = entry + 1;
+}
+
+/**
+ *  Computes the layout of the frozen image of a MiniFile.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param header Header receiving the counts and the offsets of the image.
+ *  @return The return value is the size of the image.
+ */
+static uint64_t
+mini_frozen_layout (MiniFile *mini_file, MiniFrozenHeader *header)
+{
+    Section *sec;
+    SectionData *data;
+    uint64_t strings = 0;
+
+    memset (header, 0, sizeof (MiniFrozenHeader));
+
+    /* Sections not parsed yet have no keys to freeze */
+    mini_lazy_load_all (mini_file);
+
+    for (sec = mini_file->section; sec != NULL; sec = sec->next) {
+        header->num_sections++;
+        header->num_keys += sec->num_keys;
+        header->num_key_slots += mini_frozen_index_size (sec->num_keys);
+
+        strings += sec->name_len + 1;
+        for (data = sec->data; data != NULL; data = data->next)
+            strings += data->key_len + data->value_len + 2;
+    }
+
+    header->index_size = mini_frozen_index_size (header->num_sections);
+
+    header->sections_offset = ALIGN8 (sizeof (MiniFrozenHeader));
+    header->keys_offset = header->sections_offset + 
+        (uint64_t) header->num_sections * sizeof (MiniFrozenSection);
+    header->index_offset = header->keys_offset + 
+        (uint64_t) header->num_keys * sizeof (MiniFrozenKey);
+    header->key_index_offset = ALIGN8 (header->index_offset + 
+        (uint64_t) header->index_size * sizeof (uint32_t));
+    header->strings_offset = ALIGN8 (header->key_index_offset + 
+        (uint64_t) header->num_key_slots * sizeof (uint32_t));
+
+    return ALIGN8 (header->strings_offset + strings);
+}
+
+/**
+ *  Copies a string into the string table of a frozen image.
+ *
+ *  @param image The frozen image.
+ *  @param offset Offset of the free space of the string table, updated.
+ *  @param string String to be copied (not NUL terminated).
+ *  @param len Length of the string.
+ *  @return The return value is the offset of the copied string.
+ */
+static uint64_t
+mini_frozen_put_string (char *image, uint64_t *offset, const char *string, 
+                        size_t len)
+{
+    uint64_t ret = *offset;
+
+    memcpy (&image[ret], string, len);
+    image[ret + len] = '\0';
+    *offset += len + 1;
+
+    return ret;
+}
+
+/**
+ *  Checks that a string of a frozen image lies in its string table and is 
+ *  NUL terminated.
+ *
+ *  @param image A frozen image, with coherent tables.
+ *  @param offset Offset of the string.
+ *  @param len Length of the string.
+ *  @return The function returns a negative number, if the string is 
+ *          outside the string table.
+ */
+static int
+mini_frozen_check_string (const MiniFrozenHeader *image, uint64_t offset, 
+                          uint32_t len)
+{
+    if ((offset < image->strings_offset) || (offset >= image->size) || 
+        (len >= image->size - offset))
+        return -1;
+
+    return (((const char *) image)[offset + len] == '\0') ? 0 : -1;
+}
+
+/**
+ *  Checks an open-addressing index of a frozen image: every entry must 
+ *  be a valid entry number, and a slot must be empty so the probes end.
+ *
+ *  @param index The index.
+ *  @param index_size Number of slots of the index.
+ *  @param num_entries Number of entries the index may point to.
+ *  @return The function returns a negative number, if the index is 
+ *          corrupt.
+ */
+static int
+mini_frozen_check_index (const uint32_t *index, uint32_t index_size, 
+                         uint32_t num_entries)
+{
+    uint32_t i, used = 0;
+
+    for (i = 0; i < index_size; i++) {
+        if (index[i] > num_entries)
+            return -1;
+        if (index[i] != 0)
+            used++;
+    }
+
+    return ((index_size > 0) && (used == index_size)) ? -1 : 0;
+}
+
+/**
+ *  Writes a whole buffer to a file descriptor.
+ *
+ *  @param fd An opened file descriptor.
+ *  @param buffer Bytes to be written.
+ *  @param size Number of bytes.
+ *  @return The function returns a negative number, if the bytes can't 
+ *          be written.
+ */
+static int
+mini_frozen_write_all (int fd, const char *buffer, size_t size)
+{
+    ssize_t n;
+
+    while (size > 0) {
+        n = write (fd, buffer, size);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+
+        buffer += n;
+        size -= n;
+    }
+
+    return 0;
+}
+
+
+/**
+ *  Gets the size of the frozen image of a MiniFile.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @return The return value is the size of the image.
+ */
+size_t
+mini_frozen_get_size (MiniFile *mini_file)
+{
+    MiniFrozenHeader header;
+
+    /* MiniFile can't be NULL */
+    assert (mini_file != NULL);
+
+    if (mini_file->frozen != NULL)
+        return mini_file->frozen->size;
+
+    return mini_frozen_layout (mini_file, &header);
+}
+
+/**
+ *  Writes the frozen image of a MiniFile into a buffer: string table, 
+ *  section table, key tables and hash indexes, addressed by offsets.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param image Buffer receiving the image.
+ *  @param size Size of the buffer, see mini_frozen_get_size().
+ *  @return The function returns a negative number, if the buffer is too 
+ *          small.
+ */
+int
+mini_frozen_serialize (MiniFile *mini_file, void *image, size_t size)
+{
+    MiniFrozenHeader header;
+    MiniFrozenSection *sections;
+    MiniFrozenKey *keys;
+    uint32_t *index, *key_index;
+    uint64_t image_size, strings;
+    uint32_t i, k, slot;
+    char *base = (char *) image;
+    Section *sec;
+    SectionData *data;
+
+    /* MiniFile and image can't be NULL */
+    assert (mini_file != NULL);
+    assert (image != NULL);
+
+    /* A frozen MiniFile is its own image */
+    if (mini_file->frozen != NULL) {
+        if (size < mini_file->frozen->size)
+            return -1;
+
+        memcpy (image, mini_file->frozen, mini_file->frozen->size);
+        return 0;
+    }
+
+    image_size = mini_frozen_layout (mini_file, &header);
+    if (size < image_size)
+        return -1;
+
+    memset (base, 0, image_size);
+
+    sections = (MiniFrozenSection *) &base[header.sections_offset];
+    keys = (MiniFrozenKey *) &base[header.keys_offset];
+    index = (uint32_t *) &base[header.index_offset];
+    key_index = (uint32_t *) &base[header.key_index_offset];
+    strings = header.strings_offset;
+
+    for (sec = mini_file->section, i = 0, k = 0, slot = 0; sec != NULL; 
+         sec = sec->next, i++) {
+        MiniFrozenSection *s = &sections[i];
+
+        s->hash = sec->hash;
+        s->name = mini_frozen_put_string (base, &strings, sec->name, 
+                                          sec->name_len);
+        s->name_len = sec->name_len;
+        s->first_key = k;
+        s->num_keys = sec->num_keys;
+        s->index_first = slot;
+        s->index_size = mini_frozen_index_size (sec->num_keys);
+
+        for (data = sec->data; data != NULL; data = data->next, k++) {
+            keys[k].hash = data->hash;
+            keys[k].key = mini_frozen_put_string (base, &strings, data->key,
+                                                  data->key_len);
+            keys[k].key_len = data->key_len;
+            keys[k].value = mini_frozen_put_string (base, &strings, 
+                                                    data->value, 
+                                                    data->value_len);
+            keys[k].value_len = data->value_len;
+
+            /* Only the key found by a lookup is indexed */
+            if (mini_file_find_key (sec, data->key, data->key_len) == data)
+                mini_frozen_index_insert (&key_index[slot], s->index_size,
+                                          data->hash, k - s->first_key);
+        }
+
+        slot += s->index_size;
+
+        if (mini_file_find_section (mini_file, sec->name, sec->name_len) == sec)
+            mini_frozen_index_insert (index, header.index_size, sec->hash, i);
+    }
+
+    memcpy (header.magic, MINI_FROZEN_MAGIC, sizeof (header.magic));
+    header.version = MINI_FROZEN_VERSION;
+    header.header_size = sizeof (MiniFrozenHeader);
+    header.size = image_size;
+    memcpy (base, &header, sizeof (MiniFrozenHeader));
+
+    ((MiniFrozenHeader *) base)->checksum = 
+        mini_frozen_checksum (&base[sizeof (MiniFrozenHeader)], 
+                              image_size - sizeof (MiniFrozenHeader));
+
+    return 0;
+}
+
+/**
+ *  Checks that a buffer holds a valid frozen image: known version, 
+ *  coherent tables and right checksum. Images may come from other 
+ *  processes, so every string and index entry is checked too: no lookup 
+ *  of a checked image reads outside of it or probes forever.
+ *
+ *  @param image A frozen image.
+ *  @param size Size of the buffer.
+ *  @return The function returns a negative number, if the image is stale 
+ *          or corrupt.
+ */
+int
+mini_frozen_check (const void *image, size_t size)
+{
+    const MiniFrozenHeader *header = (const MiniFrozenHeader *) image;
+    const MiniFrozenSection *sections;
+    const MiniFrozenKey *keys;
+    const uint32_t *index, *key_index;
+    uint32_t i;
+
+    if ((image == NULL) || (size < sizeof (MiniFrozenHeader)))
+        return -1;
+
+    if ((memcmp (header->magic, MINI_FROZEN_MAGIC, sizeof (header->magic)) != 0)
+        || (header->version != MINI_FROZEN_VERSION) 
+        || (header->header_size != sizeof (MiniFrozenHeader))
+        || (header->size != size))
+        return -1;
+
+    /* Tables must be aligned, after the header and inside the image */
+    if ((header->sections_offset < header->header_size)
+        || (header->sections_offset % 8) || (header->keys_offset % 8)
+        || (header->index_offset % 4) || (header->key_index_offset % 4)
+        || (header->sections_offset > size) || (header->keys_offset > size)
+        || (header->index_offset > size) || (header->key_index_offset > size))
+        return -1;
+
+    if ((header->sections_offset + (uint64_t) header->num_sections * 
+         sizeof (MiniFrozenSection) > header->keys_offset) 
+        || (header->keys_offset + (uint64_t) header->num_keys * 
+            sizeof (MiniFrozenKey) > header->index_offset)
+        || (header->index_offset + (uint64_t) header->index_size * 
+            sizeof (uint32_t) > header->key_index_offset)
+        || (header->key_index_offset + (uint64_t) header->num_key_slots * 
+            sizeof (uint32_t) > header->strings_offset)
+        || (header->strings_offset > size) 
+        || (header->index_size & (header->index_size - 1)))
+        return -1;
+
+    if (mini_frozen_checksum ((const char *) image + sizeof (MiniFrozenHeader),
+                              size - sizeof (MiniFrozenHeader)) 
+        != header->checksum)
+        return -1;
+
+    sections = (const MiniFrozenSection *) 
+        ((const char *) image + header->sections_offset);
+    keys = (const MiniFrozenKey *) 
+        ((const char *) image + header->keys_offset);
+    index = (const uint32_t *) ((const char *) image + header->index_offset);
+    key_index = (const uint32_t *) 
+        ((const char *) image + header->key_index_offset);
+
+    if (mini_frozen_check_index (index, header->index_size, 
+                                 header->num_sections) < 0)
+        return -1;
+
+    for (i = 0; i < header->num_sections; i++)
+        if (((uint64_t) sections[i].first_key + sections[i].num_keys > 
+             header->num_keys)
+            || ((uint64_t) sections[i].index_first + sections[i].index_size > 
+                header->num_key_slots)
+            || (sections[i].index_size & (sections[i].index_size - 1))
+            || (mini_frozen_check_string (header, sections[i].name, 
+                                          sections[i].name_len) < 0)
+            || (mini_frozen_check_index (&key_index[sections[i].index_first],
+                                         sections[i].index_size, 
+                                         sections[i].num_keys) < 0))
+            return -1;
+
+    for (i = 0; i < header->num_keys; i++)
+        if ((mini_frozen_check_string (header, keys[i].key, 
+                                       keys[i].key_len) < 0)
+            || (mini_frozen_check_string (header, keys[i].value, 
+                                          keys[i].value_len) < 0))
+            return -1;
+
+    return 0;
+}
+
+/**
+ *  Searches for a section in a frozen image.
+ *
+ *  @param image A frozen image.
+ *  @param section A section name.
+ *  @param section_len Length of the section name.
+ *  @return The function returns NULL, if the given section can't be found.
+ */
+const MiniFrozenSection *
+mini_frozen_find_section (const MiniFrozenHeader *image, const char *section, 
+                          size_t section_len)
+{
+    const char *base = (const char *) image;
+    const MiniFrozenSection *sections, *sec;
+    const uint32_t *index;
+    uint64_t hash;
+    uint32_t pos, mask;
+
+    if (image->index_size == 0)
+        return NULL;
+
+    sections = (const MiniFrozenSection *) &base[image->sections_offset];
+    index = (const uint32_t *) &base[image->index_offset];
+    hash = mini_hash (section, section_len);
+    mask = image->index_size - 1;
+
+    for (pos = (uint32_t) hash & mask; index[pos] != 0; 
+         pos = (pos + 1) & mask) {
+        sec = &sections[index[pos] - 1];
+        if ((sec->hash == hash) && (sec->name_len == section_len) && 
+            (memcmp (&base[sec->name], section, section_len) == 0))
+            return sec;
+    }
+
+    return NULL;
+}
+
+/**
+ *  Searches for a key in a section of a frozen image.
+ *
+ *  @param image A frozen image.
+ *  @param section A section of the image.
+ *  @param key A key name.
+ *  @param key_len Length of the key name.
+ *  @return The function returns NULL, if the given key can't be found.
+ */
+const MiniFrozenKey *
+mini_frozen_find_key (const MiniFrozenHeader *image, 
+                      const MiniFrozenSection *section, const char *key, 
+                      size_t key_len)
+{
+    const char *base = (const char *) image;
+    const MiniFrozenKey *keys, *data;
+    const uint32_t *index;
+    uint64_t hash;
+    uint32_t pos, mask;
+
+    if (section->index_size == 0)
+        return NULL;
+
+    keys = (const MiniFrozenKey *) &base[image->keys_offset];
+    keys += section->first_key;
+    index = (const uint32_t *) &base[image->key_index_offset];
+    index += section->index_first;
+    hash = mini_hash (key, key_len);
+    mask = section->index_size - 1;
+
+    for (pos = (uint32_t) hash & mask; index[pos] != 0; 
+         pos = (pos + 1) & mask) {
+        data = &keys[index[pos] - 1];
+        if ((data->hash == hash) && (data->key_len == key_len) && 
+            (memcmp (&base[data->key], key, key_len) == 0))
+            return data;
+    }
+
+    return NULL;
+}
+
+/**
+ *  Writes the frozen image of a MiniFile into a file. The file is replaced 
+ *  atomically, so processes opening it never see a half written image, 
+ *  and it keeps its mode (see mini_write_open_temp()).
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param path Path of the image file.
+ *  @return The function returns a negative number, if the image can't 
+ *          be written.
+ */
+int
+mini_file_freeze (MiniFile *mini_file, const char *path)
+{
+    char *image, *tmp_path;
+    size_t size;
+    int fd, ret = -1;
+
+    /* MiniFile and path can't be NULL */
+    assert (mini_file != NULL);
+    assert (path != NULL);
+
+    size = mini_frozen_get_size (mini_file);
+    image = (char *) mini_malloc (NULL, size);
+    if (image == NULL)
+        return -1;
+
+    tmp_path = (char *) mini_malloc (NULL, strlen (path) + 
+                                     MINI_WRITE_TEMP_SUFFIX_SIZE);
+    if (tmp_path == NULL) {
+        mini_free (NULL, image);
+        return -1;
+    }
+
+    if (mini_frozen_serialize (mini_file, image, size) < 0)
+        goto out;
+
+    fd = mini_write_open_temp (path, tmp_path);
+    if (fd < 0)
+        goto out;
+
+    if ((mini_frozen_write_all (fd, image, size) < 0) || (fsync (fd) < 0)) {
+        close (fd);
+        unlink (tmp_path);
+        goto out;
+    }
+
+    if ((close (fd) < 0) || (rename (tmp_path, path) < 0)) {
+        unlink (tmp_path);
+        goto out;
+    }
+
+    ret = 0;
+    mini_write_sync_dir (tmp_path);
+
+out:
+    mini_free (NULL, tmp_path);
+    mini_free (NULL, image);
+
+    return ret;
+}
+
+/**
+ *  Opens a frozen image written by mini_file_freeze(). The image is mapped 
+ *  into memory and lookups are answered straight from the mapping, 
+ *  without parsing nor allocating.
+ *
+ *  The returned MiniFile can't be modified and it has no Section 
+ *  structures: use mini_file_get_value() and friends.
+ *
+ *  @param path Path of the image file.
+ *  @return The return value is a MiniFile structure backed by the image.
+ *          The function returns NULL, if the image can't be opened or it 
+ *          is stale or corrupt.
+ */
+MiniFile *
+mini_file_open_frozen (const char *path)
+{
+    struct stat st;
+    void *mapping;
+    int fd;
+
+    /* Path can't be NULL */
+    assert (path != NULL);
+
+    fd = open (path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    if ((fstat (fd, &st) < 0) || 
+        (st.st_size < (off_t) sizeof (MiniFrozenHeader))) {
+        close (fd);
+        return NULL;
+    }
+
+    mapping = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close (fd);
+    if (mapping == MAP_FAILED)
+        return NULL;
+
+    return mini_file_new_frozen (path, mapping, st.st_size);
+}
+
+/**
+ *  Creates a MiniFile backed by a frozen image already mapped into 
+ *  memory, as mini_file_open_frozen() does. The mapping is taken over: 
+ *  it's unmapped with the MiniFile, or at once if the image is wrong.
+ *
+ *  @param name Name of the new MiniFile.
+ *  @param mapping Mapping of the image, read-only.
+ *  @param size Size of the mapping.
+ *  @return The return value is a MiniFile structure backed by the image.
+ *          The function returns NULL, if the image is stale or corrupt, 
+ *          or the MiniFile can't be created.
+ */
+MiniFile *
+mini_file_new_frozen (const char *name, void *mapping, size_t size)
+{
+    MiniFile *mini_file;
+
+    /* Name and mapping can't be NULL */
+    assert (name != NULL);
+    assert (mapping != NULL);
+
+    if (mini_frozen_check (mapping, size) < 0) {
+        munmap (mapping, size);
+        return NULL;
+    }
+
+    mini_file = mini_file_new (name);
+    if (mini_file == NULL) {
+        munmap (mapping, size);
+        return NULL;
+    }
+
+    mini_file->mapping = mapping;
+    mini_file->mapping_size = size;
+    mini_file->frozen = (const MiniFrozenHeader *) mapping;
+    mini_file->num_sections = mini_file->frozen->num_sections;
+
+    return mini_file;
+}
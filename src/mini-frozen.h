@@ -0,0 +1,116 @@
+/*
+ * mini-frozen.h
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MINI_FROZEN_H__
+#define __MINI_FROZEN_H__
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mini-file.h"
+
+#define MINI_FROZEN_MAGIC "MINIFRZ"
+#define MINI_FROZEN_VERSION 1
+
+/* 
+ * A frozen image is position independent: every reference is an offset 
+ * from the start of the image. Strings are NUL terminated, indexes are 
+ * open-addressing tables of entry numbers plus one (zero is an empty slot).
+ * The image uses the byte order of the machine that froze it.
+ */
+struct _MiniFrozenHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t size;
+    uint64_t checksum;          /* of everything after the header */
+    uint32_t num_sections;
+    uint32_t num_keys;
+    uint32_t index_size;        /* slots of the section index */
+    uint32_t num_key_slots;     /* slots of all the key indexes */
+    uint64_t sections_offset;
+    uint64_t keys_offset;
+    uint64_t index_offset;
+    uint64_t key_index_offset;
+    uint64_t strings_offset;
+};
+
+typedef struct _MiniFrozenSection MiniFrozenSection;
+struct _MiniFrozenSection {
+    uint64_t hash;
+    uint64_t name;
+    uint32_t name_len;
+    uint32_t first_key;
+    uint32_t num_keys;
+    uint32_t index_first;       /* first slot in the key indexes */
+    uint32_t index_size;
+    uint32_t reserved;
+};
+
+typedef struct _MiniFrozenKey MiniFrozenKey;
+struct _MiniFrozenKey {
+    uint64_t hash;
+    uint64_t key;
+    uint64_t value;
+    uint32_t key_len;
+    uint32_t value_len;
+};
+
+
+size_t mini_frozen_get_size (MiniFile *mini_file);
+
+int mini_frozen_serialize (MiniFile *mini_file, void *image, size_t size);
+
+int mini_frozen_check (const void *image, size_t size);
+
+const MiniFrozenSection *mini_frozen_find_section (
+                                            const MiniFrozenHeader *image,
+                                            const char *section, 
+                                            size_t section_len);
+
+const MiniFrozenKey *mini_frozen_find_key (const MiniFrozenHeader *image,
+                                           const MiniFrozenSection *section,
+                                           const char *key, size_t key_len);
+
+int mini_file_freeze (MiniFile *mini_file, const char *path);
+
+MiniFile *mini_file_open_frozen (const char *path);
+
+MiniFile *mini_file_new_frozen (const char *name, void *mapping, size_t size);
+
+#endif /* __MINI_FROZEN_H__ */
@@ -0,0 +1,138 @@
+/*
+ * mini-handle.c
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mini-handle.h"
+
+
+/**
+ *  Resolves a section's key, so that its value can be read many times 
+ *  without searching it again. The section and the key don't need to 
+ *  exist: the handle reads NULL then.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param section A section name.
+ *  @param key A key name.
+ *  @return The return value is the new MiniKeyHandle structure.
+ *          The function returns NULL, if the handle can't be created.
+ */
+MiniKeyHandle *
+mini_file_resolve (MiniFile *mini_file, const char *section, const char *key)
+{
+    MiniKeyHandle *handle;
+    size_t section_len, key_len;
+
+    /* MiniFile, section and key can't be NULL */
+    assert (mini_file != NULL);
+    assert (section != NULL);
+    assert (key != NULL);
+
+    section_len = strlen (section);
+    key_len = strlen (key);
+
+    /* The names are kept after the handle, to resolve them again */
+    handle = (MiniKeyHandle *) mini_malloc (NULL, sizeof (MiniKeyHandle) + 
+                                            section_len + key_len + 2);
+    if (handle == NULL)
+        return NULL;
+
+    handle->section = (char *) &handle[1];
+    handle->key = handle->section + section_len + 1;
+    memcpy (handle->section, section, section_len + 1);
+    memcpy (handle->key, key, key_len + 1);
+
+    handle->mini_file = mini_file;
+    handle->generation = mini_file->generation;
+    handle->value = mini_file_get_value (mini_file, section, key);
+
+    return handle;
+}
+
+/**
+ *  Frees a MiniKeyHandle structure.
+ *
+ *  @param handle A MiniKeyHandle structure.
+ */
+void
+mini_handle_free (MiniKeyHandle *handle)
+{
+    mini_free (NULL, handle);
+}
+
+/**
+ *  Reads the value of a resolved section's key from the MiniFile it was 
+ *  resolved with, which must still exist. If the MiniFile was modified 
+ *  (by a watch, for example), the key is resolved again.
+ *
+ *  @param handle A MiniKeyHandle structure.
+ *  @return The return value is the value of the section's key.
+ *          The function returns NULL, if the given section or the given 
+ *          key doesn't exist.
+ */
+char *
+mini_handle_get_value (MiniKeyHandle *handle)
+{
+    /* Handle can't be NULL */
+    assert (handle != NULL);
+
+    return mini_handle_get_value_from (handle, handle->mini_file);
+}
+
+/**
+ *  Reads the value of a resolved section's key from a given MiniFile, as 
+ *  the current snapshot of a MiniConfigHandle. The cached value is used 
+ *  while the MiniFile has the generation of the last resolution; as 
+ *  generations are unique, another MiniFile (even at the address of a 
+ *  freed one) or a modified one resolves the key again. The MiniFile the 
+ *  handle was resolved with is never accessed, so it may have been freed.
+ *
+ *  A handle must be used by a single thread at a time.
+ *
+ *  @param handle A MiniKeyHandle structure.
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @return The return value is the value of the section's key.
+ *          The function returns NULL, if the given section or the given 
+ *          key doesn't exist.
+ */
+char *
+mini_handle_get_value_from (MiniKeyHandle *handle, MiniFile *mini_file)
+{
+    /* Handle and MiniFile can't be NULL */
+    assert (handle != NULL);
+    assert (mini_file != NULL);
+
+    if (handle->generation != mini_file->generation) {
+        handle->mini_file = mini_file;
+        handle->generation = mini_file->generation;
+        handle->value = mini_file_get_value (mini_file, handle->section, 
+                                             handle->key);
+    }
+
+    return handle->value;
+}
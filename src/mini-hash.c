@@ -0,0 +1,88 @@
+/*
+ * mini-hash.c
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mini-hash.h"
+
+#define FNV_PRIME 0x100000001b3ULL
+
+
+/**
+ *  Feeds some bytes into a running hash (64-bit FNV-1a).
+ *
+ *  @param hash The running hash, MINI_HASH_INIT for a new hash.
+ *  @param data Bytes to be hashed.
+ *  @param len Number of bytes to be hashed.
+ *  @return The return value is the updated running hash.
+ */
+uint64_t
+mini_hash_update (uint64_t hash, const void *data, size_t len)
+{
+    const unsigned char *p = (const unsigned char *) data;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+/**
+ *  Finishes a running hash, mixing its bits so that the low bits can be 
+ *  used directly as a table index.
+ *
+ *  @param hash The running hash.
+ *  @return The return value is the final hash.
+ */
+uint64_t
+mini_hash_final (uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+/**
+ *  Hashes some bytes.
+ *
+ *  @param data Bytes to be hashed.
+ *  @param len Number of bytes to be hashed.
+ *  @return The return value is the hash of the given bytes.
+ */
+uint64_t
+mini_hash (const void *data, size_t len)
+{
+    return mini_hash_final (mini_hash_update (MINI_HASH_INIT, data, len));
+}
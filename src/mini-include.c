@@ -0,0 +1,523 @@
+/*
+ * mini-include.c
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mini-include.h"
+
+/* State of the parse of a fragment */
+typedef struct _MiniFragmentParse MiniFragmentParse;
+struct _MiniFragmentParse {
+    MiniFragment *fragment;
+    /* An item couldn't be allocated */
+    int failed;
+};
+
+/* Fragments by canonical path, each one holding a reference */
+static MiniFragment *mini_include_cache[MINI_INCLUDE_CACHE_SIZE];
+static pthread_mutex_t mini_include_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/**
+ *  Releases a reference to a fragment, freeing it with the last one.
+ *
+ *  @param fragment A fragment.
+ */
+static void
+mini_fragment_unref (MiniFragment *fragment)
+{
+    if (atomic_fetch_sub (&fragment->refcount, 1) == 1)
+        mini_arena_free (fragment->arena);
+}
+
+/**
+ *  Adds an item to a fragment, growing its array in the arena.
+ *
+ *  @param fragment A fragment.
+ *  @param kind Kind of the item.
+ *  @param name Section name, key or included path.
+ *  @param name_len Length of the name.
+ *  @param lineno Line of the item in the fragment.
+ *  @return The return value is the new item, with a copy of the name.
+ *          The function returns NULL, if it can't be allocated.
+ */
+static MiniFragmentItem *
+mini_fragment_add_item (MiniFragment *fragment, int kind, const char *name,
+                        size_t name_len, int lineno)
+{
+    MiniFragmentItem *items, *item;
+    unsigned int size;
+
+    if (fragment->num_items == fragment->items_size) {
+        size = (fragment->items_size > 0) ? 2 * fragment->items_size : 
+                                            MINI_INDEX_MIN_SIZE;
+        items = (MiniFragmentItem *) 
+                mini_arena_alloc (fragment->arena, 
+                                  size * sizeof (MiniFragmentItem));
+        if (items == NULL)
+            return NULL;
+
+        if (fragment->num_items > 0)
+            memcpy (items, fragment->items, 
+                    fragment->num_items * sizeof (MiniFragmentItem));
+
+        fragment->items = items;
+        fragment->items_size = size;
+    }
+
+    item = &fragment->items[fragment->num_items];
+    item->name = mini_arena_strndup (fragment->arena, name, name_len);
+    if (item->name == NULL)
+        return NULL;
+
+    item->kind = kind;
+    item->lineno = lineno;
+    item->name_len = name_len;
+    item->value = NULL;
+    item->value_len = 0;
+    fragment->num_items++;
+
+    return item;
+}
+
+/**
+ *  Callback tokenizing a fragment: adds a section.
+ */
+static int
+mini_fragment_section (const char *name, size_t name_len, int lineno, 
+                       void *user_data)
+{
+    MiniFragmentParse *parse = (MiniFragmentParse *) user_data;
+
+    if (mini_fragment_add_item (parse->fragment, MINI_FRAGMENT_SECTION, name,
+                                name_len, lineno) == NULL) {
+        parse->failed = 1;
+        return MINI_PARSE_STOPPED;
+    }
+
+    return 0;
+}
+
+/**
+ *  Callback tokenizing a fragment: adds a key-value pair.
+ */
+static int
+mini_fragment_key_value (const char *key, size_t key_len, const char *value,
+                         size_t value_len, int lineno, void *user_data)
+{
+    MiniFragmentParse *parse = (MiniFragmentParse *) user_data;
+    MiniFragmentItem *item;
+
+    item = mini_fragment_add_item (parse->fragment, MINI_FRAGMENT_KEY, key, 
+                                   key_len, lineno);
+    if (item != NULL) {
+        item->value = mini_arena_strndup (parse->fragment->arena, value, 
+                                          value_len);
+        item->value_len = value_len;
+    }
+
+    if ((item == NULL) || (item->value == NULL)) {
+        parse->failed = 1;
+        return MINI_PARSE_STOPPED;
+    }
+
+    return 0;
+}
+
+/**
+ *  Callback tokenizing a fragment: adds an include directive, resolved 
+ *  when the fragment is included.
+ */
+static int
+mini_fragment_include (const char *path, size_t path_len, int lineno, 
+                       void *user_data)
+{
+    MiniFragmentParse *parse = (MiniFragmentParse *) user_data;
+
+    if (mini_fragment_add_item (parse->fragment, MINI_FRAGMENT_INCLUDE, path,
+                                path_len, lineno) == NULL) {
+        parse->failed = 1;
+        return MINI_PARSE_STOPPED;
+    }
+
+    return 0;
+}
+
+/**
+ *  Callback tokenizing a fragment: remembers its first wrong line, where 
+ *  the parse stops as mini_parse_file() does.
+ */
+static int
+mini_fragment_error (const char *line, size_t line_len, int lineno, 
+                     void *user_data)
+{
+    MiniFragmentParse *parse = (MiniFragmentParse *) user_data;
+
+    parse->fragment->error_lineno = lineno;
+
+    return MINI_PARSE_STOPPED;
+}
+
+static const MiniParseCallbacks mini_fragment_callbacks = {
+    mini_fragment_section,
+    mini_fragment_key_value,
+    NULL,
+    mini_fragment_error,
+    mini_fragment_include
+};
+
+/**
+ *  Reads and tokenizes a file into a new fragment.
+ *
+ *  @param path Canonical path of the file.
+ *  @param st Status of the file.
+ *  @return The return value is the new fragment, with a reference.
+ *          The function returns NULL, if the file can't be read.
+ */
+static MiniFragment *
+mini_fragment_new (const char *path, const struct stat *st)
+{
+    MiniFragmentParse parse;
+    MiniFragment *fragment;
+    MiniReader *reader;
+    MiniArena *arena;
+    int result;
+
+    arena = mini_arena_new (NULL);
+    if (arena == NULL)
+        return NULL;
+
+    fragment = (MiniFragment *) mini_arena_alloc (arena, sizeof (MiniFragment));
+    if (fragment == NULL) {
+        mini_arena_free (arena);
+        return NULL;
+    }
+
+    fragment->path = mini_arena_strdup (arena, path);
+    fragment->mtime = st->st_mtim;
+    fragment->size = st->st_size;
+    fragment->arena = arena;
+    fragment->items = NULL;
+    fragment->num_items = 0;
+    fragment->items_size = 0;
+    fragment->error_lineno = 0;
+    atomic_init (&fragment->refcount, 1);
+    fragment->next = NULL;
+
+    reader = mini_reader_open (path);
+    if ((fragment->path == NULL) || (reader == NULL)) {
+        mini_reader_free (reader);
+        mini_arena_free (arena);
+        return NULL;
+    }
+
+    parse.fragment = fragment;
+    parse.failed = 0;
+    result = mini_parse_stream (reader, &mini_fragment_callbacks, &parse);
+    mini_reader_free (reader);
+
+    /* Read errors aren't wrong lines, they aren't cached */
+    if (parse.failed || 
+        ((result == MINI_PARSE_ERROR) && (fragment->error_lineno == 0))) {
+        mini_arena_free (arena);
+        return NULL;
+    }
+
+    return fragment;
+}
+
+/**
+ *  Gets the fragment of a file from the cache, reading it if it isn't 
+ *  there or if the file has changed. The lock is held while the file is 
+ *  read, so every version of a file is tokenized once.
+ *
+ *  @param path Canonical path of the file.
+ *  @return The return value is the fragment, with a new reference.
+ *          The function returns NULL, if the file can't be read.
+ */
+static MiniFragment *
+mini_fragment_get (const char *path)
+{
+    MiniFragment *fragment, **prev;
+    struct stat st;
+    unsigned int bucket;
+
+    if (stat (path, &st) < 0)
+        return NULL;
+
+    bucket = mini_hash (path, strlen (path)) % MINI_INCLUDE_CACHE_SIZE;
+
+    pthread_mutex_lock (&mini_include_lock);
+
+    for (prev = &mini_include_cache[bucket]; *prev != NULL; 
+         prev = &(*prev)->next) {
+        fragment = *prev;
+        if (strcmp (fragment->path, path) != 0)
+            continue;
+
+        if ((fragment->size == st.st_size) && 
+            (fragment->mtime.tv_sec == st.st_mtim.tv_sec) &&
+            (fragment->mtime.tv_nsec == st.st_mtim.tv_nsec)) {
+            atomic_fetch_add (&fragment->refcount, 1);
+            pthread_mutex_unlock (&mini_include_lock);
+            return fragment;
+        }
+
+        /* Stale, the MiniFiles including it keep their references */
+        *prev = fragment->next;
+        mini_fragment_unref (fragment);
+        break;
+    }
+
+    fragment = mini_fragment_new (path, &st);
+    if (fragment != NULL) {
+        atomic_fetch_add (&fragment->refcount, 1);
+        fragment->next = mini_include_cache[bucket];
+        mini_include_cache[bucket] = fragment;
+    }
+
+    pthread_mutex_unlock (&mini_include_lock);
+
+    return fragment;
+}
+
+/**
+ *  Adds the items of a fragment to a MiniFile, borrowing their strings: 
+ *  they are NUL terminated and immutable, so lookups don't copy them.
+ *
+ *  @param mini_file A MiniFile structure.
+ *  @param fragment The fragment, referenced by the MiniFile.
+ *  @param node The fragment in the stack of included files.
+ *  @return The function returns a negative number, if an item can't be 
+ *          added or the fragment has a wrong line.
+ */
+static int
+mini_fragment_replay (MiniFile *mini_file, const MiniFragment *fragment, 
+                      const MiniIncludeStack *node)
+{
+    const MiniFragmentItem *item;
+    SectionData *data;
+    unsigned int i;
+
+    for (i = 0; i < fragment->num_items; i++) {
+        item = &fragment->items[i];
+
+        switch (item->kind) {
+            case MINI_FRAGMENT_SECTION:
+                if (mini_file_add_section (mini_file, item->name, 
+                                           item->name_len, 
+                                           MINI_BORROW_STABLE) == NULL)
+                    return -1;
+                break;
+
+            case MINI_FRAGMENT_KEY:
+                data = mini_file_add_key_and_value (mini_file, item->name, 
+                                                    item->name_len, 
+                                                    item->value, 
+                                                    item->value_len, 
+                                                    MINI_BORROW_STABLE);
+                if (data == NULL) {
+                    fprintf (stderr, "parse error at line %d in %s\n", 
+                             item->lineno, node->name);
+                    return -1;
+                }
+
+                data->lineno = item->lineno;
+                data->file_name = fragment->path;
+                break;
+
+            default:
+                if (mini_include (mini_file, node, item->name, 
+                                  item->name_len) < 0)
+                    return -1;
+        }
+    }
+
+    if (fragment->error_lineno != 0) {
+        fprintf (stderr, "parse error at line %d in %s\n", 
+                 fragment->error_lineno, node->name);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/**
+ *  Initializes the stack of included files with the file being parsed.
+ *
+ *  @param stack The stack.
+ *  @param file_name Path of the file being parsed, it must outlive the 
+ *         stack.
+ */
+void
+mini_include_stack_init (MiniIncludeStack *stack, const char *file_name)
+{
+    /* Stack and filename can't be NULL */
+    assert (stack != NULL);
+    assert (file_name != NULL);
+
+    stack->name = file_name;
+    stack->parent = NULL;
+    stack->depth = 0;
+
+    if (realpath (file_name, stack->path) == NULL)
+        stack->path[0] = '\0';
+}
+
+/**
+ *  Includes a file in a MiniFile: its sections and keys are added after 
+ *  the current ones, as if its lines were written in place of the include 
+ *  directive (keys before its first section belong to the current one).
+ *
+ *  The file is read and tokenized once while it isn't modified: its 
+ *  fragment is kept in a process-wide cache and shared, read-only, by 
+ *  all the MiniFiles including it, which borrow its strings and hold a 
+ *  reference until they are freed.
+ *
+ *  @param mini_file A MiniFile structure.
+ *  @param stack Files being included, the innermost one first.
+ *  @param path Path of the included file, relative to the directory of 
+ *         the innermost file unless it's absolute.
+ *  @param path_len Length of the path.
+ *  @return The function returns a negative number, if the file can't be 
+ *          read or parsed, or if it's already being included.
+ */
+int
+mini_include (MiniFile *mini_file, const MiniIncludeStack *stack, 
+              const char *path, size_t path_len)
+{
+    char joined[PATH_MAX];
+    MiniIncludeStack node;
+    const MiniIncludeStack *s;
+    MiniFragmentRef *ref;
+    MiniFragment *fragment;
+    const char *slash;
+    size_t dir_len = 0;
+
+    /* MiniFile, stack and path can't be NULL */
+    assert (mini_file != NULL);
+    assert (stack != NULL);
+    assert (path != NULL);
+
+    if (stack->depth >= MINI_INCLUDE_MAX_DEPTH) {
+        fprintf (stderr, "too many nested includes in %s\n", stack->name);
+        return -1;
+    }
+
+    /* Relative paths start at the directory of the including file */
+    slash = strrchr (stack->name, '/');
+    if ((path[0] != '/') && (slash != NULL))
+        dir_len = slash - stack->name + 1;
+
+    if (dir_len + path_len >= PATH_MAX) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    memcpy (joined, stack->name, dir_len);
+    memcpy (&joined[dir_len], path, path_len);
+    joined[dir_len + path_len] = '\0';
+
+    if (realpath (joined, node.path) == NULL) {
+        fprintf (stderr, "can't include %s\n", joined);
+        return -1;
+    }
+
+    for (s = stack; s != NULL; s = s->parent)
+        if (strcmp (s->path, node.path) == 0) {
+            fprintf (stderr, "include cycle at %s\n", joined);
+            return -1;
+        }
+
+    node.name = joined;
+    node.parent = stack;
+    node.depth = stack->depth + 1;
+
+    ref = (MiniFragmentRef *) mini_arena_alloc (mini_file->arena, 
+                                                sizeof (MiniFragmentRef));
+    if (ref == NULL)
+        return -1;
+
+    fragment = mini_fragment_get (node.path);
+    if (fragment == NULL) {
+        fprintf (stderr, "can't include %s\n", joined);
+        return -1;
+    }
+
+    /* Released with the MiniFile, even if the include fails */
+    ref->fragment = fragment;
+    ref->next = mini_file->fragments;
+    mini_file->fragments = ref;
+
+    return mini_fragment_replay (mini_file, fragment, &node);
+}
+
+/**
+ *  Releases the fragments included by a MiniFile, see mini_file_free().
+ *
+ *  @param mini_file A MiniFile structure.
+ */
+void
+mini_include_release (MiniFile *mini_file)
+{
+    MiniFragmentRef *ref;
+
+    /* MiniFile can't be NULL */
+    assert (mini_file != NULL);
+
+    for (ref = mini_file->fragments; ref != NULL; ref = ref->next)
+        mini_fragment_unref (ref->fragment);
+
+    mini_file->fragments = NULL;
+}
+
+/**
+ *  Empties the cache of included files. The fragments still included by 
+ *  a MiniFile are freed with it.
+ */
+void
+mini_include_cache_clear (void)
+{
+    MiniFragment *fragment, *next;
+    unsigned int i;
+
+    pthread_mutex_lock (&mini_include_lock);
+
+    for (i = 0; i < MINI_INCLUDE_CACHE_SIZE; i++) {
+        for (fragment = mini_include_cache[i]; fragment != NULL; 
+             fragment = next) {
+            next = fragment->next;
+            mini_fragment_unref (fragment);
+        }
+
+        mini_include_cache[i] = NULL;
+    }
+
+    pthread_mutex_unlock (&mini_include_lock);
+}
@@ -0,0 +1,119 @@
+/*
+ * mini-include.h
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MINI_INCLUDE_H__
+#define __MINI_INCLUDE_H__
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "mini-file.h"
+#include "mini-parser.h"
+
+/* Buckets of the cache of fragments */
+#define MINI_INCLUDE_CACHE_SIZE 64
+/* Deepest nesting of included files */
+#define MINI_INCLUDE_MAX_DEPTH 32
+
+/* Kinds of the items of a fragment */
+#define MINI_FRAGMENT_SECTION 0
+#define MINI_FRAGMENT_KEY 1
+#define MINI_FRAGMENT_INCLUDE 2
+
+/* A section, a key-value pair or an include directive of a fragment */
+typedef struct _MiniFragmentItem MiniFragmentItem;
+struct _MiniFragmentItem {
+    int kind;
+    int lineno;
+    /* Section name, key or included path */
+    const char *name;
+    size_t name_len;
+    const char *value;
+    size_t value_len;
+};
+
+/* 
+ * A file included with "!include path", read and tokenized once: its 
+ * items are replayed into every MiniFile including it, which borrow the 
+ * strings and hold a reference. The process-wide cache keeps a fragment 
+ * while its file keeps the same modification time and size.
+ */
+struct _MiniFragment {
+    /* Canonical path of the file, the key of the cache */
+    char *path;
+    struct timespec mtime;
+    off_t size;
+    /* Arena holding the fragment, its items and its strings */
+    MiniArena *arena;
+    MiniFragmentItem *items;
+    unsigned int num_items;
+    unsigned int items_size;
+    /* First wrong line of the file (0 if none) */
+    int error_lineno;
+    atomic_uint refcount;
+    /* Next fragment of the same bucket of the cache */
+    MiniFragment *next;
+};
+
+/* A fragment included by a MiniFile */
+struct _MiniFragmentRef {
+    MiniFragment *fragment;
+    MiniFragmentRef *next;
+};
+
+/* Files being included, from the innermost one, to detect cycles */
+typedef struct _MiniIncludeStack MiniIncludeStack;
+struct _MiniIncludeStack {
+    /* Path as given, relative includes are resolved from its directory */
+    const char *name;
+    /* Canonical path, empty if unknown */
+    char path[PATH_MAX];
+    const MiniIncludeStack *parent;
+    int depth;
+};
+
+
+void mini_include_stack_init (MiniIncludeStack *stack, const char *file_name);
+
+int mini_include (MiniFile *mini_file, const MiniIncludeStack *stack, 
+                  const char *path, size_t path_len);
+
+void mini_include_release (MiniFile *mini_file);
+
+void mini_include_cache_clear (void);
+
+#endif /* __MINI_INCLUDE_H__ */
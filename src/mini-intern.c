@@ -0,0 +1,307 @@
+/*
+ * mini-intern.c
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mini-intern.h"
+
+/* Interned string of a string returned by mini_intern() */
+#define MINI_INTERNED(str) \
+    ((const MiniInterned *) ((str) - offsetof (MiniInterned, string)))
+
+
+/**
+ *  Doubles the size of the index of an intern table (or creates it).
+ *
+ *  @param table A MiniInternTable structure.
+ *  @return The function returns a negative number, if the index can't 
+ *          be grown.
+ */
+static int
+mini_intern_grow (MiniInternTable *table)
+{
+    MiniInterned **index;
+    unsigned int size, mask, i, pos;
+
+    size = (table->index_size == 0) ? MINI_INTERN_MIN_SIZE : 
+                                      table->index_size * 2;
+    mask = size - 1;
+
+    index = (MiniInterned **) mini_calloc (&table->arena->allocator, size, 
+                                           sizeof (MiniInterned *));
+    if (index == NULL)
+        return -1;
+
+    for (i = 0; i < table->index_size; i++) {
+        if (table->index[i] == NULL)
+            continue;
+
+        for (pos = (unsigned int) table->index[i]->hash & mask; 
+             index[pos] != NULL; pos = (pos + 1) & mask)
+            ;
+
+        index[pos] = table->index[i];
+    }
+
+    mini_free (&table->arena->allocator, table->index);
+    table->index = index;
+    table->index_size = size;
+
+    return 0;
+}
+
+/**
+ *  Interns a string in a table, without locking it.
+ *
+ *  @param table A MiniInternTable structure.
+ *  @param string String to be interned.
+ *  @param len Length of the string.
+ *  @return The return value is the interned string.
+ *          The function returns NULL, if the string can't be interned.
+ */
+static const char *
+mini_intern_locked (MiniInternTable *table, const char *string, size_t len)
+{
+    MiniInterned *interned;
+    unsigned int mask, pos;
+    uint64_t hash;
+
+    /* Keep the load factor under 1/2 */
+    if (2 * (table->num_strings + 1) > table->index_size)
+        if (mini_intern_grow (table) < 0)
+            return NULL;
+
+    hash = mini_hash (string, len);
+    mask = table->index_size - 1;
+
+    for (pos = (unsigned int) hash & mask; table->index[pos] != NULL; 
+         pos = (pos + 1) & mask) {
+        interned = table->index[pos];
+        if ((interned->hash == hash) && (interned->len == len) && 
+            (memcmp (interned->string, string, len) == 0))
+            return interned->string;
+    }
+
+    interned = (MiniInterned *) mini_arena_alloc (table->arena, 
+                                                  sizeof (MiniInterned) + 
+                                                  len + 1);
+    if (interned == NULL)
+        return NULL;
+
+    interned->hash = hash;
+    interned->len = len;
+    memcpy (interned->string, string, len);
+    interned->string[len] = '\0';
+
+    table->index[pos] = interned;
+    table->num_strings++;
+
+    return interned->string;
+}
+
+
+/**
+ *  Creates a new intern table. Every MiniFile interns its section names 
+ *  and keys in a table of its own, unless it's given a shared one (see 
+ *  mini_file_set_intern_table()).
+ *
+ *  @param shared Non-zero if the table is used from many threads, then 
+ *         it's locked.
+ *  @return The return value is the new MiniInternTable structure, with 
+ *          one reference.
+ *          The function returns NULL, if the table can't be created.
+ */
+MiniInternTable *
+mini_intern_table_new (int shared)
+{
+    return mini_intern_table_new_with_allocator (shared, NULL);
+}
+
+/**
+ *  Creates a new intern table, as mini_intern_table_new() does, whose 
+ *  memory comes from the given allocator.
+ *
+ *  @param shared Non-zero if the table is used from many threads, then 
+ *         it's locked.
+ *  @param allocator A MiniAllocator structure, which is copied, or NULL 
+ *         for the allocator of the library.
+ *  @return The return value is the new MiniInternTable structure, with 
+ *          one reference.
+ *          The function returns NULL, if the table can't be created.
+ */
+MiniInternTable *
+mini_intern_table_new_with_allocator (int shared, 
+                                      const MiniAllocator *allocator)
+{
+    MiniInternTable *table;
+    MiniArena *arena;
+
+    arena = mini_arena_new (allocator);
+    if (arena == NULL)
+        return NULL;
+
+    table = (MiniInternTable *) mini_malloc (&arena->allocator, 
+                                             sizeof (MiniInternTable));
+    if (table == NULL) {
+        mini_arena_free (arena);
+        return NULL;
+    }
+
+    table->arena = arena;
+
+    table->index = NULL;
+    table->index_size = 0;
+    table->num_strings = 0;
+    table->refs = 1;
+    table->shared = shared;
+    if (shared)
+        pthread_mutex_init (&table->lock, NULL);
+
+    return table;
+}
+
+/**
+ *  Adds a reference to an intern table.
+ *
+ *  @param table A MiniInternTable structure.
+ *  @return The return value is the table.
+ */
+MiniInternTable *
+mini_intern_table_ref (MiniInternTable *table)
+{
+    /* Table can't be NULL */
+    assert (table != NULL);
+
+    if (table->shared)
+        pthread_mutex_lock (&table->lock);
+
+    table->refs++;
+
+    if (table->shared)
+        pthread_mutex_unlock (&table->lock);
+
+    return table;
+}
+
+/**
+ *  Removes a reference from an intern table, freeing it with all its 
+ *  strings when it was the last one.
+ *
+ *  @param table A MiniInternTable structure.
+ */
+void
+mini_intern_table_unref (MiniInternTable *table)
+{
+    MiniArena *arena;
+    unsigned int refs;
+
+    /* Do nothing with NULL pointers */
+    if (table == NULL)
+        return;
+
+    if (table->shared)
+        pthread_mutex_lock (&table->lock);
+
+    refs = --table->refs;
+
+    if (table->shared)
+        pthread_mutex_unlock (&table->lock);
+
+    if (refs > 0)
+        return;
+
+    if (table->shared)
+        pthread_mutex_destroy (&table->lock);
+
+    arena = table->arena;
+    mini_free (&arena->allocator, table->index);
+    mini_free (&arena->allocator, table);
+    mini_arena_free (arena);
+}
+
+/**
+ *  Interns a string: equal strings interned in the same table give the 
+ *  same pointer, so they are compared by pointer. Callers can intern 
+ *  their lookup keys once, see mini_file_find_interned_key().
+ *
+ *  @param table A MiniInternTable structure.
+ *  @param string String to be interned, it doesn't need to be NUL 
+ *         terminated.
+ *  @param len Length of the string.
+ *  @return The return value is the interned string, NUL terminated and 
+ *          valid as long as the table.
+ *          The function returns NULL, if the string can't be interned.
+ */
+const char *
+mini_intern (MiniInternTable *table, const char *string, size_t len)
+{
+    const char *interned;
+
+    /* Table and string can't be NULL */
+    assert (table != NULL);
+    assert (string != NULL);
+
+    if (!table->shared)
+        return mini_intern_locked (table, string, len);
+
+    pthread_mutex_lock (&table->lock);
+    interned = mini_intern_locked (table, string, len);
+    pthread_mutex_unlock (&table->lock);
+
+    return interned;
+}
+
+/**
+ *  Gets the hash of an interned string, the one mini_hash() gives.
+ *
+ *  @param interned A string returned by mini_intern().
+ *  @return The return value is the hash.
+ */
+uint64_t
+mini_intern_get_hash (const char *interned)
+{
+    /* String can't be NULL */
+    assert (interned != NULL);
+
+    return MINI_INTERNED (interned)->hash;
+}
+
+/**
+ *  Gets the length of an interned string.
+ *
+ *  @param interned A string returned by mini_intern().
+ *  @return The return value is the length.
+ */
+size_t
+mini_intern_get_len (const char *interned)
+{
+    /* String can't be NULL */
+    assert (interned != NULL);
+
+    return MINI_INTERNED (interned)->len;
+}
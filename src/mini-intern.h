@@ -0,0 +1,87 @@
+/*
+ * mini-intern.h
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MINI_INTERN_H__
+#define __MINI_INTERN_H__
+
+#include <assert.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mini-arena.h"
+#include "mini-hash.h"
+
+#define MINI_INTERN_MIN_SIZE 64
+
+/* Interned string, the string is what mini_intern() returns */
+typedef struct _MiniInterned MiniInterned;
+struct _MiniInterned {
+    uint64_t hash;
+    size_t len;
+    char string[];
+};
+
+/* 
+ * Set of strings stored once: interning equal strings gives the same 
+ * pointer. Shared tables can be used by many MiniFiles, from many threads.
+ */
+typedef struct _MiniInternTable MiniInternTable;
+struct _MiniInternTable {
+    MiniArena *arena;
+    /* Open-addressing index of the strings */
+    MiniInterned **index;
+    unsigned int index_size;
+    unsigned int num_strings;
+    unsigned int refs;
+    int shared;
+    pthread_mutex_t lock;
+};
+
+
+MiniInternTable *mini_intern_table_new (int shared);
+
+MiniInternTable *mini_intern_table_new_with_allocator (int shared, 
+    const MiniAllocator *allocator);
+
+MiniInternTable *mini_intern_table_ref (MiniInternTable *table);
+
+void mini_intern_table_unref (MiniInternTable *table);
+
+const char *mini_intern (MiniInternTable *table, const char *string, 
+                         size_t len);
+
+uint64_t mini_intern_get_hash (const char *interned);
+
+size_t mini_intern_get_len (const char *interned);
+
+#endif /* __MINI_INTERN_H__ */
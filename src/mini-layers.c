@@ -0,0 +1,637 @@
+/*
+ * mini-layers.c
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mini-layers.h"
+
+
+/**
+ *  Hashes the section name of a pair, the start of the hashes of its keys.
+ */
+static uint64_t
+mini_layers_hash_section (const char *section, size_t section_len)
+{
+    return mini_hash_update (mini_hash_update (MINI_HASH_INIT, section, 
+                                               section_len), "", 1);
+}
+
+/**
+ *  Hashes a key from the hash of its section name.
+ */
+static uint64_t
+mini_layers_hash_key (uint64_t section_hash, const char *key, size_t key_len)
+{
+    return mini_hash_final (mini_hash_update (section_hash, key, key_len));
+}
+
+/**
+ *  Searches for a pair in the merged index.
+ *
+ *  @param layers A MiniLayers structure with an index.
+ *  @param hash Hash of the pair.
+ *  @param section A section name.
+ *  @param section_len Length of the section name.
+ *  @param key A key name.
+ *  @param key_len Length of the key name.
+ *  @return The return value is the slot of the index holding the pair, 
+ *          or the empty slot where it would be inserted.
+ */
+static unsigned int
+mini_layers_probe (const MiniLayers *layers, uint64_t hash, 
+                   const char *section, size_t section_len, const char *key,
+                   size_t key_len)
+{
+    const MiniLayerEntry *entry;
+    unsigned int mask = layers->index_size - 1;
+    unsigned int pos = hash & mask;
+
+    while (layers->index[pos] != 0) {
+        entry = &layers->entries[layers->index[pos] - 1];
+        if ((entry->hash == hash) && (entry->key_len == key_len) && 
+            (entry->section_len == section_len) &&
+            (memcmp (entry->key, key, key_len) == 0) &&
+            (memcmp (entry->section, section, section_len) == 0))
+            break;
+
+        pos = (pos + 1) & mask;
+    }
+
+    return pos;
+}
+
+/**
+ *  Doubles the room for entries, and the index with it.
+ *
+ *  @param layers A MiniLayers structure.
+ *  @return The function returns a negative number, if the memory can't 
+ *          be allocated. The entries are kept then.
+ */
+static int
+mini_layers_grow (MiniLayers *layers)
+{
+    MiniLayerEntry *entries;
+    const void **slots;
+    unsigned int *index, size, i, pos, mask;
+
+    size = (layers->entries_size > 0) ? 2 * layers->entries_size : 
+                                        MINI_INDEX_MIN_SIZE;
+
+    entries = (MiniLayerEntry *) mini_realloc (NULL, layers->entries, 
+                                               size * 
+                                               sizeof (MiniLayerEntry));
+    if (entries == NULL)
+        return -1;
+    layers->entries = entries;
+
+    slots = (const void **) mini_realloc (NULL, layers->slots, 
+                                          (size_t) size * layers->num_layers *
+                                          sizeof (void *));
+    if (slots == NULL)
+        return -1;
+    layers->slots = slots;
+
+    /* Half full at most */
+    index = (unsigned int *) mini_calloc (NULL, 2 * size, 
+                                          sizeof (unsigned int));
+    if (index == NULL)
+        return -1;
+
+    mask = 2 * size - 1;
+    for (i = 0; i < layers->num_entries; i++) {
+        pos = entries[i].hash & mask;
+        while (index[pos] != 0)
+            pos = (pos + 1) & mask;
+        index[pos] = i + 1;
+    }
+
+    mini_free (NULL, layers->index);
+    layers->index = index;
+    layers->index_size = 2 * size;
+    layers->entries_size = size;
+
+    return 0;
+}
+
+/**
+ *  Sets the key of a pair in a layer, adding the pair to the index if 
+ *  no layer had it.
+ *
+ *  @param layers A MiniLayers structure.
+ *  @param layer The layer.
+ *  @param hash Hash of the pair.
+ *  @param section A section name.
+ *  @param section_len Length of the section name.
+ *  @param section_copy Copy of the section name in the arena, created by 
+ *         the first new pair of the section.
+ *  @param key A key name.
+ *  @param key_len Length of the key name.
+ *  @param slot The key in the layer.
+ *  @return The function returns a negative number, if the pair can't be 
+ *          added.
+ */
+static int
+mini_layers_set (MiniLayers *layers, unsigned int layer, uint64_t hash, 
+                 const char *section, size_t section_len, 
+                 const char **section_copy, const char *key, size_t key_len,
+                 const void *slot)
+{
+    MiniLayerEntry *entry;
+    unsigned int pos;
+
+    if ((layers->num_entries == layers->entries_size) && 
+        (mini_layers_grow (layers) < 0))
+        return -1;
+
+    pos = mini_layers_probe (layers, hash, section, section_len, key, 
+                             key_len);
+
+    if (layers->index[pos] == 0) {
+        if (*section_copy == NULL) {
+            *section_copy = mini_arena_strndup (layers->arena, section, 
+                                                section_len);
+            if (*section_copy == NULL)
+                return -1;
+        }
+
+        entry = &layers->entries[layers->num_entries];
+        entry->key = mini_arena_strndup (layers->arena, key, key_len);
+        if (entry->key == NULL)
+            return -1;
+
+        entry->hash = hash;
+        entry->section = *section_copy;
+        entry->section_len = section_len;
+        entry->key_len = key_len;
+        entry->winner = MINI_LAYERS_NONE;
+        memset (&layers->slots[(size_t) layers->num_entries * 
+                               layers->num_layers], 0, 
+                layers->num_layers * sizeof (void *));
+
+        layers->index[pos] = ++layers->num_entries;
+        layers->num_dead++;
+    }
+
+    entry = &layers->entries[layers->index[pos] - 1];
+    layers->slots[(size_t) (layers->index[pos] - 1) * layers->num_layers + 
+                  layer] = slot;
+
+    if (entry->winner < (int) layer) {
+        if (entry->winner == MINI_LAYERS_NONE)
+            layers->num_dead--;
+        entry->winner = layer;
+    }
+
+    return 0;
+}
+
+/**
+ *  Sets the keys of a frozen layer. Only the pairs found by a lookup of 
+ *  the layer are set: duplicated sections and keys are skipped.
+ *
+ *  @param layers A MiniLayers structure.
+ *  @param layer The layer.
+ *  @param image The frozen image of the layer.
+ *  @return The function returns a negative number, if a key can't be set.
+ */
+static int
+mini_layers_fill_frozen (MiniLayers *layers, unsigned int layer, 
+                         const MiniFrozenHeader *image)
+{
+    const char *base = (const char *) image;
+    const MiniFrozenSection *sections;
+    const MiniFrozenKey *keys;
+    const char *name, *key, *copy;
+    uint64_t hash;
+    uint32_t i, j;
+
+    sections = (const MiniFrozenSection *) &base[image->sections_offset];
+    keys = (const MiniFrozenKey *) &base[image->keys_offset];
+
+    for (i = 0; i < image->num_sections; i++) {
+        name = &base[sections[i].name];
+        if (mini_frozen_find_section (image, name, 
+                                      sections[i].name_len) != &sections[i])
+            continue;
+
+        hash = mini_layers_hash_section (name, sections[i].name_len);
+        copy = NULL;
+
+        for (j = sections[i].first_key; 
+             j < sections[i].first_key + sections[i].num_keys; j++) {
+            key = &base[keys[j].key];
+            if (mini_frozen_find_key (image, &sections[i], key, 
+                                      keys[j].key_len) != &keys[j])
+                continue;
+
+            if (mini_layers_set (layers, layer, 
+                                 mini_layers_hash_key (hash, key, 
+                                                       keys[j].key_len),
+                                 name, sections[i].name_len, &copy, key, 
+                                 keys[j].key_len, &keys[j]) < 0)
+                return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ *  Sets the keys of a layer, parsing its lazy sections first. Only the 
+ *  pairs found by a lookup of the layer are set: duplicated sections are 
+ *  skipped, and the last duplicated key of a section wins.
+ *
+ *  @param layers A MiniLayers structure.
+ *  @param layer The layer.
+ *  @return The function returns a negative number, if a key can't be set.
+ */
+static int
+mini_layers_fill (MiniLayers *layers, unsigned int layer)
+{
+    MiniFile *mini_file = layers->files[layer];
+    const Section *sec;
+    SectionData *data;
+    const char *copy;
+    uint64_t hash;
+
+    if (mini_file->frozen != NULL) {
+        if (mini_layers_fill_frozen (layers, layer, mini_file->frozen) < 0)
+            return -1;
+    }
+    else {
+        if ((mini_file->lazy != NULL) && (mini_lazy_load_all (mini_file) < 0))
+            return -1;
+
+        for (sec = mini_file->section; sec != NULL; sec = sec->next) {
+            if (mini_file_find_section (mini_file, sec->name, 
+                                        sec->name_len) != sec)
+                continue;
+
+            hash = mini_layers_hash_section (sec->name, sec->name_len);
+            copy = NULL;
+
+            for (data = sec->data; data != NULL; data = data->next)
+                if (mini_layers_set (layers, layer, 
+                                     mini_layers_hash_key (hash, data->key,
+                                                           data->key_len),
+                                     sec->name, sec->name_len, &copy, 
+                                     data->key, data->key_len, data) < 0)
+                    return -1;
+        }
+    }
+
+    layers->generations[layer] = mini_file->generation;
+
+    return 0;
+}
+
+/**
+ *  Clears the keys of a layer, handing each pair it won to the highest 
+ *  layer below having it.
+ *
+ *  @param layers A MiniLayers structure.
+ *  @param layer The layer.
+ */
+static void
+mini_layers_clear (MiniLayers *layers, unsigned int layer)
+{
+    MiniLayerEntry *entry;
+    const void **slots;
+    unsigned int i;
+    int j;
+
+    for (i = 0; i < layers->num_entries; i++) {
+        slots = &layers->slots[(size_t) i * layers->num_layers];
+        slots[layer] = NULL;
+
+        entry = &layers->entries[i];
+        if (entry->winner != (int) layer)
+            continue;
+
+        for (j = (int) layer - 1; (j >= 0) && (slots[j] == NULL); j--)
+            ;
+
+        entry->winner = (j >= 0) ? j : MINI_LAYERS_NONE;
+        if (entry->winner == MINI_LAYERS_NONE)
+            layers->num_dead++;
+    }
+}
+
+/**
+ *  Builds the merged index again from all the layers.
+ *
+ *  @param layers A MiniLayers structure.
+ *  @return The function returns a negative number, if the index can't 
+ *          be built. It stays dirty then.
+ */
+static int
+mini_layers_rebuild (MiniLayers *layers)
+{
+    MiniArena *arena;
+    unsigned int i;
+
+    arena = mini_arena_new (NULL);
+    if (arena == NULL)
+        return -1;
+
+    mini_arena_free (layers->arena);
+    mini_free (NULL, layers->entries);
+    mini_free (NULL, layers->slots);
+    mini_free (NULL, layers->index);
+
+    layers->arena = arena;
+    layers->entries = NULL;
+    layers->slots = NULL;
+    layers->num_entries = 0;
+    layers->entries_size = 0;
+    layers->num_dead = 0;
+    layers->index = NULL;
+    layers->index_size = 0;
+    layers->dirty = 1;
+
+    if (mini_layers_grow (layers) < 0)
+        return -1;
+
+    for (i = 0; i < layers->num_layers; i++)
+        if (mini_layers_fill (layers, i) < 0)
+            return -1;
+
+    layers->dirty = 0;
+
+    return 0;
+}
+
+/**
+ *  Indexes again a layer, rebuilding the whole index instead if it's 
+ *  dirty or if too many of its entries are dead.
+ *
+ *  @param layers A MiniLayers structure.
+ *  @param layer The layer.
+ *  @return The function returns a negative number, if the index can't 
+ *          be updated. It's dirty then.
+ */
+static int
+mini_layers_update (MiniLayers *layers, unsigned int layer)
+{
+    if (layers->dirty)
+        return mini_layers_rebuild (layers);
+
+    mini_layers_clear (layers, layer);
+
+    if (mini_layers_fill (layers, layer) < 0) {
+        layers->dirty = 1;
+        return -1;
+    }
+
+    if (layers->num_dead * MINI_LAYERS_DEAD_RATIO > layers->num_entries)
+        return mini_layers_rebuild (layers);
+
+    return 0;
+}
+
+/**
+ *  Brings the merged index up to date: the layers modified since they 
+ *  were indexed are indexed again.
+ *
+ *  @param layers A MiniLayers structure.
+ *  @return The function returns a negative number, if the index can't 
+ *          be updated.
+ */
+static int
+mini_layers_refresh (MiniLayers *layers)
+{
+    unsigned int i;
+
+    if (layers->dirty)
+        return mini_layers_rebuild (layers);
+
+    for (i = 0; i < layers->num_layers; i++)
+        if ((layers->files[i]->generation != layers->generations[i]) &&
+            (mini_layers_update (layers, i) < 0))
+            return -1;
+
+    return 0;
+}
+
+
+/**
+ *  Creates an empty stack of layers.
+ *
+ *  @return The return value is a new MiniLayers structure.
+ *          The function returns NULL, if it can't be allocated.
+ */
+MiniLayers *
+mini_layers_new (void)
+{
+    MiniLayers *layers;
+
+    layers = (MiniLayers *) mini_calloc (NULL, 1, sizeof (MiniLayers));
+    if (layers == NULL)
+        return NULL;
+
+    layers->dirty = 1;
+
+    return layers;
+}
+
+/**
+ *  Frees a MiniLayers structure and its merged index. The layers aren't 
+ *  freed.
+ *
+ *  @param layers A MiniLayers structure.
+ */
+void
+mini_layers_free (MiniLayers *layers)
+{
+    /* Do nothing with NULL pointers */
+    if (layers == NULL)
+        return;
+
+    mini_arena_free (layers->arena);
+    mini_free (NULL, layers->entries);
+    mini_free (NULL, layers->slots);
+    mini_free (NULL, layers->index);
+    mini_free (NULL, layers->files);
+    mini_free (NULL, layers->generations);
+    mini_free (NULL, layers);
+}
+
+/**
+ *  Adds a layer with a higher priority than the current ones: its keys 
+ *  hide the same keys of the layers below. The merged index is built 
+ *  again on the next lookup.
+ *
+ *  @param layers A MiniLayers structure.
+ *  @param mini_file A MiniFile structure, it must outlive the layers 
+ *         (or be replaced first).
+ *  @return The return value is the number of the new layer, from zero.
+ *          The function returns a negative number, if it can't be added.
+ */
+int
+mini_layers_push (MiniLayers *layers, MiniFile *mini_file)
+{
+    MiniFile **files;
+    uint64_t *generations;
+    unsigned int n;
+
+    /* Layers and MiniFile can't be NULL */
+    assert (layers != NULL);
+    assert (mini_file != NULL);
+
+    n = layers->num_layers + 1;
+
+    files = (MiniFile **) mini_realloc (NULL, layers->files, 
+                                        n * sizeof (MiniFile *));
+    if (files == NULL)
+        return -1;
+    layers->files = files;
+
+    generations = (uint64_t *) mini_realloc (NULL, layers->generations, 
+                                             n * sizeof (uint64_t));
+    if (generations == NULL)
+        return -1;
+    layers->generations = generations;
+
+    files[n - 1] = mini_file;
+    generations[n - 1] = 0;
+    layers->num_layers = n;
+
+    /* The slots of every entry grow */
+    layers->dirty = 1;
+
+    return n - 1;
+}
+
+/**
+ *  Replaces a layer, keeping its priority. Only the entries of the old 
+ *  and the new layer are updated in the merged index. Once replaced, 
+ *  the old MiniFile can be freed.
+ *
+ *  @param layers A MiniLayers structure.
+ *  @param layer Number of the layer.
+ *  @param mini_file A MiniFile structure, it must outlive the layers 
+ *         (or be replaced first).
+ *  @return The function returns a negative number, if the layer doesn't 
+ *          exist or the index can't be updated (it's built again on the 
+ *          next lookup then).
+ */
+int
+mini_layers_replace (MiniLayers *layers, unsigned int layer, 
+                     MiniFile *mini_file)
+{
+    /* Layers and MiniFile can't be NULL */
+    assert (layers != NULL);
+    assert (mini_file != NULL);
+
+    if (layer >= layers->num_layers)
+        return -1;
+
+    layers->files[layer] = mini_file;
+
+    return mini_layers_update (layers, layer);
+}
+
+/**
+ *  Gets the number of layers.
+ *
+ *  @param layers A MiniLayers structure.
+ *  @return The return value is the number of layers.
+ */
+unsigned int
+mini_layers_get_number_of_layers (const MiniLayers *layers)
+{
+    /* Layers can't be NULL */
+    assert (layers != NULL);
+
+    return layers->num_layers;
+}
+
+/**
+ *  Gets the value of a section's key from the highest layer having it, 
+ *  as mini_file_get_value() would get it from that layer. The layers 
+ *  modified since the last lookup are indexed again first, so lookups 
+ *  must not run concurrently.
+ *
+ *  @param layers A MiniLayers structure.
+ *  @param section A section name.
+ *  @param key A key name.
+ *  @param layer Pointer receiving the number of the layer having the 
+ *         value, or NULL.
+ *  @return The return value is the value of the key.
+ *          The function returns NULL, if no layer has the given key.
+ */
+const char *
+mini_layers_get_value (MiniLayers *layers, const char *section, 
+                       const char *key, int *layer)
+{
+    const MiniLayerEntry *entry;
+    const void *slot;
+    MiniFile *mini_file;
+    size_t section_len, key_len;
+    unsigned int pos;
+    uint64_t hash;
+
+    /* Layers, section and key can't be NULL */
+    assert (layers != NULL);
+    assert (section != NULL);
+    assert (key != NULL);
+
+    if (layer != NULL)
+        *layer = MINI_LAYERS_NONE;
+
+    if ((layers->num_layers == 0) || (mini_layers_refresh (layers) < 0))
+        return NULL;
+
+    section_len = strlen (section);
+    key_len = strlen (key);
+    hash = mini_layers_hash_key (mini_layers_hash_section (section, 
+                                                           section_len),
+                                 key, key_len);
+
+    pos = mini_layers_probe (layers, hash, section, section_len, key, 
+                             key_len);
+    if (layers->index[pos] == 0)
+        return NULL;
+
+    entry = &layers->entries[layers->index[pos] - 1];
+    if (entry->winner == MINI_LAYERS_NONE)
+        return NULL;
+
+    if (layer != NULL)
+        *layer = entry->winner;
+
+    mini_file = layers->files[entry->winner];
+    slot = layers->slots[(size_t) (layers->index[pos] - 1) * 
+                         layers->num_layers + entry->winner];
+
+    if (mini_file->frozen != NULL)
+        return (const char *) mini_file->frozen + 
+               ((const MiniFrozenKey *) slot)->value;
+
+    return mini_file_get_data_value (mini_file, (SectionData *) slot);
+}
@@ -0,0 +1,109 @@
+/*
+ * mini-layers.h
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MINI_LAYERS_H__
+#define __MINI_LAYERS_H__
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mini-file.h"
+#include "mini-frozen.h"
+#include "mini-lazy.h"
+
+/* The merged index is rebuilt when this share of its entries is dead */
+#define MINI_LAYERS_DEAD_RATIO 2
+
+/* No layer has the key */
+#define MINI_LAYERS_NONE -1
+
+/* A "section\0key" pair of any layer */
+typedef struct _MiniLayerEntry MiniLayerEntry;
+struct _MiniLayerEntry {
+    uint64_t hash;
+    /* Copies in the arena of the MiniLayers */
+    const char *section;
+    const char *key;
+    size_t section_len;
+    size_t key_len;
+    /* Highest layer having the pair, or MINI_LAYERS_NONE */
+    int winner;
+};
+
+/* 
+ * A stack of MiniFiles (defaults, site, host, overrides...) answering 
+ * lookups through a single merged index: a lookup is one probe, whatever 
+ * the number of layers, instead of a search per layer.
+ *
+ * Every entry of the index has a slot per layer with its key in that 
+ * layer (a SectionData, or a MiniFrozenKey for frozen layers), and the 
+ * number of the highest layer having it. Replacing or modifying a layer 
+ * only clears and fills again the slots of that layer.
+ */
+typedef struct _MiniLayers MiniLayers;
+struct _MiniLayers {
+    /* Layers from the lowest priority, borrowed */
+    MiniFile **files;
+    /* Generation of each layer when it was indexed */
+    uint64_t *generations;
+    unsigned int num_layers;
+    /* Entries and their slots, num_layers per entry */
+    MiniLayerEntry *entries;
+    const void **slots;
+    unsigned int num_entries;
+    unsigned int entries_size;
+    unsigned int num_dead;
+    /* Open-addressing index of entry numbers plus one */
+    unsigned int *index;
+    unsigned int index_size;
+    /* Arena holding the copies of the names (replaced on rebuilds) */
+    MiniArena *arena;
+    /* The index must be built again from all the layers */
+    int dirty;
+};
+
+
+MiniLayers *mini_layers_new (void);
+
+void mini_layers_free (MiniLayers *layers);
+
+int mini_layers_push (MiniLayers *layers, MiniFile *mini_file);
+
+int mini_layers_replace (MiniLayers *layers, unsigned int layer, 
+                         MiniFile *mini_file);
+
+unsigned int mini_layers_get_number_of_layers (const MiniLayers *layers);
+
+const char *mini_layers_get_value (MiniLayers *layers, const char *section,
+                                   const char *key, int *layer);
+
+#endif /* __MINI_LAYERS_H__ */
@@ -0,0 +1,455 @@
+/*
+ * mini-lazy.c
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mini-lazy.h"
+
+/* Returned by mini_lazy_scan() when a line includes a file */
+#define MINI_LAZY_INCLUDE 1
+
+/* User data of the callbacks parsing the body of a section */
+typedef struct _MiniLazyBody MiniLazyBody;
+struct _MiniLazyBody {
+    MiniFile *mini_file;
+    Section *section;
+    /* Line of the first line of the body */
+    int lineno;
+};
+
+
+/**
+ *  Callback parsing the body of a section: adds a key-value pair to the 
+ *  section, borrowing it from the mapping.
+ */
+static int
+mini_lazy_key_value (const char *key, size_t key_len, const char *value,
+                     size_t value_len, int lineno, void *user_data)
+{
+    MiniLazyBody *body = (MiniLazyBody *) user_data;
+    SectionData *data;
+
+    data = mini_file_add_key_to_section (body->mini_file, body->section, key,
+                                         key_len, value, value_len, 
+                                         MINI_BORROW);
+    if (data == NULL)
+        return -1;
+
+    data->lineno = body->lineno + lineno - 1;
+
+    return 0;
+}
+
+/**
+ *  Callback parsing the body of a section: prints the wrong line with its 
+ *  line number in the file, and stops.
+ */
+static int
+mini_lazy_error (const char *line, size_t line_len, int lineno, 
+                 void *user_data)
+{
+    MiniLazyBody *body = (MiniLazyBody *) user_data;
+
+    fprintf (stderr, "parse error at line %d\n", body->lineno + lineno - 1);
+
+    return 1;
+}
+
+/**
+ *  Callback checking the lines before the first section: keys without 
+ *  section are wrong.
+ */
+static int
+mini_lazy_orphan_key (const char *key, size_t key_len, const char *value,
+                      size_t value_len, int lineno, void *user_data)
+{
+    return -1;
+}
+
+static const MiniParseCallbacks mini_lazy_body_callbacks = {
+    NULL,
+    mini_lazy_key_value,
+    NULL,
+    mini_lazy_error,
+    NULL
+};
+
+static const MiniParseCallbacks mini_lazy_preamble_callbacks = {
+    NULL,
+    mini_lazy_orphan_key,
+    NULL,
+    mini_lazy_error,
+    NULL
+};
+
+/**
+ *  Adds a span to the lazy sections of a MiniFile. The spans grow 
+ *  geometrically inside the arena, as the indexes do.
+ *
+ *  @param mini_file A MiniFile structure opened by mini_file_open_lazy().
+ *  @param body Start of the body.
+ *  @param lineno Line of the start of the body.
+ *  @return The return value is the new span.
+ *          The function returns NULL, if the span can't be added.
+ */
+static MiniLazySpan *
+mini_lazy_add_span (MiniFile *mini_file, const char *body, int lineno)
+{
+    MiniLazy *lazy = mini_file->lazy;
+    MiniLazySpan *spans;
+    unsigned int size;
+
+    if (lazy->num_spans == lazy->spans_size) {
+        size = (lazy->spans_size > 0) ? 2 * lazy->spans_size : 
+                                        MINI_INDEX_MIN_SIZE;
+        spans = (MiniLazySpan *) mini_arena_alloc (mini_file->arena, 
+                                                   size * 
+                                                   sizeof (MiniLazySpan));
+        if (spans == NULL)
+            return NULL;
+
+        if (lazy->num_spans > 0)
+            memcpy (spans, lazy->spans, 
+                    lazy->num_spans * sizeof (MiniLazySpan));
+
+        lazy->spans = spans;
+        lazy->spans_size = size;
+    }
+
+    spans = &lazy->spans[lazy->num_spans++];
+    spans->body = body;
+    spans->size = 0;
+    spans->lineno = lineno;
+
+    return spans;
+}
+
+/**
+ *  Gets the section name of a line, if it's a section header as 
+ *  mini_parse_file() parses it: the first non whitespace character is a 
+ *  '[' and, once the comment and the whitespaces at the right are 
+ *  stripped, the first ']' is the last character.
+ *
+ *  @param line Start of the line.
+ *  @param eol End of the line.
+ *  @param name_len Pointer receiving the length of the section name.
+ *  @return The return value is the section name.
+ *          The function returns NULL, if the line isn't a section header.
+ */
+static const char *
+mini_lazy_header (const char *line, const char *eol, size_t *name_len)
+{
+    const char *start, *end, *close;
+
+    for (start = line; (start < eol) && MINI_SCAN_IS_SPACE (*start); start++)
+        ;
+
+    if ((start == eol) || (*start != '['))
+        return NULL;
+
+    for (end = start; (end < eol) && 
+         !(mini_scan_class[(unsigned char) *end] & MINI_SCAN_COMMENT); end++)
+        ;
+
+    close = memchr (start, ']', end - start);
+
+    while ((end > start) && MINI_SCAN_IS_SPACE (end[-1]))
+        end--;
+
+    /* Wrong headers are reported when the body holding them is parsed */
+    if ((close != end - 1) || (end - start == 2))
+        return NULL;
+
+    *name_len = end - start - 2;
+
+    return start + 1;
+}
+
+/**
+ *  Checks whether a line may be an include directive, which can add 
+ *  sections of its own.
+ *
+ *  @param line Start of the line.
+ *  @param eol End of the line.
+ *  @return The function returns non-zero if the line starts with the 
+ *          include directive.
+ */
+static int
+mini_lazy_is_include (const char *line, const char *eol)
+{
+    const char *start;
+
+    for (start = line; (start < eol) && MINI_SCAN_IS_SPACE (*start); start++)
+        ;
+
+    return (eol - start > MINI_PARSE_INCLUDE_LEN) && 
+           (memcmp (start, MINI_PARSE_INCLUDE, MINI_PARSE_INCLUDE_LEN) == 0) &&
+           MINI_SCAN_IS_SPACE (start[MINI_PARSE_INCLUDE_LEN]);
+}
+
+/**
+ *  Indexes the section headers of a buffer, the only lines looked at. 
+ *  Every section is added to the MiniFile without keys, referring to the 
+ *  span of its body.
+ *
+ *  @param mini_file A MiniFile structure opened by mini_file_open_lazy().
+ *  @param buffer Contents of the INI file.
+ *  @param size Size of the buffer.
+ *  @param preamble Pointer receiving the size of the lines before the 
+ *         first section.
+ *  @return The function returns a negative number, if the sections 
+ *          can't be added, or MINI_LAZY_INCLUDE if a line includes a file.
+ */
+static int
+mini_lazy_scan (MiniFile *mini_file, const char *buffer, size_t size, 
+                size_t *preamble)
+{
+    const char *end = buffer + size;
+    const char *line, *eol, *name;
+    MiniLazySpan *span = NULL;
+    Section *section;
+    size_t name_len;
+    int lineno = 1;
+
+    *preamble = size;
+
+    for (line = buffer; line < end; line = eol + 1, lineno++) {
+        eol = memchr (line, EOL, end - line);
+        if (eol == NULL)
+            eol = end;
+
+        name = mini_lazy_header (line, eol, &name_len);
+        if (name == NULL) {
+            if (mini_lazy_is_include (line, eol))
+                return MINI_LAZY_INCLUDE;
+            continue;
+        }
+
+        /* The previous body ends at this header */
+        if (span != NULL)
+            span->size = line - span->body;
+        else
+            *preamble = line - buffer;
+
+        section = mini_file_add_section (mini_file, name, name_len, 
+                                         MINI_BORROW);
+        if (section == NULL)
+            return -1;
+
+        span = mini_lazy_add_span (mini_file, (eol < end) ? eol + 1 : end,
+                                   lineno + 1);
+        if (span == NULL)
+            return -1;
+
+        section->lazy = mini_file->lazy->num_spans;
+        mini_file->lazy->num_pending++;
+    }
+
+    if (span != NULL)
+        span->size = end - span->body;
+
+    return 0;
+}
+
+
+/**
+ *  Opens an INI file without parsing it: a single pass over the file 
+ *  indexes the section headers, and the body of a section is parsed the 
+ *  first time mini_file_get_value(), mini_file_get_number_of_keys() or 
+ *  another lookup needs it. The file is mapped into memory and the keys 
+ *  and values reference the mapping, as mini_parse_mmap() does.
+ *
+ *  A file with include directives is parsed whole, by mini_parse_mmap().
+ *
+ *  A wrong line before the first section fails the open, as it makes 
+ *  mini_parse_file() stop before any section. A wrong line in a body only 
+ *  ends the parse of the section holding it, and it's printed when the 
+ *  section is loaded. mini_file_section_iter() loads the sections it 
+ *  returns, and the functions copying the whole MiniFile (mini_flat_new(), 
+ *  mini_file_seal()...) load them all, see mini_lazy_load_all().
+ *
+ *  Lookups load sections, so they modify the MiniFile: concurrent lookups 
+ *  need a lock of their own, or a previous mini_lazy_load_all() call.
+ *
+ *  @param file_name INI file path.
+ *  @return The return value is a MiniFile structure with the sections of 
+ *          the given INI file.
+ *          The function returns NULL, if the given INI file can't be opened
+ *          or a line before its first section is wrong.
+ */
+MiniFile *
+mini_file_open_lazy (const char *file_name)
+{
+    MiniFile *mini_file;
+    MiniLazyBody preamble_body;
+    struct stat st;
+    void *mapping = NULL;
+    size_t preamble;
+    int fd, ret;
+
+    /* Filename can't be NULL */
+    assert (file_name != NULL);
+
+    fd = open (file_name, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    if (fstat (fd, &st) < 0) {
+        close (fd);
+        return NULL;
+    }
+
+    /* Empty files can't be mapped */
+    if (st.st_size > 0) {
+        mapping = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            close (fd);
+            return NULL;
+        }
+    }
+
+    close (fd);
+
+    mini_file = mini_file_new (file_name);
+    if (mini_file == NULL) {
+        if (mapping != NULL)
+            munmap (mapping, st.st_size);
+        return NULL;
+    }
+
+    mini_file->mapping = mapping;
+    mini_file->mapping_size = st.st_size;
+
+    mini_file->lazy = (MiniLazy *) mini_arena_alloc (mini_file->arena, 
+                                                     sizeof (MiniLazy));
+    if (mini_file->lazy == NULL) {
+        mini_file_free (mini_file);
+        return NULL;
+    }
+
+    memset (mini_file->lazy, 0, sizeof (MiniLazy));
+
+    ret = mini_lazy_scan (mini_file, (const char *) mapping, st.st_size, 
+                          &preamble);
+    if (ret != 0) {
+        mini_file_free (mini_file);
+
+        /* The sections of the included files are only known parsing them */
+        if (ret == MINI_LAZY_INCLUDE)
+            return mini_parse_mmap (file_name);
+
+        return NULL;
+    }
+
+    /* Only comments can be before the first section */
+    preamble_body.mini_file = mini_file;
+    preamble_body.section = NULL;
+    preamble_body.lineno = 1;
+    if (mini_parse_buffer_stream ((const char *) mapping, preamble, 
+                                  &mini_lazy_preamble_callbacks, 
+                                  &preamble_body) != 0) {
+        mini_file_free (mini_file);
+        return NULL;
+    }
+
+    return mini_file;
+}
+
+/**
+ *  Parses the body of a section of a MiniFile opened by 
+ *  mini_file_open_lazy(), if it isn't parsed yet. The keys before a wrong 
+ *  line are kept.
+ *
+ *  @param mini_file A MiniFile structure.
+ *  @param section A section of the MiniFile.
+ *  @return The function returns a negative number, if a line of the body 
+ *          is wrong or its keys can't be added.
+ */
+int
+mini_lazy_load_section (MiniFile *mini_file, Section *section)
+{
+    const MiniLazySpan *span;
+    MiniLazyBody body;
+
+    /* MiniFile and section can't be NULL */
+    assert (mini_file != NULL);
+    assert (section != NULL);
+
+    if (section->lazy == 0)
+        return 0;
+
+    span = &mini_file->lazy->spans[section->lazy - 1];
+
+    /* A wrong line is reported once */
+    section->lazy = 0;
+    mini_file->lazy->num_pending--;
+
+    body.mini_file = mini_file;
+    body.section = section;
+    body.lineno = span->lineno;
+
+    if (mini_parse_buffer_stream (span->body, span->size, 
+                                  &mini_lazy_body_callbacks, 
+                                  &body) == MINI_PARSE_ERROR)
+        return -1;
+
+    return 0;
+}
+
+/**
+ *  Parses the bodies of all the sections not parsed yet of a MiniFile 
+ *  opened by mini_file_open_lazy(), so it can be walked like a parsed one.
+ *
+ *  @param mini_file A MiniFile structure.
+ *  @return The function returns a negative number, if a section can't be 
+ *          parsed.
+ */
+int
+mini_lazy_load_all (MiniFile *mini_file)
+{
+    Section *sec;
+    int ret = 0;
+
+    /* MiniFile can't be NULL */
+    assert (mini_file != NULL);
+
+    if ((mini_file->lazy == NULL) || (mini_file->lazy->num_pending == 0))
+        return 0;
+
+    for (sec = mini_file->section; sec != NULL; sec = sec->next)
+        if (mini_lazy_load_section (mini_file, sec) < 0)
+            ret = -1;
+
+    return ret;
+}
@@ -0,0 +1,71 @@
+/*
+ * mini-lazy.h
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MINI_LAZY_H__
+#define __MINI_LAZY_H__
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mini-file.h"
+#include "mini-parser.h"
+
+/* Unparsed body of a section, from the line after its header */
+typedef struct _MiniLazySpan MiniLazySpan;
+struct _MiniLazySpan {
+    const char *body;
+    size_t size;
+    int lineno;
+};
+
+/* 
+ * Sections of a MiniFile opened by mini_file_open_lazy(): every section 
+ * header is indexed when the file is opened, but the body of a section is 
+ * parsed the first time a lookup needs it. The Section structure of a 
+ * body not parsed yet refers to its span (section->lazy, one plus its 
+ * position), and it has no keys.
+ */
+struct _MiniLazy {
+    MiniLazySpan *spans;
+    unsigned int num_spans;
+    unsigned int spans_size;
+    /* Spans not parsed yet */
+    unsigned int num_pending;
+};
+
+
+MiniFile *mini_file_open_lazy (const char *file_name);
+
+int mini_lazy_load_section (MiniFile *mini_file, Section *section);
+
+int mini_lazy_load_all (MiniFile *mini_file);
+
+#endif /* __MINI_LAZY_H__ */
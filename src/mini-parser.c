@@ -29,173 +29,1676 @@
  */
 
 #include "mini-parser.h"
+#include "mini-include.h"
+
+/* Positions of the structural characters of the line being parsed */
+typedef struct _MiniLine MiniLine;
+struct _MiniLine {
+    const char *start;
+    const char *comment;
+    const char *equal;
+    const char *close;
+};
+
+/* State of a running parse */
+typedef struct _MiniParser MiniParser;
+struct _MiniParser {
+    const MiniParseCallbacks *callbacks;
+    void *user_data;
+    int lineno;
+    /* Statistics of the parse, or NULL */
+    MiniParseStats *stats;
+};
+
+/* User data of the callbacks building a MiniFile */
+typedef struct _MiniParseTree MiniParseTree;
+struct _MiniParseTree {
+    MiniFile *mini_file;
+    int borrow;
+    /* Files being included, or NULL if includes aren't allowed */
+    const MiniIncludeStack *includes;
+};
+
+/* User data of the callbacks collecting the statistics of a parse */
+typedef struct _MiniParseCounter MiniParseCounter;
+struct _MiniParseCounter {
+    MiniParseCallbacks wrapper;
+    /* Wrapped callbacks */
+    const MiniParseCallbacks *callbacks;
+    void *user_data;
+    MiniParseStats *stats;
+    /* Line of the last section or key-value pair */
+    int last_lineno;
+    int first_lineno;
+    /* Times when the parse began */
+    double start;
+    double read_time;
+    double insert_time;
+};
+
+/* Chunk of a file parsed by a worker of mini_parse_file_parallel() */
+typedef struct _MiniParseChunk MiniParseChunk;
+struct _MiniParseChunk {
+    const char *buffer;
+    size_t size;
+    MiniParseTree tree;
+    /* Keys before the first section, they belong to a previous chunk */
+    Section *continued;
+    int num_lines;
+    int first_lineno;
+    int continued_lineno;
+    int error_lineno;
+    /* First include of the chunk (0 if none), see mini_parse_chunk_include */
+    int include_lineno;
+    /* Statistics of the chunk, or NULL */
+    MiniParseStats *stats;
+};
 
 
 /**
- *  Parses a line readed from an INI file.
+ *  Skips the whitespaces at the left of a string. Inside the current block 
+ *  its whitespace bitmap is used instead of looking at every character.
  *
- *  @param mini_file A MiniFile structure to save all the parsed data.
- *  @param line A line readed from an INI file.
- *  @return The function returns a negative number, if the line can't be parsed.
+ *  @param p Start of the string.
+ *  @param end End of the string.
+ *  @param base Start of the current block.
+ *  @param space Whitespace bitmap of the current block.
+ *  @return The return value is the first non whitespace character, or end.
+ */
+static const char *
+mini_parse_skip_space (const char *p, const char *end, const char *base, 
+                       uint64_t space)
+{
+    uint64_t rest;
+
+    if ((p >= base) && (p < end)) {
+        rest = ~space >> (p - base);
+        if (rest == 0)
+            return end;
+
+        p += __builtin_ctzll (rest);
+        return (p < end) ? p : end;
+    }
+
+    while ((p < end) && MINI_SCAN_IS_SPACE (*p))
+        p++;
+
+    return p;
+}
+
+/**
+ *  Skips the whitespaces at the right of a string. Inside the current 
+ *  block its whitespace bitmap is used instead of looking at every character.
+ *
+ *  @param start Start of the string.
+ *  @param end End of the string.
+ *  @param base Start of the current block.
+ *  @param space Whitespace bitmap of the current block.
+ *  @return The return value is the new end of the string.
+ */
+static const char *
+mini_parse_rskip_space (const char *start, const char *end, const char *base,
+                        uint64_t space)
+{
+    uint64_t below;
+    const char *p;
+
+    if (end > base) {
+        below = ~space;
+        if (end - base < MINI_SCAN_BLOCK_SIZE)
+            below &= ((uint64_t) 1 << (end - base)) - 1;
+
+        if (below != 0) {
+            p = base + MINI_SCAN_BLOCK_SIZE - __builtin_clzll (below);
+            return (p > start) ? p : start;
+        }
+
+        /* Only whitespaces from the start of the block */
+        if (base <= start)
+            return start;
+        end = base;
+    }
+
+    while ((end > start) && MINI_SCAN_IS_SPACE (end[-1]))
+        end--;
+
+    return end;
+}
+
+/**
+ *  Reports a line that can't be parsed to the on_error callback. Without 
+ *  callback, the error is printed and the parse is stopped.
+ *
+ *  @param parser The running parser.
+ *  @param line Start of the line.
+ *  @param eol End of the line.
+ *  @return The function returns zero to go on with the next line, or 
+ *          MINI_PARSE_ERROR to stop.
+ */
+static int
+mini_parse_error (MiniParser *parser, const char *line, const char *eol)
+{
+    const MiniParseCallbacks *callbacks = parser->callbacks;
+
+    if (callbacks->on_error == NULL) {
+        fprintf (stderr, "parse error at line %d\n", parser->lineno);
+        return MINI_PARSE_ERROR;
+    }
+
+    if (callbacks->on_error (line, eol - line, parser->lineno, 
+                             parser->user_data) != 0)
+        return MINI_PARSE_ERROR;
+
+    return 0;
+}
+
+/**
+ *  Turns the value returned by a callback into a parse status.
+ *
+ *  @param parser The running parser.
+ *  @param result Value returned by the callback.
+ *  @param line Structural positions of the line.
+ *  @param eol End of the line.
+ *  @return The function returns zero to go on with the next line, 
+ *          MINI_PARSE_STOPPED or MINI_PARSE_ERROR.
  */
 static int
-mini_parse_line (MiniFile *mini_file, char *line)
+mini_parse_result (MiniParser *parser, int result, const MiniLine *line, 
+                   const char *eol)
 {
-    char *start, *end, *equal;
-    char *section, *key, *value;
-    size_t section_len, key_len, value_len;
-    MiniFile *mini_file_tmp;
-	int i;
+    if (result < 0)
+        return mini_parse_error (parser, line->start, eol);
+
+    return (result > 0) ? MINI_PARSE_STOPPED : 0;
+}
 
-    /* Line can't be NULL */
-    assert (line != NULL);
+/**
+ *  Parses a line of an INI file from the positions of its structural 
+ *  characters, passing its section, key and value, and comment strings to 
+ *  the parser callbacks.
+ *
+ *  @param parser The running parser.
+ *  @param line Structural positions of the line.
+ *  @param eol End of the line.
+ *  @param base Start of the block in which the line ends.
+ *  @param space Whitespace bitmap of that block.
+ *  @return The function returns zero to go on with the next line, 
+ *          MINI_PARSE_STOPPED or MINI_PARSE_ERROR.
+ */
+static int
+mini_parse_line (MiniParser *parser, const MiniLine *line, const char *eol,
+                 const char *base, uint64_t space)
+{
+    const MiniParseCallbacks *callbacks = parser->callbacks;
+    const char *start, *end, *key_end, *value;
+    int result = 0;
 
-	/* Strip comment (if any) after section or key/value string */
-	for (i = 0; line[i] != '\0'; i++)
-	{
-		if (line[i] == ';' || line[i] == '#')
-		{
-			line[i] = '\0';
-			break;
-		}
-	}
+    /* Strip comment (if any) after section or key/value string */
+    end = (line->comment != NULL) ? line->comment : eol;
 
     /* Strip all whitespaces */
-    start = mini_strip (line);
+    start = mini_parse_skip_space (line->start, end, base, space);
+    end = mini_parse_rskip_space (start, end, base, space);
+
+    /* Non empty line */
+    if (start != end) {
+        switch (start[0]) {
+
+            /* Section */
+            case '[':
+                /* At the end of the line must be an end of section (']') */
+                if (line->close != end - 1)
+                    return mini_parse_error (parser, line->start, eol);
+
+                /* Empty section */
+                if (end - start == 2)
+                    return mini_parse_error (parser, line->start, eol);
+
+                if (callbacks->on_section != NULL)
+                    result = callbacks->on_section (&start[1], end - start - 2,
+                                                    parser->lineno, 
+                                                    parser->user_data);
+                break;
+
+            default:
+                /* Include directive, a line without '=' */
+                if ((line->equal == NULL) && (callbacks->on_include != NULL) &&
+                    (end - start > MINI_PARSE_INCLUDE_LEN) &&
+                    (memcmp (start, MINI_PARSE_INCLUDE, 
+                             MINI_PARSE_INCLUDE_LEN) == 0) &&
+                    MINI_SCAN_IS_SPACE (start[MINI_PARSE_INCLUDE_LEN])) {
+                    value = mini_parse_skip_space (start + 
+                                                   MINI_PARSE_INCLUDE_LEN,
+                                                   end, base, space);
+                    result = callbacks->on_include (value, end - value, 
+                                                    parser->lineno,
+                                                    parser->user_data);
+                    break;
+                }
+
+                /* Between key and value must be an equality symbol ('=') */
+                if ((line->equal == NULL) || (start == line->equal) || 
+                    (line->equal == end - 1))
+                    return mini_parse_error (parser, line->start, eol);
+
+                /* Ignore whitespaces at right from key */
+                key_end = mini_parse_rskip_space (start, line->equal, base, 
+                                                  space);
+
+                /* Ignore whitespaces at left from value */
+                value = mini_parse_skip_space (line->equal + 1, end, base, 
+                                               space);
+
+                if (callbacks->on_key_value != NULL)
+                    result = callbacks->on_key_value (start, key_end - start,
+                                                      value, end - value, 
+                                                      parser->lineno,
+                                                      parser->user_data);
+        }
+
+        result = mini_parse_result (parser, result, line, eol);
+        if (result != 0)
+            return result;
+    }
+
+    /* Comment, without its ';' or '#' */
+    if ((line->comment != NULL) && (callbacks->on_comment != NULL)) {
+        start = mini_parse_skip_space (line->comment + 1, eol, base, space);
+        end = mini_parse_rskip_space (start, eol, base, space);
+
+        result = callbacks->on_comment (start, end - start, parser->lineno, 
+                                        parser->user_data);
+        result = mini_parse_result (parser, result, line, eol);
+    }
 
-    /* Empty line */
-    if (strcmp (start, "") == 0) 
+    return result;
+}
+
+/**
+ *  Parses all the lines of a span of an INI file. The span is classified 
+ *  in 64-byte blocks by mini_scan_block() and the lines are split and 
+ *  tokenized from the resulting bitmaps, without looking at every character.
+ *
+ *  @param parser The running parser, its line number is updated.
+ *  @param buffer Start of the span.
+ *  @param size Size of the span.
+ *  @return The function returns zero if the whole span is parsed, 
+ *          MINI_PARSE_STOPPED or MINI_PARSE_ERROR.
+ */
+static int
+mini_parse_span (MiniParser *parser, const char *buffer, size_t size)
+{
+    char tail[MINI_SCAN_BLOCK_SIZE];
+    MiniScanMasks masks;
+    MiniLine line;
+    const char *base, *p;
+    uint64_t bits;
+    size_t offset;
+    int result;
+
+    /* Buffer can't be NULL */
+    assert ((buffer != NULL) || (size == 0));
+
+    memset (&line, 0, sizeof (MiniLine));
+    line.start = buffer;
+    base = buffer;
+    masks.space = 0;
+
+    for (offset = 0; offset < size; offset += MINI_SCAN_BLOCK_SIZE) {
+        base = &buffer[offset];
+
+        /* The last block is padded with NULs, which aren't structural */
+        if (size - offset >= MINI_SCAN_BLOCK_SIZE)
+            mini_scan_block (base, &masks);
+        else {
+            memset (tail, 0, MINI_SCAN_BLOCK_SIZE);
+            memcpy (tail, base, size - offset);
+            mini_scan_block (tail, &masks);
+        }
+
+        bits = masks.newline | masks.comment | masks.equal | masks.close;
+        while (bits != 0) {
+            p = base + __builtin_ctzll (bits);
+            bits &= bits - 1;
+
+            switch (*p) {
+                case EOL:
+                    result = mini_parse_line (parser, &line, p, base, 
+                                              masks.space);
+                    if (result != 0)
+                        return result;
+
+                    parser->lineno++;
+                    memset (&line, 0, sizeof (MiniLine));
+                    line.start = p + 1;
+                    break;
+
+                case '=':
+                    if ((line.comment == NULL) && (line.equal == NULL))
+                        line.equal = p;
+                    break;
+
+                case ']':
+                    if ((line.comment == NULL) && (line.close == NULL))
+                        line.close = p;
+                    break;
+
+                default:
+                    if (line.comment == NULL)
+                        line.comment = p;
+            }
+        }
+    }
+
+    /* Last line without end of line */
+    if (line.start < buffer + size)
+        return mini_parse_line (parser, &line, buffer + size, base, 
+                                masks.space);
+
+    return 0;
+}
+
+/**
+ *  Gets the current time, in seconds.
+ */
+static double
+mini_parse_get_time (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ *  Callback counting the statistics of a parse: counts a section and 
+ *  times its insertion.
+ */
+static int
+mini_parse_count_section (const char *name, size_t name_len, int lineno, 
+                          void *user_data)
+{
+    MiniParseCounter *counter = (MiniParseCounter *) user_data;
+    double start;
+    int result = 0;
+
+    counter->stats->sections++;
+    counter->last_lineno = lineno;
+
+    if (counter->callbacks->on_section != NULL) {
+        start = mini_parse_get_time ();
+        result = counter->callbacks->on_section (name, name_len, lineno, 
+                                                 counter->user_data);
+        counter->stats->insert_time += mini_parse_get_time () - start;
+    }
+
+    return result;
+}
+
+/**
+ *  Callback counting the statistics of a parse: counts a key-value pair 
+ *  and times its insertion.
+ */
+static int
+mini_parse_count_key_value (const char *key, size_t key_len, 
+                            const char *value, size_t value_len, int lineno,
+                            void *user_data)
+{
+    MiniParseCounter *counter = (MiniParseCounter *) user_data;
+    double start;
+    int result = 0;
+
+    counter->stats->keys++;
+    counter->last_lineno = lineno;
+
+    if (counter->callbacks->on_key_value != NULL) {
+        start = mini_parse_get_time ();
+        result = counter->callbacks->on_key_value (key, key_len, value, 
+                                                   value_len, lineno,
+                                                   counter->user_data);
+        counter->stats->insert_time += mini_parse_get_time () - start;
+    }
+
+    return result;
+}
+
+/**
+ *  Callback counting the statistics of a parse: counts a comment, unless 
+ *  it follows a section or a key-value pair in the same line.
+ */
+static int
+mini_parse_count_comment (const char *comment, size_t comment_len, 
+                          int lineno, void *user_data)
+{
+    MiniParseCounter *counter = (MiniParseCounter *) user_data;
+
+    if (lineno != counter->last_lineno)
+        counter->stats->comment_lines++;
+
+    if (counter->callbacks->on_comment == NULL)
         return 0;
 
-    /* Non empty line */
-    switch (start[0]) {
+    return counter->callbacks->on_comment (comment, comment_len, lineno, 
+                                           counter->user_data);
+}
+
+/**
+ *  Callback counting the statistics of a parse: times an include 
+ *  directive as an insertion.
+ */
+static int
+mini_parse_count_include (const char *path, size_t path_len, int lineno, 
+                          void *user_data)
+{
+    MiniParseCounter *counter = (MiniParseCounter *) user_data;
+    double start;
+    int result;
+
+    counter->last_lineno = lineno;
 
-        /* Section */
-        case '[':
-            /* At the end of the line must be an end of section (']') */
-            end = strchr (start, ']');
-            if ((end == NULL) || (end[1] != '\0'))
-                return -1;
+    start = mini_parse_get_time ();
+    result = counter->callbacks->on_include (path, path_len, lineno, 
+                                             counter->user_data);
+    counter->stats->insert_time += mini_parse_get_time () - start;
 
-            /* Get length of the section */
-            section_len = strlen (start) - 2;
+    return result;
+}
+
+/**
+ *  Callback counting the statistics of a parse: passes a wrong line on.
+ */
+static int
+mini_parse_count_error (const char *line, size_t line_len, int lineno, 
+                        void *user_data)
+{
+    MiniParseCounter *counter = (MiniParseCounter *) user_data;
+
+    return counter->callbacks->on_error (line, line_len, lineno, 
+                                         counter->user_data);
+}
+
+/**
+ *  Prepares a parser to call the given callbacks. With statistics, the 
+ *  callbacks are wrapped by a counter; without them nothing is added to 
+ *  the parse.
+ *
+ *  @param parser The parser, its line number must be set.
+ *  @param counter Counter of the parse, used only with statistics.
+ *  @param callbacks Callbacks of the parse.
+ *  @param user_data Pointer passed to the callbacks.
+ *  @param stats Statistics of the parse, or NULL.
+ */
+static void
+mini_parse_begin (MiniParser *parser, MiniParseCounter *counter, 
+                  const MiniParseCallbacks *callbacks, void *user_data,
+                  MiniParseStats *stats)
+{
+    parser->callbacks = callbacks;
+    parser->user_data = user_data;
+    parser->stats = stats;
+
+    if (stats == NULL)
+        return;
+
+    counter->callbacks = callbacks;
+    counter->user_data = user_data;
+    counter->stats = stats;
+    counter->last_lineno = 0;
+    counter->first_lineno = parser->lineno;
+    counter->read_time = stats->read_time;
+    counter->insert_time = stats->insert_time;
+    counter->start = mini_parse_get_time ();
+
+    counter->wrapper.on_section = mini_parse_count_section;
+    counter->wrapper.on_key_value = mini_parse_count_key_value;
+    counter->wrapper.on_comment = mini_parse_count_comment;
+    counter->wrapper.on_error = (callbacks->on_error != NULL) ? 
+                                mini_parse_count_error : NULL;
+    counter->wrapper.on_include = (callbacks->on_include != NULL) ? 
+                                  mini_parse_count_include : NULL;
+
+    parser->callbacks = &counter->wrapper;
+    parser->user_data = counter;
+}
+
+/**
+ *  Adds the lines and the tokenizing time of a finished parse to its 
+ *  statistics, if any: the time not spent reading or inserting.
+ *
+ *  @param parser The parser.
+ *  @param counter Counter of the parse.
+ *  @param buffer Parsed buffer, or NULL if the lines were readed.
+ *  @param size Size of the buffer.
+ */
+static void
+mini_parse_end (MiniParser *parser, MiniParseCounter *counter, 
+                const char *buffer, size_t size)
+{
+    MiniParseStats *stats = parser->stats;
+
+    if (stats == NULL)
+        return;
+
+    stats->lines += parser->lineno - counter->first_lineno;
+
+    /* Last line without end of line */
+    if ((buffer != NULL) && (size > 0) && (buffer[size - 1] != EOL))
+        stats->lines++;
+
+    stats->tokenize_time += mini_parse_get_time () - counter->start - 
+                            (stats->read_time - counter->read_time) - 
+                            (stats->insert_time - counter->insert_time);
+}
+
+/**
+ *  Adds the statistics of a parse to other ones.
+ */
+static void
+mini_parse_stats_add (MiniParseStats *stats, const MiniParseStats *other)
+{
+    stats->bytes_read += other->bytes_read;
+    stats->lines += other->lines;
+    stats->sections += other->sections;
+    stats->keys += other->keys;
+    stats->comment_lines += other->comment_lines;
+    stats->allocations += other->allocations;
+    stats->bytes_allocated += other->bytes_allocated;
+    stats->read_time += other->read_time;
+    stats->tokenize_time += other->tokenize_time;
+    stats->insert_time += other->insert_time;
+}
+
+/**
+ *  Starts counting the allocations of the calling thread, with any 
+ *  allocator, for the statistics of a parse.
+ *
+ *  @param stats Statistics of the parse, or NULL to count nothing.
+ *  @param count A MiniAllocCount structure receiving the counts.
+ *  @return The return value is the previous counter of the thread, to be 
+ *          given to mini_parse_count_end().
+ */
+static MiniAllocCount *
+mini_parse_count_begin (MiniParseStats *stats, MiniAllocCount *count)
+{
+    if (stats == NULL)
+        return NULL;
+
+    count->allocations = 0;
+    count->bytes = 0;
+
+    return mini_alloc_count (count);
+}
+
+/**
+ *  Stops counting the allocations of the calling thread, adding them to 
+ *  the statistics of a parse.
+ *
+ *  @param stats Statistics of the parse, or NULL.
+ *  @param count The MiniAllocCount given to mini_parse_count_begin().
+ *  @param previous The counter returned by mini_parse_count_begin().
+ */
+static void
+mini_parse_count_end (MiniParseStats *stats, const MiniAllocCount *count,
+                      MiniAllocCount *previous)
+{
+    if (stats == NULL)
+        return;
+
+    mini_alloc_count (previous);
 
-            /* Empty section */
-            if (section_len == 0)
-                return -1;
+    stats->allocations += count->allocations;
+    stats->bytes_allocated += count->bytes;
+}
+
+/**
+ *  Parses the lines readed from a line reader. With statistics, the time 
+ *  spent reading the lines and the readed bytes are added to them.
+ *
+ *  @param parser The running parser, its line number is updated.
+ *  @param reader A MiniReader structure.
+ *  @return The function returns zero if the whole input is parsed, 
+ *          MINI_PARSE_STOPPED or MINI_PARSE_ERROR.
+ */
+static int
+mini_parse_lines (MiniParser *parser, MiniReader *reader)
+{
+    MiniParseStats *stats = parser->stats;
+    uint64_t bytes_read = reader->bytes_read;
+    double start = 0;
+    char *line;
+    size_t len;
+    int result = 0;
 
-            /* Get section string */
-            section = (char *) malloc ((section_len + 1) * sizeof (char));
-            if (section == NULL)
-                return -1;
+    for (;;) {
+        if (stats != NULL)
+            start = mini_parse_get_time ();
 
-            strncpy (section, &start[1], section_len);
-            section[section_len] = '\0';
+        line = mini_reader_readline (reader, &len);
 
-            mini_file_tmp = mini_file_insert_section (mini_file, section);
-            if (mini_file_tmp == NULL)
-                return -1;
+        if (stats != NULL)
+            stats->read_time += mini_parse_get_time () - start;
 
+        if (line == NULL)
             break;
 
-        /* Comment */
-        case ';':
-        case '#':
-            /* Process comments here */
+        result = mini_parse_span (parser, line, len);
+        if (result != 0)
             break;
 
-        default:
-            /* Between key and value must be an equality symbol ('=') */
-            equal = strchr (start, '=');
-            if ((equal == NULL) || (start == equal) || (equal[1] == '\0'))
-                return -1;
+        parser->lineno++;
+    }
+
+    if (stats != NULL)
+        stats->bytes_read += reader->bytes_read - bytes_read;
+
+    if ((result == 0) && reader->error)
+        return MINI_PARSE_ERROR;
+
+    return result;
+}
 
-            /* Get length of the key string */
-            for (key_len = 0; start[key_len] != '='; key_len++)
-                ;
+/**
+ *  Callback building the tree of a MiniFile: adds a section.
+ */
+static int
+mini_parse_tree_section (const char *name, size_t name_len, int lineno, 
+                         void *user_data)
+{
+    MiniParseTree *tree = (MiniParseTree *) user_data;
 
-			/* Ignore whitespaces at right from key */
-			while (isspace (start[key_len - 1]))
-				key_len--;
+    if (mini_file_add_section (tree->mini_file, name, name_len, 
+                               tree->borrow) == NULL)
+        return -1;
 
-            /* Get key string */
-            key = (char *) malloc ((key_len + 1) * sizeof (char));
-            if (key == NULL)
-                return -1;
+    return 0;
+}
 
-            strncpy (key, start, key_len);
-            key[key_len] = '\0';
+/**
+ *  Callback building the tree of a MiniFile: adds a key-value pair.
+ */
+static int
+mini_parse_tree_key_value (const char *key, size_t key_len, const char *value,
+                           size_t value_len, int lineno, void *user_data)
+{
+    MiniParseTree *tree = (MiniParseTree *) user_data;
+    SectionData *data;
 
-			/* Ignore whitespaces at left from value */
-			while (isspace (equal[1]))
-				equal++;
+    data = mini_file_add_key_and_value (tree->mini_file, key, key_len, value, 
+                                        value_len, tree->borrow);
+    if (data == NULL)
+        return -1;
 
-            /* Get length of the value string */
-            value_len = strlen (equal) - 1;
+    data->lineno = lineno;
 
-            /* Get value string */
-            value = (char *) malloc ((value_len + 1) * sizeof (char));
-            if (value == NULL)
-                return -1;
+    return 0;
+}
 
-            strncpy (value, &equal[1], value_len);
-            value[value_len] = '\0';
+/**
+ *  Callback building the tree of a MiniFile: adds the sections and keys 
+ *  of an included file.
+ */
+static int
+mini_parse_tree_include (const char *path, size_t path_len, int lineno, 
+                         void *user_data)
+{
+    MiniParseTree *tree = (MiniParseTree *) user_data;
 
-            mini_file_tmp = mini_file_insert_key_and_value (mini_file, key, 
-                                                            value);
-            if (mini_file_tmp == NULL)
-                return -1;
-    }
+    if (mini_include (tree->mini_file, tree->includes, path, path_len) < 0)
+        return -1;
 
     return 0;
 }
 
+static const MiniParseCallbacks mini_parse_tree_callbacks = {
+    mini_parse_tree_section,
+    mini_parse_tree_key_value,
+    NULL,
+    NULL,
+    NULL
+};
+
+static const MiniParseCallbacks mini_parse_include_callbacks = {
+    mini_parse_tree_section,
+    mini_parse_tree_key_value,
+    NULL,
+    NULL,
+    mini_parse_tree_include
+};
 
 /**
- *  Parses a given INI file generating a MiniFile structure.
+ *  Parses the lines readed from a line reader into a MiniFile, copying 
+ *  the section, key and value strings.
+ *
+ *  @param mini_file A MiniFile structure to save all the parsed data.
+ *  @param reader A MiniReader structure.
+ *  @param includes The file being parsed, to resolve its include 
+ *         directives, or NULL if they aren't allowed.
+ *  @param stats Statistics of the parse, or NULL.
+ *  @return The function returns zero if the whole input is parsed, 
+ *          or MINI_PARSE_ERROR.
+ */
+static int
+mini_parse_reader_into (MiniFile *mini_file, MiniReader *reader, 
+                        const MiniIncludeStack *includes, 
+                        MiniParseStats *stats)
+{
+    MiniParseCounter counter;
+    MiniParser parser;
+    MiniParseTree tree;
+    int result;
+
+    /* Reader can't be NULL */
+    assert (reader != NULL);
+
+    tree.mini_file = mini_file;
+    tree.borrow = MINI_COPY;
+    tree.includes = includes;
+
+    parser.lineno = 1;
+    mini_parse_begin (&parser, &counter, 
+                      (includes != NULL) ? &mini_parse_include_callbacks : 
+                                           &mini_parse_tree_callbacks,
+                      &tree, stats);
+    result = mini_parse_lines (&parser, reader);
+    mini_parse_end (&parser, &counter, NULL, 0);
+
+    return result;
+}
+
+/**
+ *  Parses a given INI file into a new MiniFile, copying the section, key 
+ *  and value strings.
  *
  *  @param file_name INI file path.
+ *  @param allocator Allocator of the new MiniFile, or NULL.
+ *  @param stats Statistics of the parse, or NULL.
+ *  @param strict Non-zero to give no MiniFile if a line is wrong.
  *  @return The return value is a MiniFile structure generated from the 
  *          given INI file.
  *          The function returns NULL, if the given INI file can't be parsed.
  */
-MiniFile *
-mini_parse_file (const char *file_name)
+static MiniFile *
+mini_parse_file_full (const char *file_name, const MiniAllocator *allocator,
+                      MiniParseStats *stats, int strict)
 {
-    char *line;
-    FILE *file;
+    MiniIncludeStack includes;
+    MiniAllocCount count, *previous;
+    MiniReader *reader;
     MiniFile *mini_file;
-	int lineno = 1;
 
     /* Filename can't be NULL */
     assert (file_name != NULL);
 
-    /* Create an empty MiniFile structure */
-    mini_file = mini_file_new (file_name);
-    if (mini_file == NULL)
+    previous = mini_parse_count_begin (stats, &count);
+
+    reader = mini_reader_open (file_name);
+    if (reader == NULL) {
+        mini_parse_count_end (stats, &count, previous);
         return NULL;
+    }
 
-    file = fopen (file_name, "r");
-    if (file == NULL) {
+    mini_include_stack_init (&includes, file_name);
+
+    mini_file = mini_file_new_with_allocator (file_name, allocator);
+    if ((mini_file != NULL) && 
+        (mini_parse_reader_into (mini_file, reader, &includes, 
+                                 stats) != 0) && strict) {
         mini_file_free (mini_file);
-        return NULL;
+        mini_file = NULL;
     }
 
-    /* Read line and parse it */
-    line = mini_readline (file);
-    while (!feof (file) && (line != NULL)) {
+    mini_reader_free (reader);
 
-        if (mini_parse_line (mini_file, line) < 0) {
-			fprintf(stderr, "parse error at line %d\n", lineno);
-            break;
-		}
+    mini_parse_count_end (stats, &count, previous);
+
+    return mini_file;
+}
+
+/**
+ *  Parses all the lines of a buffer into a MiniFile, borrowing the section,
+ *  key and value strings from the buffer.
+ *
+ *  @param mini_file A MiniFile structure to save all the parsed data.
+ *  @param buffer A buffer with the contents of an INI file.
+ *  @param size Size of the buffer.
+ *  @param stats Statistics of the parse, or NULL.
+ *  @param includes The file being parsed, to resolve its include 
+ *         directives, or NULL if they aren't allowed.
+ *  @return The function returns zero if the whole buffer is parsed, 
+ *          or MINI_PARSE_ERROR.
+ */
+static int
+mini_parse_buffer_into (MiniFile *mini_file, const char *buffer, size_t size,
+                        MiniParseStats *stats, 
+                        const MiniIncludeStack *includes)
+{
+    MiniParseCounter counter;
+    MiniParser parser;
+    MiniParseTree tree;
+    int result;
+
+    tree.mini_file = mini_file;
+    tree.borrow = MINI_BORROW;
+    tree.includes = includes;
 
-        line = mini_readline (file);
-		lineno++;
+    parser.lineno = 1;
+    mini_parse_begin (&parser, &counter, 
+                      (includes != NULL) ? &mini_parse_include_callbacks : 
+                                           &mini_parse_tree_callbacks,
+                      &tree, stats);
+    result = mini_parse_span (&parser, buffer, size);
+    mini_parse_end (&parser, &counter, buffer, size);
+
+    if (stats != NULL)
+        stats->bytes_read += size;
+
+    return result;
+}
+
+/**
+ *  Maps a file into memory, read-only.
+ *
+ *  @param file_name File path.
+ *  @param mapping Pointer receiving the mapping, NULL for empty files.
+ *  @param size Pointer receiving the size of the file.
+ *  @return The function returns a negative number, if the file can't 
+ *          be mapped.
+ */
+static int
+mini_parse_map (const char *file_name, void **mapping, size_t *size)
+{
+    struct stat st;
+    int fd;
+
+    fd = open (file_name, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    if (fstat (fd, &st) < 0) {
+        close (fd);
+        return -1;
     }
 
-    fclose (file);
+    /* Empty files can't be mapped */
+    *mapping = NULL;
+    *size = st.st_size;
+    if (st.st_size > 0) {
+        *mapping = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (*mapping == MAP_FAILED) {
+            close (fd);
+            return -1;
+        }
 
-    return mini_file;
+        madvise (*mapping, st.st_size, MADV_SEQUENTIAL);
+    }
+
+    close (fd);
+
+    return 0;
 }
 
+/**
+ *  Callback building the tree of a chunk: adds a key-value pair, 
+ *  remembering the first one before any section of the chunk.
+ */
+static int
+mini_parse_chunk_key_value (const char *key, size_t key_len, 
+                            const char *value, size_t value_len, int lineno,
+                            void *user_data)
+{
+    MiniParseChunk *chunk = (MiniParseChunk *) user_data;
+
+    if ((chunk->continued_lineno == 0) && 
+        (chunk->tree.mini_file->last == chunk->continued))
+        chunk->continued_lineno = lineno;
+
+    return mini_parse_tree_key_value (key, key_len, value, value_len, lineno,
+                                      &chunk->tree);
+}
+
+/**
+ *  Callback building the tree of a chunk: adds a section.
+ */
+static int
+mini_parse_chunk_section (const char *name, size_t name_len, int lineno, 
+                          void *user_data)
+{
+    MiniParseChunk *chunk = (MiniParseChunk *) user_data;
+
+    return mini_parse_tree_section (name, name_len, lineno, &chunk->tree);
+}
+
+/**
+ *  Callback of a chunk: stops at an include. The included files must be 
+ *  parsed in file order, so the whole file is parsed again without chunks.
+ */
+static int
+mini_parse_chunk_include (const char *path, size_t path_len, int lineno, 
+                          void *user_data)
+{
+    MiniParseChunk *chunk = (MiniParseChunk *) user_data;
+
+    chunk->include_lineno = lineno;
+
+    return MINI_PARSE_STOPPED;
+}
+
+/**
+ *  Callback of a chunk: stops at the first wrong line, which is reported 
+ *  once the previous chunks are merged.
+ */
+static int
+mini_parse_chunk_error (const char *line, size_t line_len, int lineno, 
+                        void *user_data)
+{
+    MiniParseChunk *chunk = (MiniParseChunk *) user_data;
+
+    chunk->error_lineno = lineno;
+
+    return 1;
+}
+
+static const MiniParseCallbacks mini_parse_chunk_callbacks = {
+    mini_parse_chunk_section,
+    mini_parse_chunk_key_value,
+    NULL,
+    mini_parse_chunk_error,
+    mini_parse_chunk_include
+};
+
+/**
+ *  Parses a chunk of a file into a MiniFile of its own, borrowing the 
+ *  strings from the chunk. The keys before the first section of the chunk 
+ *  are added to an unnamed section, which continues the last section of 
+ *  the previous chunk.
+ *
+ *  @param arg A MiniParseChunk structure.
+ *  @return The return value is NULL.
+ */
+static void *
+mini_parse_chunk (void *arg)
+{
+    MiniParseChunk *chunk = (MiniParseChunk *) arg;
+    MiniAllocCount count, *previous;
+    MiniParseCounter counter;
+    MiniParser parser;
+
+    /* Every thread counts its own allocations */
+    previous = mini_parse_count_begin (chunk->stats, &count);
+
+    chunk->tree.mini_file = mini_file_new (MINI_BUFFER_NAME);
+    if (chunk->tree.mini_file == NULL) {
+        mini_parse_count_end (chunk->stats, &count, previous);
+        return NULL;
+    }
+
+    chunk->tree.borrow = MINI_BORROW;
+    chunk->tree.includes = NULL;
+    chunk->continued = mini_file_add_section (chunk->tree.mini_file, "", 0,
+                                              MINI_BORROW);
+    if (chunk->continued == NULL) {
+        mini_file_free (chunk->tree.mini_file);
+        chunk->tree.mini_file = NULL;
+        mini_parse_count_end (chunk->stats, &count, previous);
+        return NULL;
+    }
+
+    parser.lineno = chunk->first_lineno;
+    mini_parse_begin (&parser, &counter, &mini_parse_chunk_callbacks, chunk, 
+                      chunk->stats);
+    mini_parse_span (&parser, chunk->buffer, chunk->size);
+    mini_parse_end (&parser, &counter, chunk->buffer, chunk->size);
+
+    mini_parse_count_end (chunk->stats, &count, previous);
+
+    return NULL;
+}
+
+/**
+ *  Counts the lines of a chunk of a file. Every chunk but the last one 
+ *  ends with an end of line.
+ *
+ *  @param arg A MiniParseChunk structure.
+ *  @return The return value is NULL.
+ */
+static void *
+mini_parse_chunk_count (void *arg)
+{
+    MiniParseChunk *chunk = (MiniParseChunk *) arg;
+    const char *p, *end;
+
+    chunk->num_lines = 0;
+    end = chunk->buffer + chunk->size;
+    for (p = chunk->buffer; (p < end) && 
+         ((p = memchr (p, EOL, end - p)) != NULL); p++)
+        chunk->num_lines++;
+
+    return NULL;
+}
+
+/**
+ *  Runs a function on every chunk of a file, each one on a thread of its 
+ *  own but the first one, which is run by the calling thread. Chunks 
+ *  without thread are run by the calling thread too.
+ *
+ *  @param chunks Chunks of the file.
+ *  @param num_chunks Number of chunks.
+ *  @param threads Buffer of num_chunks threads.
+ *  @param run Function run on every chunk.
+ */
+static void
+mini_parse_run_chunks (MiniParseChunk *chunks, unsigned int num_chunks,
+                       pthread_t *threads, void *(*run) (void *))
+{
+    unsigned int num_threads, i;
+
+    num_threads = 0;
+    for (i = 1; i < num_chunks; i++) {
+        if (pthread_create (&threads[i], NULL, run, &chunks[i]) != 0)
+            break;
+        num_threads++;
+    }
+
+    run (&chunks[0]);
+
+    /* Chunks without thread */
+    for (i = num_threads + 1; i < num_chunks; i++)
+        run (&chunks[i]);
+
+    for (i = 1; i <= num_threads; i++)
+        pthread_join (threads[i], NULL);
+}
+
+/**
+ *  Merges the MiniFiles of the parsed chunks into a new MiniFile, in file 
+ *  order. As mini_parse_file() does, the merge stops at the first wrong 
+ *  line, which is printed.
+ *
+ *  @param name Name of the new MiniFile.
+ *  @param chunks Parsed chunks, their MiniFiles are consumed.
+ *  @param num_chunks Number of chunks.
+ *  @return The return value is the merged MiniFile.
+ *          The function returns NULL, if a chunk couldn't be parsed.
+ */
+static MiniFile *
+mini_parse_merge (const char *name, MiniParseChunk *chunks, 
+                  unsigned int num_chunks)
+{
+    MiniFile *mini_file = NULL;
+    unsigned int i;
+
+    for (i = 0; i < num_chunks; i++)
+        if (chunks[i].tree.mini_file == NULL)
+            break;
+
+    if (i == num_chunks)
+        mini_file = mini_file_new (name);
+
+    for (i = 0; (mini_file != NULL) && (i < num_chunks); i++) {
+        /* Keys without section */
+        if ((chunks[i].continued_lineno != 0) && (mini_file->last == NULL)) {
+            fprintf (stderr, "parse error at line %d\n", 
+                     chunks[i].continued_lineno);
+            break;
+        }
+
+        if (mini_file_append (mini_file, chunks[i].tree.mini_file, 
+                              chunks[i].continued) < 0)
+            break;
+        chunks[i].tree.mini_file = NULL;
+
+        if (chunks[i].error_lineno != 0) {
+            fprintf (stderr, "parse error at line %d\n", 
+                     chunks[i].error_lineno);
+            break;
+        }
+    }
+
+    /* Chunks not merged */
+    for (i = 0; i < num_chunks; i++)
+        mini_file_free (chunks[i].tree.mini_file);
+
+    return mini_file;
+}
+
+/**
+ *  Parses the lines readed from a line reader (a file, a pipe, a socket...)
+ *  without building a MiniFile: every section, key-value pair and comment 
+ *  is passed to the given callbacks, as a string view valid only during 
+ *  the call. The memory used doesn't depend on the size of the input.
+ *
+ *  A callback returns zero to go on, a positive number to stop the parse 
+ *  or a negative number if the line is wrong (the parse goes on as 
+ *  on_error says). Without on_error, the first wrong line is printed and 
+ *  stops the parse.
+ *
+ *  A line "!include path" is passed to on_include, or it's a wrong line 
+ *  if on_include is NULL. mini_parse_file() and the other functions 
+ *  parsing a file by its name include the given file (its path relative 
+ *  to the directory of the including file): mini_parse_file_parallel() 
+ *  parses a file with includes on the calling thread, and 
+ *  mini_file_open_lazy() parses it whole when it's opened. The functions 
+ *  parsing a buffer or a reader don't allow includes.
+ *
+ *  @param reader A MiniReader structure.
+ *  @param callbacks Callbacks called for every parsed element, any of 
+ *         them can be NULL.
+ *  @param user_data Pointer passed to the callbacks.
+ *  @return The function returns zero if the whole input is parsed, 
+ *          MINI_PARSE_STOPPED if a callback stopped the parse or 
+ *          MINI_PARSE_ERROR if a line or the input can't be parsed.
+ */
+int
+mini_parse_stream (MiniReader *reader, const MiniParseCallbacks *callbacks,
+                   void *user_data)
+{
+    MiniParser parser;
+
+    /* Reader and callbacks can't be NULL */
+    assert (reader != NULL);
+    assert (callbacks != NULL);
+
+    parser.callbacks = callbacks;
+    parser.user_data = user_data;
+    parser.lineno = 1;
+    parser.stats = NULL;
+
+    return mini_parse_lines (&parser, reader);
+}
+
+/**
+ *  Parses an INI file held in memory without building a MiniFile, like 
+ *  mini_parse_stream() does. The string views point into the buffer.
+ *
+ *  @param buffer A buffer with the contents of an INI file.
+ *  @param size Size of the buffer.
+ *  @param callbacks Callbacks called for every parsed element, any of 
+ *         them can be NULL.
+ *  @param user_data Pointer passed to the callbacks.
+ *  @return The function returns zero if the whole buffer is parsed, 
+ *          MINI_PARSE_STOPPED if a callback stopped the parse or 
+ *          MINI_PARSE_ERROR if a line can't be parsed.
+ */
+int
+mini_parse_buffer_stream (const char *buffer, size_t size, 
+                          const MiniParseCallbacks *callbacks, void *user_data)
+{
+    MiniParser parser;
+
+    /* Callbacks can't be NULL */
+    assert (callbacks != NULL);
+
+    parser.callbacks = callbacks;
+    parser.user_data = user_data;
+    parser.lineno = 1;
+    parser.stats = NULL;
+
+    return mini_parse_span (&parser, buffer, size);
+}
+
+/**
+ *  Parses a given INI file generating a MiniFile structure.
+ *
+ *  @param file_name INI file path.
+ *  @return The return value is a MiniFile structure generated from the 
+ *          given INI file.
+ *          The function returns NULL, if the given INI file can't be parsed.
+ */
+MiniFile *
+mini_parse_file (const char *file_name)
+{
+    return mini_parse_file_stats (file_name, NULL);
+}
+
+/**
+ *  Parses a given INI file generating a MiniFile structure, as 
+ *  mini_parse_file() does, and collects the statistics of the parse. 
+ *  Without statistics nothing is timed nor counted.
+ *
+ *  Timing the parse makes it slower: every line and every section and 
+ *  key are timed.
+ *
+ *  @param file_name INI file path.
+ *  @param stats MiniParseStats structure receiving the statistics, 
+ *         or NULL.
+ *  @return The return value is a MiniFile structure generated from the 
+ *          given INI file.
+ *          The function returns NULL, if the given INI file can't be parsed.
+ */
+MiniFile *
+mini_parse_file_stats (const char *file_name, MiniParseStats *stats)
+{
+    if (stats != NULL)
+        memset (stats, 0, sizeof (MiniParseStats));
+
+    return mini_parse_file_full (file_name, NULL, stats, 0);
+}
+
+/**
+ *  Parses a given INI file generating a MiniFile structure, as 
+ *  mini_parse_file() does, whose memory comes from the given allocator 
+ *  (see mini_file_new_with_allocator()).
+ *
+ *  @param file_name INI file path.
+ *  @param allocator A MiniAllocator structure, which is copied, or NULL 
+ *         for the allocator of the library.
+ *  @return The return value is a MiniFile structure generated from the 
+ *          given INI file.
+ *          The function returns NULL, if the given INI file can't be parsed.
+ */
+MiniFile *
+mini_parse_file_with_allocator (const char *file_name, 
+                                const MiniAllocator *allocator)
+{
+    return mini_parse_file_full (file_name, allocator, NULL, 0);
+}
+
+/**
+ *  Parses a given INI file generating a MiniFile structure, as 
+ *  mini_parse_file() does, but a file with a wrong line gives no MiniFile 
+ *  instead of the sections before the wrong line.
+ *
+ *  @param file_name INI file path.
+ *  @return The return value is a MiniFile structure generated from the 
+ *          given INI file.
+ *          The function returns NULL, if the given INI file can't be 
+ *          read or any of its lines can't be parsed.
+ */
+MiniFile *
+mini_parse_file_strict (const char *file_name)
+{
+    return mini_parse_file_strict_stats (file_name, NULL);
+}
+
+/**
+ *  Parses a given INI file generating a MiniFile structure, as 
+ *  mini_parse_file_strict() does, and collects the statistics of the 
+ *  parse, see mini_parse_file_stats().
+ *
+ *  @param file_name INI file path.
+ *  @param stats MiniParseStats structure receiving the statistics, 
+ *         or NULL.
+ *  @return The return value is a MiniFile structure generated from the 
+ *          given INI file.
+ *          The function returns NULL, if the given INI file can't be 
+ *          read or any of its lines can't be parsed.
+ */
+MiniFile *
+mini_parse_file_strict_stats (const char *file_name, MiniParseStats *stats)
+{
+    if (stats != NULL)
+        memset (stats, 0, sizeof (MiniParseStats));
+
+    return mini_parse_file_full (file_name, NULL, stats, 1);
+}
+
+/**
+ *  Parses the lines readed from a line reader (a file, a pipe, a socket...)
+ *  generating a MiniFile structure.
+ *
+ *  @param reader A MiniReader structure.
+ *  @return The return value is a MiniFile structure generated from the 
+ *          readed lines.
+ *          The function returns NULL, if the MiniFile can't be created.
+ */
+MiniFile *
+mini_parse_reader (MiniReader *reader)
+{
+    return mini_parse_reader_stats (reader, NULL);
+}
+
+/**
+ *  Parses the lines readed from a line reader generating a MiniFile 
+ *  structure, as mini_parse_reader() does, and collects the statistics of 
+ *  the parse, see mini_parse_file_stats().
+ *
+ *  @param reader A MiniReader structure.
+ *  @param stats MiniParseStats structure receiving the statistics, 
+ *         or NULL.
+ *  @return The return value is a MiniFile structure generated from the 
+ *          readed lines.
+ *          The function returns NULL, if the MiniFile can't be created.
+ */
+MiniFile *
+mini_parse_reader_stats (MiniReader *reader, MiniParseStats *stats)
+{
+    MiniAllocCount count, *previous;
+    MiniFile *mini_file;
+
+    /* Reader can't be NULL */
+    assert (reader != NULL);
+
+    if (stats != NULL)
+        memset (stats, 0, sizeof (MiniParseStats));
+
+    previous = mini_parse_count_begin (stats, &count);
+
+    mini_file = mini_file_new (MINI_STREAM_NAME);
+    if (mini_file != NULL)
+        mini_parse_reader_into (mini_file, reader, NULL, stats);
+
+    mini_parse_count_end (stats, &count, previous);
+
+    return mini_file;
+}
+
+/**
+ *  Parses an INI file held in memory generating a MiniFile structure. 
+ *  No string is copied: the sections, keys and values reference the 
+ *  buffer, so it must outlive the returned MiniFile.
+ *
+ *  @param buffer A buffer with the contents of an INI file.
+ *  @param size Size of the buffer.
+ *  @return The return value is a MiniFile structure generated from the 
+ *          given buffer.
+ *          The function returns NULL, if the MiniFile can't be created.
+ */
+MiniFile *
+mini_parse_buffer (const char *buffer, size_t size)
+{
+    return mini_parse_buffer_stats (buffer, size, NULL);
+}
+
+/**
+ *  Parses an INI file held in memory generating a MiniFile structure, as 
+ *  mini_parse_buffer() does, and collects the statistics of the parse, 
+ *  see mini_parse_file_stats(). Nothing is readed: the buffer size is 
+ *  counted as readed bytes.
+ *
+ *  @param buffer A buffer with the contents of an INI file.
+ *  @param size Size of the buffer.
+ *  @param stats MiniParseStats structure receiving the statistics, 
+ *         or NULL.
+ *  @return The return value is a MiniFile structure generated from the 
+ *          given buffer.
+ *          The function returns NULL, if the MiniFile can't be created.
+ */
+MiniFile *
+mini_parse_buffer_stats (const char *buffer, size_t size, 
+                         MiniParseStats *stats)
+{
+    MiniAllocCount count, *previous;
+    MiniFile *mini_file;
+
+    /* Buffer can't be NULL */
+    assert ((buffer != NULL) || (size == 0));
+
+    if (stats != NULL)
+        memset (stats, 0, sizeof (MiniParseStats));
+
+    previous = mini_parse_count_begin (stats, &count);
+
+    mini_file = mini_file_new (MINI_BUFFER_NAME);
+    if (mini_file != NULL)
+        mini_parse_buffer_into (mini_file, buffer, size, stats, NULL);
+
+    mini_parse_count_end (stats, &count, previous);
+
+    return mini_file;
+}
+
+/**
+ *  Parses a given INI file generating a MiniFile structure, without 
+ *  copying it: the file is mapped into memory and the sections, keys and 
+ *  values reference the mapping, which lives as long as the MiniFile. 
+ *  Included files are copied, as mini_parse_file() does.
+ *
+ *  @param file_name INI file path.
+ *  @return The return value is a MiniFile structure generated from the 
+ *          given INI file.
+ *          The function returns NULL, if the given INI file can't be parsed.
+ */
+MiniFile *
+mini_parse_mmap (const char *file_name)
+{
+    return mini_parse_mmap_stats (file_name, NULL);
+}
+
+/**
+ *  Parses a given INI file generating a MiniFile structure, as 
+ *  mini_parse_mmap() does, and collects the statistics of the parse, 
+ *  see mini_parse_file_stats(). The pages of the mapping are readed 
+ *  while the lines are tokenized, so that time is part of tokenizing.
+ *
+ *  @param file_name INI file path.
+ *  @param stats MiniParseStats structure receiving the statistics, 
+ *         or NULL.
+ *  @return The return value is a MiniFile structure generated from the 
+ *          given INI file.
+ *          The function returns NULL, if the given INI file can't be parsed.
+ */
+MiniFile *
+mini_parse_mmap_stats (const char *file_name, MiniParseStats *stats)
+{
+    MiniIncludeStack includes;
+    MiniAllocCount count, *previous;
+    MiniFile *mini_file;
+    void *mapping;
+    size_t size;
+    double start = 0;
+
+    /* Filename can't be NULL */
+    assert (file_name != NULL);
+
+    if (stats != NULL) {
+        memset (stats, 0, sizeof (MiniParseStats));
+        start = mini_parse_get_time ();
+    }
+
+    if (mini_parse_map (file_name, &mapping, &size) < 0)
+        return NULL;
+
+    if (stats != NULL)
+        stats->read_time = mini_parse_get_time () - start;
+
+    previous = mini_parse_count_begin (stats, &count);
+
+    mini_file = mini_file_new (file_name);
+    if (mini_file != NULL) {
+        mini_file->mapping = mapping;
+        mini_file->mapping_size = size;
+
+        mini_include_stack_init (&includes, file_name);
+        mini_parse_buffer_into (mini_file, (const char *) mapping, size, 
+                                stats, &includes);
+    } else if (mapping != NULL)
+        munmap (mapping, size);
+
+    mini_parse_count_end (stats, &count, previous);
+
+    return mini_file;
+}
+
+/**
+ *  Parses a given INI file generating a MiniFile structure, splitting it 
+ *  in chunks at ends of line which are parsed at the same time by a pool 
+ *  of threads. Every chunk builds its own sections and their indexes, so 
+ *  only the chunks are merged afterwards, in file order. The result is 
+ *  the same as mini_parse_mmap() gives: the strings reference the mapping 
+ *  of the file. A file with include directives is parsed again by the 
+ *  calling thread, as mini_parse_mmap() does.
+ *
+ *  Files smaller than MINI_PARSE_MIN_CHUNK_SIZE bytes per worker use less 
+ *  workers.
+ *
+ *  @param file_name INI file path.
+ *  @param num_workers Number of threads parsing the file, zero to use 
+ *         one per online processor.
+ *  @return The return value is a MiniFile structure generated from the 
+ *          given INI file.
+ *          The function returns NULL, if the given INI file can't be parsed.
+ */
+MiniFile *
+mini_parse_file_parallel (const char *file_name, unsigned int num_workers)
+{
+    return mini_parse_file_parallel_stats (file_name, num_workers, NULL);
+}
+
+/**
+ *  Parses a given INI file generating a MiniFile structure, as 
+ *  mini_parse_file_parallel() does, and collects the statistics of the 
+ *  parse, see mini_parse_file_stats(). The times of the workers are added 
+ *  up, so they may be longer than the parse; merging the chunks is part 
+ *  of inserting.
+ *
+ *  @param file_name INI file path.
+ *  @param num_workers Number of threads parsing the file, zero to use 
+ *         one per online processor.
+ *  @param stats MiniParseStats structure receiving the statistics, 
+ *         or NULL.
+ *  @return The return value is a MiniFile structure generated from the 
+ *          given INI file.
+ *          The function returns NULL, if the given INI file can't be parsed.
+ */
+MiniFile *
+mini_parse_file_parallel_stats (const char *file_name, 
+                                unsigned int num_workers, 
+                                MiniParseStats *stats)
+{
+    MiniIncludeStack includes;
+    MiniAllocCount count, *previous;
+    MiniParseChunk *chunks;
+    MiniParseStats *chunk_stats = NULL;
+    MiniFile *mini_file;
+    pthread_t *threads;
+    unsigned int num_chunks, i;
+    int included = 0;
+    const char *buffer, *p;
+    void *mapping;
+    size_t size, offset, end;
+    double start = 0;
+    long online;
+
+    /* Filename can't be NULL */
+    assert (file_name != NULL);
+
+    if (num_workers == 0) {
+        online = sysconf (_SC_NPROCESSORS_ONLN);
+        num_workers = (online > 0) ? (unsigned int) online : 1;
+    }
+
+    if (stats != NULL) {
+        memset (stats, 0, sizeof (MiniParseStats));
+        start = mini_parse_get_time ();
+    }
+
+    if (mini_parse_map (file_name, &mapping, &size) < 0)
+        return NULL;
+
+    if (stats != NULL)
+        stats->read_time = mini_parse_get_time () - start;
+
+    num_chunks = num_workers;
+    if (size / MINI_PARSE_MIN_CHUNK_SIZE < num_chunks)
+        num_chunks = (size / MINI_PARSE_MIN_CHUNK_SIZE) + 1;
+
+    /* The workers count theirs in their chunk statistics */
+    previous = mini_parse_count_begin (stats, &count);
+
+    chunks = (MiniParseChunk *) mini_calloc (NULL, num_chunks, 
+                                             sizeof (MiniParseChunk));
+    threads = (pthread_t *) mini_malloc (NULL, num_chunks * sizeof (pthread_t));
+    if (stats != NULL)
+        chunk_stats = (MiniParseStats *) mini_calloc (NULL, num_chunks, 
+                                                      sizeof (MiniParseStats));
+    if ((chunks == NULL) || (threads == NULL) || 
+        ((stats != NULL) && (chunk_stats == NULL))) {
+        mini_free (NULL, chunks);
+        mini_free (NULL, threads);
+        mini_free (NULL, chunk_stats);
+        if (mapping != NULL)
+            munmap (mapping, size);
+        mini_parse_count_end (stats, &count, previous);
+        return NULL;
+    }
+
+    /* Split the file after the first end of line of every chunk boundary */
+    buffer = (const char *) mapping;
+    offset = 0;
+    for (i = 0; i < num_chunks; i++) {
+        end = size / num_chunks * (i + 1);
+        if (end < offset)
+            end = offset;
+
+        if (i == num_chunks - 1)
+            end = size;
+        else {
+            p = memchr (&buffer[end], EOL, size - end);
+            end = (p != NULL) ? (size_t) (p - buffer) + 1 : size;
+        }
+
+        chunks[i].buffer = &buffer[offset];
+        chunks[i].size = end - offset;
+        if (chunk_stats != NULL)
+            chunks[i].stats = &chunk_stats[i];
+        offset = end;
+    }
+
+    if (stats != NULL)
+        start = mini_parse_get_time ();
+
+    /* Line numbers of the whole file */
+    mini_parse_run_chunks (chunks, num_chunks, threads, 
+                           mini_parse_chunk_count);
+
+    if (stats != NULL)
+        stats->tokenize_time = mini_parse_get_time () - start;
+
+    chunks[0].first_lineno = 1;
+    for (i = 1; i < num_chunks; i++)
+        chunks[i].first_lineno = chunks[i - 1].first_lineno + 
+                                 chunks[i - 1].num_lines;
+
+    mini_parse_run_chunks (chunks, num_chunks, threads, mini_parse_chunk);
+
+    if (stats != NULL)
+        start = mini_parse_get_time ();
+
+    for (i = 0; i < num_chunks; i++)
+        if (chunks[i].include_lineno != 0)
+            included = 1;
+
+    if (included) {
+        /* The included files are parsed in file order, as mmap does */
+        for (i = 0; i < num_chunks; i++)
+            mini_file_free (chunks[i].tree.mini_file);
+
+        mini_file = mini_file_new (file_name);
+        if (mini_file != NULL) {
+            mini_include_stack_init (&includes, file_name);
+            mini_parse_buffer_into (mini_file, buffer, size, stats, 
+                                    &includes);
+        }
+    } else
+        mini_file = mini_parse_merge (file_name, chunks, num_chunks);
+
+    if (mini_file != NULL) {
+        mini_file->mapping = mapping;
+        mini_file->mapping_size = size;
+    } else if (mapping != NULL)
+        munmap (mapping, size);
+
+    if (stats != NULL) {
+        stats->insert_time = mini_parse_get_time () - start;
+        stats->bytes_read = size;
+
+        for (i = 0; i < num_chunks; i++) {
+            if (!included)
+                mini_parse_stats_add (stats, &chunk_stats[i]);
+            else {
+                /* The parsed chunks were dropped, but not their allocations */
+                stats->allocations += chunk_stats[i].allocations;
+                stats->bytes_allocated += chunk_stats[i].bytes_allocated;
+            }
+        }
+    }
+
+    mini_free (NULL, chunks);
+    mini_free (NULL, threads);
+    mini_free (NULL, chunk_stats);
+
+    mini_parse_count_end (stats, &count, previous);
+
+    return mini_file;
+}
@@ -32,16 +32,112 @@
 #define __MINI_PARSER_H__
 
 #include <assert.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "mini-file.h"
 #include "mini-readline.h"
+#include "mini-scan.h"
 #include "mini-strip.h"
 
+#define MINI_BUFFER_NAME "(buffer)"
+#define MINI_STREAM_NAME "(stream)"
+
+/* Smallest chunk parsed by a worker of mini_parse_file_parallel() */
+#define MINI_PARSE_MIN_CHUNK_SIZE (1024 * 1024)
+
+/* Status of mini_parse_stream() */
+#define MINI_PARSE_STOPPED 1
+#define MINI_PARSE_ERROR -1
+
+/* Directive including another INI file, see mini_parse_stream() */
+#define MINI_PARSE_INCLUDE "!include"
+#define MINI_PARSE_INCLUDE_LEN 8
+
+/* Callbacks of mini_parse_stream(), see its documentation */
+typedef struct _MiniParseCallbacks MiniParseCallbacks;
+struct _MiniParseCallbacks {
+    int (*on_section) (const char *name, size_t name_len, int lineno, 
+                       void *user_data);
+    int (*on_key_value) (const char *key, size_t key_len, const char *value, 
+                         size_t value_len, int lineno, void *user_data);
+    int (*on_comment) (const char *comment, size_t comment_len, int lineno, 
+                       void *user_data);
+    int (*on_error) (const char *line, size_t line_len, int lineno, 
+                     void *user_data);
+    int (*on_include) (const char *path, size_t path_len, int lineno, 
+                       void *user_data);
+};
+
+/* 
+ * Statistics of a parse, see mini_parse_file_stats(). The times are in 
+ * seconds: reading the file, splitting and tokenizing its lines, and 
+ * inserting the sections and keys into the MiniFile.
+ */
+typedef struct _MiniParseStats MiniParseStats;
+struct _MiniParseStats {
+    uint64_t bytes_read;
+    unsigned int lines;
+    unsigned int sections;
+    unsigned int keys;
+    unsigned int comment_lines;
+    /* Allocations and reallocations made by the parse, freed ones too, and 
+       the bytes they requested */
+    unsigned int allocations;
+    size_t bytes_allocated;
+    double read_time;
+    double tokenize_time;
+    double insert_time;
+};
+
+
+int mini_parse_stream (MiniReader *reader, const MiniParseCallbacks *callbacks,
+                       void *user_data);
+
+int mini_parse_buffer_stream (const char *buffer, size_t size, 
+                              const MiniParseCallbacks *callbacks, 
+                              void *user_data);
 
 MiniFile *mini_parse_file (const char *file_name);
 
+MiniFile *mini_parse_file_strict (const char *file_name);
+
+MiniFile *mini_parse_file_with_allocator (const char *file_name, 
+                                          const MiniAllocator *allocator);
+
+MiniFile *mini_parse_reader (MiniReader *reader);
+
+MiniFile *mini_parse_buffer (const char *buffer, size_t size);
+
+MiniFile *mini_parse_mmap (const char *file_name);
+
+MiniFile *mini_parse_file_parallel (const char *file_name, 
+                                    unsigned int num_workers);
+
+MiniFile *mini_parse_file_stats (const char *file_name, 
+                                 MiniParseStats *stats);
+
+MiniFile *mini_parse_file_strict_stats (const char *file_name, 
+                                        MiniParseStats *stats);
+
+MiniFile *mini_parse_reader_stats (MiniReader *reader, MiniParseStats *stats);
+
+MiniFile *mini_parse_buffer_stats (const char *buffer, size_t size, 
+                                   MiniParseStats *stats);
+
+MiniFile *mini_parse_mmap_stats (const char *file_name, MiniParseStats *stats);
+
+MiniFile *mini_parse_file_parallel_stats (const char *file_name, 
+                                          unsigned int num_workers,
+                                          MiniParseStats *stats);
+
 #endif /* __MINI_PARSER_H__ */
 
@@ -32,55 +32,201 @@
 
 
 /**
- *  Reads a line from an opened file.
+ *  Reads the next block from the file descriptor of a reader, appending it 
+ *  to the buffered data. The buffer is compacted or grown as needed, so 
+ *  that a line never needs to fit into a single block.
  *
- *  @param file An opened file.
- *  @return The return value is the readed line.
- *          The function returns NULL, if the file can't be readed.
+ *  @param reader A MiniReader structure.
+ *  @return The return value is the number of readed bytes, zero at the end 
+ *          of the file.
+ *          The function returns a negative number, if the file can't be 
+ *          readed.
  */
-char *
-mini_readline (FILE *file)
+static ssize_t
+mini_reader_fill (MiniReader *reader)
 {
-    char *line, *ret_line;
-    size_t line_size = LINE_LEN;
-    size_t line_len;
+    ssize_t n;
+
+    /* Move the unread data to the beginning of the buffer */
+    if (reader->start > 0) {
+        memmove (reader->buffer, &reader->buffer[reader->start], 
+                 reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->scan -= reader->start;
+        reader->start = 0;
+    }
+
+    /* A line longer than the buffer, grow it (one byte for the NUL) */
+    if (reader->size - reader->end < MINI_READER_BLOCK_SIZE / 2) {
+        char *buffer;
+
+        buffer = (char *) mini_realloc (NULL, reader->buffer, 
+                                        reader->size * 2);
+        if (buffer == NULL)
+            return -1;
+
+        reader->buffer = buffer;
+        reader->size *= 2;
+    }
 
-    assert (file != NULL);
+    do {
+        n = read (reader->fd, &reader->buffer[reader->end], 
+                  reader->size - reader->end - 1);
+    } while ((n < 0) && (errno == EINTR));
 
-    line = (char *) malloc (line_size * sizeof (char));
-    if (line == NULL)
+    if (n > 0) {
+        reader->end += n;
+        reader->bytes_read += n;
+    }
+
+    return n;
+}
+
+
+/**
+ *  Creates a new line reader for an opened file descriptor (a file, a pipe, 
+ *  a socket...). The file descriptor is readed in big blocks into a single 
+ *  buffer, which is reused for all the lines.
+ *
+ *  @param fd An opened file descriptor. It isn't closed by the reader.
+ *  @return The return value is the new MiniReader structure.
+ *          The function returns NULL, if the MiniReader structure 
+ *          can't be created.
+ */
+MiniReader *
+mini_reader_new (int fd)
+{
+    MiniReader *reader;
+
+    assert (fd >= 0);
+
+    reader = (MiniReader *) mini_malloc (NULL, sizeof (MiniReader));
+    if (reader == NULL)
         return NULL;
 
-    ret_line = fgets (line, line_size, file);
-    if (ret_line == NULL) {
-        free (line);
+    reader->buffer = (char *) mini_malloc (NULL, MINI_READER_BLOCK_SIZE);
+    if (reader->buffer == NULL) {
+        mini_free (NULL, reader);
         return NULL;
     }
 
-    line_len = strlen (line);
+    reader->fd = fd;
+    reader->owns_fd = 0;
+    reader->size = MINI_READER_BLOCK_SIZE;
+    reader->start = 0;
+    reader->end = 0;
+    reader->scan = 0;
+    reader->eof = 0;
+    reader->error = 0;
+    reader->bytes_read = 0;
 
-    while (line[line_len - 1] != EOL) {
-        char *tmp_line;
+    return reader;
+}
 
-        line_size *= 2;
-        tmp_line = (char *) realloc (line, line_size * sizeof (char));
-        if (tmp_line == NULL) {
-            free (line);
-            return NULL;
-        }
+/**
+ *  Opens a file and creates a new line reader for it.
+ *
+ *  @param file_name File path.
+ *  @return The return value is the new MiniReader structure.
+ *          The function returns NULL, if the file can't be opened.
+ */
+MiniReader *
+mini_reader_open (const char *file_name)
+{
+    MiniReader *reader;
+    int fd;
+
+    assert (file_name != NULL);
+
+    fd = open (file_name, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    reader = mini_reader_new (fd);
+    if (reader == NULL) {
+        close (fd);
+        return NULL;
+    }
 
-        line = tmp_line;
-        tmp_line = NULL;
+    reader->owns_fd = 1;
+
+    return reader;
+}
 
-        ret_line = fgets (&line[line_len], line_len + 2, file);
-        if (ret_line == NULL) {
-            free (line);
+/**
+ *  Frees a line reader, closing its file if it was opened by the reader.
+ *
+ *  @param reader A MiniReader structure.
+ */
+void
+mini_reader_free (MiniReader *reader)
+{
+    /* Do nothing with NULL pointers */
+    if (reader == NULL)
+        return;
+
+    if (reader->owns_fd)
+        close (reader->fd);
+
+    mini_free (NULL, reader->buffer);
+    mini_free (NULL, reader);
+}
+
+/**
+ *  Reads a line. The line is returned in place, inside the buffer of the 
+ *  reader, without its end of line and NUL terminated. It is valid until 
+ *  the next call.
+ *
+ *  @param reader A MiniReader structure.
+ *  @param len If not NULL, it receives the length of the readed line.
+ *  @return The return value is the readed line.
+ *          The function returns NULL at the end of the file or if the file 
+ *          can't be readed (reader->error is set).
+ */
+char *
+mini_reader_readline (MiniReader *reader, size_t *len)
+{
+    char *line, *eol;
+    ssize_t n;
+
+    assert (reader != NULL);
+
+    for (;;) {
+        eol = memchr (&reader->buffer[reader->scan], EOL, 
+                      reader->end - reader->scan);
+        if (eol != NULL)
+            break;
+
+        reader->scan = reader->end;
+
+        if (reader->eof || reader->error)
+            break;
+
+        n = mini_reader_fill (reader);
+        if (n == 0)
+            reader->eof = 1;
+        else if (n < 0)
+            reader->error = 1;
+    }
+
+    /* Last line without end of line */
+    if (eol == NULL) {
+        if (reader->error || (reader->start == reader->end))
             return NULL;
-        }
 
-        line_len += strlen (ret_line);
+        eol = &reader->buffer[reader->end];
     }
 
+    line = &reader->buffer[reader->start];
+    *eol = '\0';
+
+    if (len != NULL)
+        *len = eol - line;
+
+    reader->start = eol - reader->buffer;
+    if (reader->start < reader->end)
+        reader->start++;
+    reader->scan = reader->start;
+
     return line;
 }
-
@@ -32,15 +32,42 @@
 #define __MINI_READLINE_H__
 
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+#include "mini-alloc.h"
 
 #define EOL '\n'
-#define LINE_LEN 10
+#define MINI_READER_BLOCK_SIZE (64 * 1024)
 
+typedef struct _MiniReader MiniReader;
+struct _MiniReader {
+    int fd;
+    int owns_fd;
+    /* Buffered data is buffer[start, end), newlines are searched from scan */
+    char *buffer;
+    size_t size;
+    size_t start;
+    size_t end;
+    size_t scan;
+    int eof;
+    int error;
+    /* Bytes readed from the file descriptor */
+    uint64_t bytes_read;
+};
 
-char *mini_readline (FILE *file);
 
-#endif /* __MINI_READLINE_H__ */
+MiniReader *mini_reader_new (int fd);
+
+MiniReader *mini_reader_open (const char *file_name);
 
+void mini_reader_free (MiniReader *reader);
+
+char *mini_reader_readline (MiniReader *reader, size_t *len);
+
+#endif /* __MINI_READLINE_H__ */
@@ -0,0 +1,307 @@
+/*
+ * mini-scan.c
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mini-scan.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MINI_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+typedef void (*MiniScanFunc) (const char *block, MiniScanMasks *masks);
+
+#define S MINI_SCAN_SPACE
+
+const unsigned char mini_scan_class[256] = {
+    ['\t'] = S, ['\n'] = S | MINI_SCAN_NEWLINE, ['\v'] = S, ['\f'] = S, 
+    ['\r'] = S, [' '] = S,
+    [';'] = MINI_SCAN_COMMENT, ['#'] = MINI_SCAN_COMMENT,
+    ['='] = MINI_SCAN_EQUAL, ['['] = MINI_SCAN_OPEN, [']'] = MINI_SCAN_CLOSE
+};
+
+#undef S
+
+static void mini_scan_block_resolve (const char *block, MiniScanMasks *masks);
+
+/* 
+ * Scanner for the current CPU, resolved once on the first call. The 
+ * pointer is atomic: threads racing on the first call see either the 
+ * resolver, which waits for the resolution, or the resolved scanner.
+ */
+static _Atomic MiniScanFunc mini_scan_func = mini_scan_block_resolve;
+static const char *mini_scan_name = "unresolved";
+static pthread_once_t mini_scan_once = PTHREAD_ONCE_INIT;
+
+
+/**
+ *  Classifies a 64-byte block one byte at a time.
+ *
+ *  @param block A 64-byte block.
+ *  @param masks Bitmaps of the structural characters of the block.
+ */
+static void
+mini_scan_block_scalar (const char *block, MiniScanMasks *masks)
+{
+    uint64_t bit;
+    int i;
+
+    memset (masks, 0, sizeof (MiniScanMasks));
+
+    for (i = 0; i < MINI_SCAN_BLOCK_SIZE; i++) {
+        unsigned char class = mini_scan_class[(unsigned char) block[i]];
+
+        if (class == 0)
+            continue;
+
+        bit = (uint64_t) 1 << i;
+        if (class & MINI_SCAN_NEWLINE)
+            masks->newline |= bit;
+        if (class & MINI_SCAN_COMMENT)
+            masks->comment |= bit;
+        if (class & MINI_SCAN_EQUAL)
+            masks->equal |= bit;
+        if (class & MINI_SCAN_OPEN)
+            masks->open |= bit;
+        if (class & MINI_SCAN_CLOSE)
+            masks->close |= bit;
+        if (class & MINI_SCAN_SPACE)
+            masks->space |= bit;
+    }
+}
+
+#ifdef MINI_SCAN_X86
+
+/**
+ *  Classifies a 64-byte block 16 bytes at a time (SSE2).
+ *
+ *  @param block A 64-byte block.
+ *  @param masks Bitmaps of the structural characters of the block.
+ */
+__attribute__ ((target ("sse2")))
+static void
+mini_scan_block_sse2 (const char *block, MiniScanMasks *masks)
+{
+    const __m128i newline = _mm_set1_epi8 ('\n');
+    const __m128i semicolon = _mm_set1_epi8 (';');
+    const __m128i hash = _mm_set1_epi8 ('#');
+    const __m128i equal = _mm_set1_epi8 ('=');
+    const __m128i open = _mm_set1_epi8 ('[');
+    const __m128i close = _mm_set1_epi8 (']');
+    const __m128i blank = _mm_set1_epi8 (' ');
+    const __m128i tab = _mm_set1_epi8 ('\t');
+    const __m128i four = _mm_set1_epi8 (4);
+    int i;
+
+    memset (masks, 0, sizeof (MiniScanMasks));
+
+    for (i = 0; i < MINI_SCAN_BLOCK_SIZE; i += 16) {
+        __m128i x = _mm_loadu_si128 ((const __m128i *) &block[i]);
+        __m128i ctrl, space;
+
+        /* '\t' to '\r' are the five bytes in [9, 13] */
+        ctrl = _mm_sub_epi8 (x, tab);
+        space = _mm_or_si128 (_mm_cmpeq_epi8 (x, blank),
+                              _mm_cmpeq_epi8 (_mm_min_epu8 (ctrl, four), ctrl));
+
+        masks->newline |= (uint64_t) (uint16_t) _mm_movemask_epi8 (
+            _mm_cmpeq_epi8 (x, newline)) << i;
+        masks->comment |= (uint64_t) (uint16_t) _mm_movemask_epi8 (
+            _mm_or_si128 (_mm_cmpeq_epi8 (x, semicolon),
+                          _mm_cmpeq_epi8 (x, hash))) << i;
+        masks->equal |= (uint64_t) (uint16_t) _mm_movemask_epi8 (
+            _mm_cmpeq_epi8 (x, equal)) << i;
+        masks->open |= (uint64_t) (uint16_t) _mm_movemask_epi8 (
+            _mm_cmpeq_epi8 (x, open)) << i;
+        masks->close |= (uint64_t) (uint16_t) _mm_movemask_epi8 (
+            _mm_cmpeq_epi8 (x, close)) << i;
+        masks->space |= (uint64_t) (uint16_t) _mm_movemask_epi8 (space) << i;
+    }
+}
+
+/**
+ *  Classifies a 64-byte block 32 bytes at a time (AVX2).
+ *
+ *  @param block A 64-byte block.
+ *  @param masks Bitmaps of the structural characters of the block.
+ */
+__attribute__ ((target ("avx2")))
+static void
+mini_scan_block_avx2 (const char *block, MiniScanMasks *masks)
+{
+    const __m256i newline = _mm256_set1_epi8 ('\n');
+    const __m256i semicolon = _mm256_set1_epi8 (';');
+    const __m256i hash = _mm256_set1_epi8 ('#');
+    const __m256i equal = _mm256_set1_epi8 ('=');
+    const __m256i open = _mm256_set1_epi8 ('[');
+    const __m256i close = _mm256_set1_epi8 (']');
+    const __m256i blank = _mm256_set1_epi8 (' ');
+    const __m256i tab = _mm256_set1_epi8 ('\t');
+    const __m256i four = _mm256_set1_epi8 (4);
+    int i;
+
+    memset (masks, 0, sizeof (MiniScanMasks));
+
+    for (i = 0; i < MINI_SCAN_BLOCK_SIZE; i += 32) {
+        __m256i x = _mm256_loadu_si256 ((const __m256i *) &block[i]);
+        __m256i ctrl, space;
+
+        /* '\t' to '\r' are the five bytes in [9, 13] */
+        ctrl = _mm256_sub_epi8 (x, tab);
+        space = _mm256_or_si256 (_mm256_cmpeq_epi8 (x, blank),
+                                 _mm256_cmpeq_epi8 (_mm256_min_epu8 (ctrl, four),
+                                                    ctrl));
+
+        masks->newline |= (uint64_t) (uint32_t) _mm256_movemask_epi8 (
+            _mm256_cmpeq_epi8 (x, newline)) << i;
+        masks->comment |= (uint64_t) (uint32_t) _mm256_movemask_epi8 (
+            _mm256_or_si256 (_mm256_cmpeq_epi8 (x, semicolon),
+                             _mm256_cmpeq_epi8 (x, hash))) << i;
+        masks->equal |= (uint64_t) (uint32_t) _mm256_movemask_epi8 (
+            _mm256_cmpeq_epi8 (x, equal)) << i;
+        masks->open |= (uint64_t) (uint32_t) _mm256_movemask_epi8 (
+            _mm256_cmpeq_epi8 (x, open)) << i;
+        masks->close |= (uint64_t) (uint32_t) _mm256_movemask_epi8 (
+            _mm256_cmpeq_epi8 (x, close)) << i;
+        masks->space |= (uint64_t) (uint32_t) _mm256_movemask_epi8 (space) << i;
+    }
+}
+
+/**
+ *  Classifies a 64-byte block at once (AVX-512BW).
+ *
+ *  @param block A 64-byte block.
+ *  @param masks Bitmaps of the structural characters of the block.
+ */
+__attribute__ ((target ("avx512f,avx512bw")))
+static void
+mini_scan_block_avx512 (const char *block, MiniScanMasks *masks)
+{
+    __m512i x = _mm512_loadu_si512 ((const void *) block);
+
+    masks->newline = _mm512_cmpeq_epi8_mask (x, _mm512_set1_epi8 ('\n'));
+    masks->comment = _mm512_cmpeq_epi8_mask (x, _mm512_set1_epi8 (';')) |
+                     _mm512_cmpeq_epi8_mask (x, _mm512_set1_epi8 ('#'));
+    masks->equal = _mm512_cmpeq_epi8_mask (x, _mm512_set1_epi8 ('='));
+    masks->open = _mm512_cmpeq_epi8_mask (x, _mm512_set1_epi8 ('['));
+    masks->close = _mm512_cmpeq_epi8_mask (x, _mm512_set1_epi8 (']'));
+
+    /* '\t' to '\r' are the five bytes in [9, 13] */
+    masks->space = _mm512_cmpeq_epi8_mask (x, _mm512_set1_epi8 (' ')) |
+                   _mm512_cmple_epu8_mask (_mm512_sub_epi8 (x, 
+                                               _mm512_set1_epi8 ('\t')),
+                                           _mm512_set1_epi8 (4));
+}
+
+#endif /* MINI_SCAN_X86 */
+
+/**
+ *  Picks the best scanner for the running CPU. It runs only once.
+ */
+static void
+mini_scan_init (void)
+{
+    MiniScanFunc func = mini_scan_block_scalar;
+    const char *name = "scalar";
+
+#ifdef MINI_SCAN_X86
+    __builtin_cpu_init ();
+
+    if (__builtin_cpu_supports ("avx512bw")) {
+        func = mini_scan_block_avx512;
+        name = "avx512";
+    } else if (__builtin_cpu_supports ("avx2")) {
+        func = mini_scan_block_avx2;
+        name = "avx2";
+    } else if (__builtin_cpu_supports ("sse2")) {
+        func = mini_scan_block_sse2;
+        name = "sse2";
+    }
+#endif
+
+    mini_scan_name = name;
+    atomic_store_explicit (&mini_scan_func, func, memory_order_relaxed);
+}
+
+/**
+ *  Resolves the scanner of the running CPU and scans the given block 
+ *  with it, on the first calls to mini_scan_block().
+ *
+ *  @param block A 64-byte block.
+ *  @param masks Bitmaps of the structural characters of the block.
+ */
+static void
+mini_scan_block_resolve (const char *block, MiniScanMasks *masks)
+{
+    MiniScanFunc func;
+
+    pthread_once (&mini_scan_once, mini_scan_init);
+
+    func = atomic_load_explicit (&mini_scan_func, memory_order_relaxed);
+    func (block, masks);
+}
+
+
+/**
+ *  Classifies the structural characters of a 64-byte block (new lines, 
+ *  comments, equality symbols, brackets and whitespaces) in a single pass, 
+ *  using the widest vector instructions of the running CPU.
+ *
+ *  @param block A 64-byte block.
+ *  @param masks Bitmaps of the structural characters of the block.
+ */
+void
+mini_scan_block (const char *block, MiniScanMasks *masks)
+{
+    MiniScanFunc func;
+
+    /* Block and masks can't be NULL */
+    assert (block != NULL);
+    assert (masks != NULL);
+
+    func = atomic_load_explicit (&mini_scan_func, memory_order_relaxed);
+    func (block, masks);
+}
+
+/**
+ *  Gets the name of the scanner used in the running CPU.
+ *
+ *  @return The return value is "avx512", "avx2", "sse2" or "scalar".
+ */
+const char *
+mini_scan_get_implementation (void)
+{
+    /* Resolve the scanner, if it hasn't been used yet */
+    pthread_once (&mini_scan_once, mini_scan_init);
+
+    return mini_scan_name;
+}
@@ -0,0 +1,72 @@
+/*
+ * mini-scan.h
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MINI_SCAN_H__
+#define __MINI_SCAN_H__
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#define MINI_SCAN_BLOCK_SIZE 64
+
+/* Character classes of mini_scan_class */
+#define MINI_SCAN_NEWLINE 0x01
+#define MINI_SCAN_COMMENT 0x02
+#define MINI_SCAN_EQUAL   0x04
+#define MINI_SCAN_OPEN    0x08
+#define MINI_SCAN_CLOSE   0x10
+#define MINI_SCAN_SPACE   0x20
+
+#define MINI_SCAN_IS_SPACE(c) \
+    (mini_scan_class[(unsigned char) (c)] & MINI_SCAN_SPACE)
+
+/* 
+ * Bitmaps of the structural characters of a 64-byte block: bit i is set 
+ * if the i-th byte of the block belongs to the class.
+ */
+typedef struct _MiniScanMasks MiniScanMasks;
+struct _MiniScanMasks {
+    uint64_t newline;   /* '\n' */
+    uint64_t comment;   /* ';' and '#' */
+    uint64_t equal;     /* '=' */
+    uint64_t open;      /* '[' */
+    uint64_t close;     /* ']' */
+    uint64_t space;     /* isspace () in the C locale */
+};
+
+extern const unsigned char mini_scan_class[256];
+
+
+void mini_scan_block (const char *block, MiniScanMasks *masks);
+
+const char *mini_scan_get_implementation (void);
+
+#endif /* __MINI_SCAN_H__ */
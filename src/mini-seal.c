@@ -0,0 +1,444 @@
+/*
+ * mini-seal.c
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mini-lazy.h"
+#include "mini-seal.h"
+
+/* Maps a 32-bit hash to [0, n) without a division */
+#define FASTRANGE(x, n) ((uint32_t) (((uint64_t) (uint32_t) (x) * (n)) >> 32))
+
+#define D1_MASK ((1U << MINI_SEAL_D1_BITS) - 1)
+
+/* A pair being sealed */
+typedef struct _MiniSealItem MiniSealItem;
+struct _MiniSealItem {
+    uint32_t bucket;
+    uint32_t f1;
+    uint32_t f2;
+    uint32_t key;
+    uint16_t fingerprint;
+};
+
+
+/**
+ *  Hashes a "section\0key" pair.
+ *
+ *  @param seed Seed of the perfect hash.
+ *  @param section A section name.
+ *  @param section_len Length of the section name.
+ *  @param key A key name.
+ *  @param key_len Length of the key name.
+ *  @return The return value is the hash of the pair.
+ */
+static uint64_t
+mini_seal_hash (uint64_t seed, const char *section, size_t section_len,
+                const char *key, size_t key_len)
+{
+    uint64_t hash;
+
+    hash = mini_hash_update (MINI_HASH_INIT ^ seed, section, section_len);
+    hash = mini_hash_update (hash, "", 1);
+    hash = mini_hash_update (hash, key, key_len);
+
+    return mini_hash_final (hash);
+}
+
+/**
+ *  Derives the bucket, the two slot hashes and the fingerprint of a pair 
+ *  from its hash.
+ *
+ *  @param seal A MiniSeal structure (only its sizes are used).
+ *  @param hash Hash of the pair.
+ *  @param item Item receiving the derived values.
+ */
+static void
+mini_seal_split (const MiniSeal *seal, uint64_t hash, MiniSealItem *item)
+{
+    uint64_t hash2 = mini_hash_final (hash ^ 0x9e3779b97f4a7c15ULL);
+
+    item->bucket = FASTRANGE (hash >> 32, seal->num_buckets);
+    item->f1 = FASTRANGE (hash, seal->num_keys);
+    item->f2 = FASTRANGE (hash2, seal->num_keys);
+    item->fingerprint = (uint16_t) (hash2 >> 48);
+}
+
+/**
+ *  Gets the slot of a pair for a given displacement.
+ *
+ *  @param seal A MiniSeal structure.
+ *  @param f1 First slot hash of the pair.
+ *  @param f2 Second slot hash of the pair.
+ *  @param displacement Displacement of the bucket of the pair.
+ *  @return The return value is the slot.
+ */
+static uint32_t
+mini_seal_position (const MiniSeal *seal, uint32_t f1, uint32_t f2, 
+                    uint32_t displacement)
+{
+    uint64_t d0 = displacement >> MINI_SEAL_D1_BITS;
+    uint64_t d1 = displacement & D1_MASK;
+
+    if (displacement & MINI_SEAL_DIRECT)
+        return displacement & ~MINI_SEAL_DIRECT;
+
+    return (uint32_t) ((f1 + d0 * f2 + d1) % seal->num_keys);
+}
+
+/**
+ *  Searches a displacement placing all the pairs of a bucket in free slots.
+ *
+ *  @param seal A MiniSeal structure.
+ *  @param items Pairs of the bucket.
+ *  @param size Number of pairs of the bucket.
+ *  @param taken Slots already taken.
+ *  @param pos Buffer receiving the slots of the pairs.
+ *  @return The return value is the displacement.
+ *          The function returns a negative number, if the bucket can't 
+ *          be placed.
+ */
+static int64_t
+mini_seal_place (const MiniSeal *seal, MiniSealItem **items, uint32_t size,
+                 const unsigned char *taken, uint32_t *pos)
+{
+    uint32_t k, i, j, displacement;
+
+    for (k = 0; k < MINI_SEAL_MAX_TRIES; k++) {
+        /* Change d0 first, it changes the distance between the slots */
+        displacement = ((k & ((1U << MINI_SEAL_D0_BITS) - 1)) 
+                        << MINI_SEAL_D1_BITS) | (k >> MINI_SEAL_D0_BITS);
+
+        for (i = 0; i < size; i++) {
+            pos[i] = mini_seal_position (seal, items[i]->f1, items[i]->f2, 
+                                         displacement);
+            if (taken[pos[i]])
+                break;
+
+            for (j = 0; j < i; j++)
+                if (pos[j] == pos[i])
+                    break;
+            if (j < i)
+                break;
+        }
+
+        if (i == size)
+            return displacement;
+    }
+
+    return -1;
+}
+
+/**
+ *  Builds the perfect hash of the given pairs with the seed of the seal.
+ *
+ *  @param seal A MiniSeal structure with its arrays allocated.
+ *  @param keys Pairs to be sealed.
+ *  @param items Buffer of num_keys items.
+ *  @param order Buffer of 2 * num_buckets + 1 integers.
+ *  @param taken Buffer of num_keys bytes.
+ *  @param allocator Allocator of the temporary memory.
+ *  @return The function returns a negative number, if some bucket can't 
+ *          be placed with this seed.
+ */
+static int
+mini_seal_build (MiniSeal *seal, const MiniSealEntry *keys, MiniSealItem *items,
+                 uint32_t *order, unsigned char *taken, 
+                 const MiniAllocator *allocator)
+{
+    MiniSealItem **bucket_items, *bucket[64];
+    uint32_t *start, *by_size, pos[64];
+    uint32_t i, b, size, max_size, num_used, free_slot;
+    int64_t displacement;
+    int ret = -1;
+
+    start = order;
+    by_size = &order[seal->num_buckets + 1];
+
+    bucket_items = (MiniSealItem **) mini_malloc (allocator, seal->num_keys * 
+                                                  sizeof (MiniSealItem *));
+    if (bucket_items == NULL)
+        return -1;
+
+    memset (start, 0, (seal->num_buckets + 1) * sizeof (uint32_t));
+    memset (taken, 0, seal->num_keys);
+    memset (seal->displacements, 0, seal->num_buckets * sizeof (uint32_t));
+
+    /* Hash every pair and count the pairs of every bucket */
+    for (i = 0; i < seal->num_keys; i++) {
+        mini_seal_split (seal, 
+                         mini_seal_hash (seal->seed, keys[i].section->name,
+                                         keys[i].section->name_len,
+                                         keys[i].data->key, 
+                                         keys[i].data->key_len), 
+                         &items[i]);
+        items[i].key = i;
+        start[items[i].bucket + 1]++;
+    }
+
+    /* Group the pairs by bucket */
+    max_size = 0;
+    for (b = 0; b < seal->num_buckets; b++) {
+        if (start[b + 1] > max_size)
+            max_size = start[b + 1];
+        start[b + 1] += start[b];
+    }
+
+    /* Too unlucky seed */
+    if (max_size > 64)
+        goto out;
+
+    for (i = 0; i < seal->num_keys; i++)
+        bucket_items[--start[items[i].bucket + 1]] = &items[i];
+    for (b = 0; b < seal->num_buckets; b++)
+        start[b] = start[b + 1];
+    start[seal->num_buckets] = seal->num_keys;
+
+    /* Sort the non empty buckets by decreasing size */
+    num_used = 0;
+    for (size = max_size; size > 0; size--)
+        for (b = 0; b < seal->num_buckets; b++)
+            if (start[b + 1] - start[b] == size)
+                by_size[num_used++] = b;
+
+    /* Place the biggest buckets first, while there are many free slots */
+    free_slot = 0;
+    for (i = 0; i < num_used; i++) {
+        uint32_t j;
+
+        b = by_size[i];
+        size = start[b + 1] - start[b];
+        for (j = 0; j < size; j++)
+            bucket[j] = bucket_items[start[b] + j];
+
+        if (size == 1) {
+            /* Single pairs go straight to the next free slot */
+            while (taken[free_slot])
+                free_slot++;
+
+            displacement = MINI_SEAL_DIRECT | free_slot;
+            pos[0] = free_slot;
+        } else
+            displacement = mini_seal_place (seal, bucket, size, taken, pos);
+
+        if (displacement < 0)
+            goto out;
+
+        seal->displacements[b] = (uint32_t) displacement;
+        for (j = 0; j < size; j++)
+            taken[pos[j]] = 1;
+    }
+
+    /* Fill the slots */
+    for (i = 0; i < seal->num_keys; i++) {
+        uint32_t slot;
+
+        slot = mini_seal_position (seal, items[i].f1, items[i].f2,
+                                   seal->displacements[items[i].bucket]);
+        seal->fingerprints[slot] = items[i].fingerprint;
+        seal->entries[slot] = keys[items[i].key];
+    }
+
+    ret = 0;
+
+out:
+    mini_free (allocator, bucket_items);
+
+    return ret;
+}
+
+
+/**
+ *  Seals a MiniFile that won't be modified anymore: builds a minimal 
+ *  perfect hash over all its "section\0key" pairs, storing a 16-bit 
+ *  fingerprint per slot. Lookups then take one hash, one probe and the 
+ *  comparison of the found pair. Modifying the MiniFile drops the seal.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param stats If not NULL, it receives the build time and the size of 
+ *         the perfect hash.
+ *  @return The function returns a negative number, if the MiniFile can't 
+ *          be sealed.
+ */
+int
+mini_file_seal (MiniFile *mini_file, MiniSealStats *stats)
+{
+    struct timespec start, end;
+    MiniSeal *seal;
+    MiniSealEntry *keys = NULL;
+    MiniSealItem *items = NULL;
+    uint32_t *order = NULL;
+    unsigned char *taken = NULL;
+    const MiniAllocator *allocator;
+    Section *sec;
+    SectionData *data;
+    uint32_t n = 0, attempt;
+    int ret = -1;
+
+    /* MiniFile can't be NULL */
+    assert (mini_file != NULL);
+
+    /* Frozen MiniFiles have their own index */
+    if (mini_file->frozen != NULL)
+        return -1;
+
+    clock_gettime (CLOCK_MONOTONIC, &start);
+
+    /* Sections not parsed yet have no keys to seal */
+    mini_lazy_load_all (mini_file);
+
+    /* The temporary memory comes from the allocator of the MiniFile */
+    allocator = &mini_file->arena->allocator;
+
+    /* Only the pairs found by a lookup are sealed */
+    for (sec = mini_file->section; sec != NULL; sec = sec->next)
+        if (mini_file_find_section (mini_file, sec->name, sec->name_len) == sec)
+            n += sec->index_used;
+
+    seal = (MiniSeal *) mini_arena_calloc (mini_file->arena, sizeof (MiniSeal));
+    if (seal == NULL)
+        return -1;
+
+    seal->num_keys = n;
+    seal->num_buckets = (n + MINI_SEAL_BUCKET_SIZE - 1) / MINI_SEAL_BUCKET_SIZE;
+
+    if (n > 0) {
+        seal->displacements = (uint32_t *) mini_arena_alloc (mini_file->arena,
+            seal->num_buckets * sizeof (uint32_t));
+        seal->fingerprints = (uint16_t *) mini_arena_alloc (mini_file->arena,
+            n * sizeof (uint16_t));
+        seal->entries = (MiniSealEntry *) mini_arena_alloc (mini_file->arena,
+            n * sizeof (MiniSealEntry));
+        keys = (MiniSealEntry *) mini_malloc (allocator, 
+                                              n * sizeof (MiniSealEntry));
+        items = (MiniSealItem *) mini_malloc (allocator, 
+                                              n * sizeof (MiniSealItem));
+        order = (uint32_t *) mini_malloc (allocator, 
+            (2 * seal->num_buckets + 1) * sizeof (uint32_t));
+        taken = (unsigned char *) mini_malloc (allocator, n);
+        if ((seal->displacements == NULL) || (seal->fingerprints == NULL) ||
+            (seal->entries == NULL) || (keys == NULL) || (items == NULL) ||
+            (order == NULL) || (taken == NULL))
+            goto out;
+
+        n = 0;
+        for (sec = mini_file->section; sec != NULL; sec = sec->next) {
+            if (mini_file_find_section (mini_file, sec->name, 
+                                        sec->name_len) != sec)
+                continue;
+
+            for (data = sec->data; data != NULL; data = data->next) {
+                if (mini_file_find_key (sec, data->key, data->key_len) != data)
+                    continue;
+
+                keys[n].section = sec;
+                keys[n].data = data;
+                n++;
+            }
+        }
+    }
+
+    /* Try new seeds until every bucket can be placed */
+    for (attempt = 1; attempt <= MINI_SEAL_MAX_ATTEMPTS; attempt++) {
+        seal->seed = mini_hash (&attempt, sizeof (attempt));
+        if ((n == 0) || (mini_seal_build (seal, keys, items, order, taken, 
+                                          allocator) == 0))
+            break;
+    }
+
+    if (attempt > MINI_SEAL_MAX_ATTEMPTS)
+        goto out;
+
+    mini_file->seal = seal;
+    ret = 0;
+
+    if (stats != NULL) {
+        clock_gettime (CLOCK_MONOTONIC, &end);
+
+        stats->num_keys = seal->num_keys;
+        stats->num_buckets = seal->num_buckets;
+        stats->attempts = attempt;
+        stats->build_time = (end.tv_sec - start.tv_sec) + 
+                            (end.tv_nsec - start.tv_nsec) / 1e9;
+        stats->bytes = sizeof (MiniSeal) + 
+                       seal->num_buckets * sizeof (uint32_t) +
+                       seal->num_keys * (sizeof (uint16_t) + 
+                                         sizeof (MiniSealEntry));
+        stats->bytes_per_key = (n > 0) ? (double) stats->bytes / n : 0;
+    }
+
+out:
+    mini_free (allocator, taken);
+    mini_free (allocator, order);
+    mini_free (allocator, items);
+    mini_free (allocator, keys);
+
+    return ret;
+}
+
+/**
+ *  Searches for a section's key in the perfect hash of a sealed MiniFile.
+ *
+ *  @param seal The seal of a MiniFile.
+ *  @param section A section name.
+ *  @param section_len Length of the section name.
+ *  @param key A key name.
+ *  @param key_len Length of the key name.
+ *  @return The function returns NULL, if the given pair can't be found.
+ */
+SectionData *
+mini_seal_find (const MiniSeal *seal, const char *section, size_t section_len,
+                const char *key, size_t key_len)
+{
+    const MiniSealEntry *entry;
+    MiniSealItem item;
+    uint32_t slot;
+
+    /* Seal can't be NULL */
+    assert (seal != NULL);
+
+    if (seal->num_keys == 0)
+        return NULL;
+
+    mini_seal_split (seal, mini_seal_hash (seal->seed, section, section_len, 
+                                           key, key_len), &item);
+    slot = mini_seal_position (seal, item.f1, item.f2, 
+                               seal->displacements[item.bucket]);
+
+    if (seal->fingerprints[slot] != item.fingerprint)
+        return NULL;
+
+    entry = &seal->entries[slot];
+    if ((entry->data->key_len != key_len) || 
+        (entry->section->name_len != section_len) ||
+        (memcmp (entry->data->key, key, key_len) != 0) ||
+        (memcmp (entry->section->name, section, section_len) != 0))
+        return NULL;
+
+    return entry->data;
+}
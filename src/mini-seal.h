@@ -0,0 +1,90 @@
+/*
+ * mini-seal.h
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MINI_SEAL_H__
+#define __MINI_SEAL_H__
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mini-file.h"
+
+/* Average number of keys per bucket */
+#define MINI_SEAL_BUCKET_SIZE 4
+/* A displacement is d0 << MINI_SEAL_D1_BITS | d1, or a direct slot */
+#define MINI_SEAL_D0_BITS 11
+#define MINI_SEAL_D1_BITS 20
+#define MINI_SEAL_DIRECT 0x80000000U
+#define MINI_SEAL_MAX_TRIES (1 << 20)
+#define MINI_SEAL_MAX_ATTEMPTS 16
+
+typedef struct _MiniSealEntry MiniSealEntry;
+struct _MiniSealEntry {
+    Section *section;
+    SectionData *data;
+};
+
+/* 
+ * Minimal perfect hash (CHD, "compress, hash and displace") over all the 
+ * "section\0key" pairs of a MiniFile: the pair hashed into the bucket b 
+ * is stored in the slot (f1 + d0 * f2 + d1) mod num_keys, being (d0, d1) 
+ * the displacement of b. Buckets with a single pair store their slot 
+ * directly, flagged with MINI_SEAL_DIRECT.
+ */
+struct _MiniSeal {
+    uint64_t seed;
+    uint32_t num_keys;
+    uint32_t num_buckets;
+    uint32_t *displacements;
+    uint16_t *fingerprints;
+    MiniSealEntry *entries;
+};
+
+typedef struct _MiniSealStats MiniSealStats;
+struct _MiniSealStats {
+    unsigned int num_keys;
+    unsigned int num_buckets;
+    unsigned int attempts;      /* seeds tried */
+    double build_time;          /* seconds */
+    size_t bytes;               /* size of the index, without the strings */
+    double bytes_per_key;
+};
+
+
+int mini_file_seal (MiniFile *mini_file, MiniSealStats *stats);
+
+SectionData *mini_seal_find (const MiniSeal *seal, const char *section, 
+                             size_t section_len, const char *key, 
+                             size_t key_len);
+
+#endif /* __MINI_SEAL_H__ */
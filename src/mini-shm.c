@@ -0,0 +1,418 @@
+/*
+ * mini-shm.c
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mini-shm.h"
+
+
+/**
+ *  Builds the name of the segment of an image.
+ *
+ *  @param name Name of the control segment.
+ *  @param generation Generation of the image.
+ *  @return The return value is the new name, to be freed by mini_free().
+ *          The function returns NULL, if the name can't be allocated.
+ */
+static char *
+mini_shm_image_name (const char *name, uint64_t generation)
+{
+    char *image_name;
+    size_t size;
+
+    size = strlen (name) + 22;
+    image_name = (char *) mini_malloc (NULL, size);
+    if (image_name == NULL)
+        return NULL;
+
+    snprintf (image_name, size, "%s.%llu", name, 
+              (unsigned long long) generation);
+
+    return image_name;
+}
+
+/**
+ *  Unlinks the segment of an image.
+ *
+ *  @param name Name of the control segment.
+ *  @param generation Generation of the image.
+ */
+static void
+mini_shm_unlink_image (const char *name, uint64_t generation)
+{
+    char *image_name;
+
+    image_name = mini_shm_image_name (name, generation);
+    if (image_name == NULL)
+        return;
+
+    shm_unlink (image_name);
+    mini_free (NULL, image_name);
+}
+
+/**
+ *  Maps the control segment of a name, creating it for a publisher.
+ *
+ *  @param name Name of the control segment.
+ *  @param create Non-zero to create it (mapped writable) if it doesn't 
+ *         exist, zero to map an existing one read-only.
+ *  @return The return value is the mapped control segment.
+ *          The function returns NULL, if it can't be mapped or it isn't 
+ *          a control segment.
+ */
+static MiniShmControl *
+mini_shm_map_control (const char *name, int create)
+{
+    MiniShmControl *control;
+    struct stat st;
+    int fd;
+
+    fd = shm_open (name, create ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if (fd < 0)
+        return NULL;
+
+    /* A new segment is filled with zeros: no generation yet */
+    if ((fstat (fd, &st) < 0) || 
+        ((st.st_size < (off_t) sizeof (MiniShmControl)) && 
+         (!create || (ftruncate (fd, sizeof (MiniShmControl)) < 0)))) {
+        close (fd);
+        return NULL;
+    }
+
+    control = (MiniShmControl *) mmap (NULL, sizeof (MiniShmControl), 
+                                       create ? PROT_READ | PROT_WRITE : 
+                                                PROT_READ, 
+                                       MAP_SHARED, fd, 0);
+    close (fd);
+    if (control == MAP_FAILED)
+        return NULL;
+
+    if (create && (control->magic == 0))
+        control->magic = MINI_SHM_MAGIC;
+
+    /* A reader may see a segment being created, without magic yet */
+    if ((control->magic != MINI_SHM_MAGIC) && (create || 
+        (atomic_load (&control->generation) != 0))) {
+        munmap (control, sizeof (MiniShmControl));
+        return NULL;
+    }
+
+    return control;
+}
+
+/**
+ *  Writes the frozen image of a MiniFile into a new segment.
+ *
+ *  @param mini_file A MiniFile structure.
+ *  @param image_name Name of the segment.
+ *  @return The function returns a negative number, if the image can't 
+ *          be written.
+ */
+static int
+mini_shm_write_image (MiniFile *mini_file, const char *image_name)
+{
+    void *image;
+    size_t size;
+    int fd, ret;
+
+    size = mini_frozen_get_size (mini_file);
+
+    /* Generations aren't reused, an existing one is left by a crash */
+    fd = shm_open (image_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return -1;
+
+    if (ftruncate (fd, size) < 0) {
+        close (fd);
+        shm_unlink (image_name);
+        return -1;
+    }
+
+    image = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close (fd);
+    if (image == MAP_FAILED) {
+        shm_unlink (image_name);
+        return -1;
+    }
+
+    ret = mini_frozen_serialize (mini_file, image, size);
+    munmap (image, size);
+
+    if (ret < 0)
+        shm_unlink (image_name);
+
+    return ret;
+}
+
+
+/**
+ *  Publishes a MiniFile under a POSIX shared memory name (a "/" followed 
+ *  by a name without slashes): its frozen image is written into a new 
+ *  segment, and then it becomes the current one, so the readers never see 
+ *  a half written image. The previous image is unlinked.
+ *
+ *  Publishers of the same name may run at the same time: the newest 
+ *  generation always wins.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param name Shared memory name.
+ *  @return The return value is the generation of the published image.
+ *          The function returns 0, if the MiniFile can't be published.
+ */
+uint64_t
+mini_shm_publish (MiniFile *mini_file, const char *name)
+{
+    MiniShmControl *control;
+    uint64_t generation, current;
+    char *image_name;
+
+    /* MiniFile and name can't be NULL */
+    assert (mini_file != NULL);
+    assert (name != NULL);
+
+    control = mini_shm_map_control (name, 1);
+    if (control == NULL)
+        return 0;
+
+    generation = atomic_fetch_add (&control->last_generation, 1) + 1;
+
+    image_name = mini_shm_image_name (name, generation);
+    if ((image_name == NULL) || 
+        (mini_shm_write_image (mini_file, image_name) < 0)) {
+        mini_free (NULL, image_name);
+        munmap (control, sizeof (MiniShmControl));
+        return 0;
+    }
+
+    mini_free (NULL, image_name);
+
+    /* Replace the current image, unless a newer one was published */
+    current = atomic_load (&control->generation);
+    while ((current < generation) && 
+           !atomic_compare_exchange_weak (&control->generation, &current, 
+                                          generation))
+        ;
+
+    if (current < generation) {
+        if (current != 0)
+            mini_shm_unlink_image (name, current);
+    } else {
+        mini_shm_unlink_image (name, generation);
+    }
+
+    munmap (control, sizeof (MiniShmControl));
+
+    return generation;
+}
+
+/**
+ *  Removes a published name: its control segment and its current image. 
+ *  The processes which attached it keep their mappings.
+ *
+ *  @param name Shared memory name.
+ *  @return The function returns a negative number, if the name can't be 
+ *          removed.
+ */
+int
+mini_shm_unlink (const char *name)
+{
+    MiniShmControl *control;
+    uint64_t generation;
+
+    /* Name can't be NULL */
+    assert (name != NULL);
+
+    control = mini_shm_map_control (name, 0);
+    if (control == NULL)
+        return -1;
+
+    generation = atomic_load (&control->generation);
+    munmap (control, sizeof (MiniShmControl));
+
+    if (generation != 0)
+        mini_shm_unlink_image (name, generation);
+
+    return shm_unlink (name);
+}
+
+/**
+ *  Opens a published name to attach its images, mapping its control 
+ *  segment read-only.
+ *
+ *  @param name Shared memory name.
+ *  @return The return value is the new MiniShm structure.
+ *          The function returns NULL, if the name doesn't exist or it 
+ *          can't be opened.
+ */
+MiniShm *
+mini_shm_open (const char *name)
+{
+    MiniShm *shm;
+
+    /* Name can't be NULL */
+    assert (name != NULL);
+
+    shm = (MiniShm *) mini_malloc (NULL, sizeof (MiniShm));
+    if (shm == NULL)
+        return NULL;
+
+    shm->name = mini_strdup (NULL, name);
+    if (shm->name == NULL) {
+        mini_free (NULL, shm);
+        return NULL;
+    }
+
+    shm->control = mini_shm_map_control (name, 0);
+    if (shm->control == NULL) {
+        mini_free (NULL, shm->name);
+        mini_free (NULL, shm);
+        return NULL;
+    }
+
+    shm->generation = 0;
+
+    return shm;
+}
+
+/**
+ *  Closes a MiniShm structure. The MiniFiles attached with it stay valid.
+ *
+ *  @param shm A MiniShm structure.
+ */
+void
+mini_shm_close (MiniShm *shm)
+{
+    /* Do nothing with NULL pointers */
+    if (shm == NULL)
+        return;
+
+    munmap ((void *) shm->control, sizeof (MiniShmControl));
+    mini_free (NULL, shm->name);
+    mini_free (NULL, shm);
+}
+
+/**
+ *  Attaches the current image of a published name: it's mapped 
+ *  read-only and lookups are answered straight from the shared mapping, 
+ *  as mini_file_open_frozen() does, without parsing nor a private copy.
+ *
+ *  The MiniFile keeps its image after a newer one is published, see 
+ *  mini_shm_is_stale(). Free it to detach.
+ *
+ *  @param shm A MiniShm structure.
+ *  @return The return value is a MiniFile structure backed by the image.
+ *          The function returns NULL, if there isn't an image or it 
+ *          can't be attached.
+ */
+MiniFile *
+mini_shm_attach (MiniShm *shm)
+{
+    MiniFile *mini_file;
+    uint64_t generation;
+    char *image_name;
+    struct stat st;
+    void *mapping;
+    unsigned int i;
+    int fd;
+
+    /* Shm can't be NULL */
+    assert (shm != NULL);
+
+    for (i = 0; i < MINI_SHM_ATTACH_TRIES; i++) {
+        generation = atomic_load (&shm->control->generation);
+        if (generation == 0)
+            return NULL;
+
+        image_name = mini_shm_image_name (shm->name, generation);
+        if (image_name == NULL)
+            return NULL;
+
+        /* A newer image may have replaced it meanwhile */
+        fd = shm_open (image_name, O_RDONLY, 0);
+        if (fd < 0) {
+            mini_free (NULL, image_name);
+            if (errno == ENOENT)
+                continue;
+            return NULL;
+        }
+
+        if ((fstat (fd, &st) < 0) || (st.st_size == 0)) {
+            close (fd);
+            mini_free (NULL, image_name);
+            return NULL;
+        }
+
+        mapping = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close (fd);
+        if (mapping == MAP_FAILED) {
+            mini_free (NULL, image_name);
+            return NULL;
+        }
+
+        mini_file = mini_file_new_frozen (image_name, mapping, st.st_size);
+        mini_free (NULL, image_name);
+        if (mini_file != NULL)
+            shm->generation = generation;
+
+        return mini_file;
+    }
+
+    return NULL;
+}
+
+/**
+ *  Gets the generation of the current image of a published name.
+ *
+ *  @param shm A MiniShm structure.
+ *  @return The return value is the generation, 0 if there isn't an image.
+ */
+uint64_t
+mini_shm_get_generation (const MiniShm *shm)
+{
+    /* Shm can't be NULL */
+    assert (shm != NULL);
+
+    return atomic_load (&shm->control->generation);
+}
+
+/**
+ *  Checks if a newer image was published since the last one attached 
+ *  with a MiniShm structure.
+ *
+ *  @param shm A MiniShm structure.
+ *  @return The function returns a non-zero number, if the attached image 
+ *          isn't the current one.
+ */
+int
+mini_shm_is_stale (const MiniShm *shm)
+{
+    /* Shm can't be NULL */
+    assert (shm != NULL);
+
+    return mini_shm_get_generation (shm) != shm->generation;
+}
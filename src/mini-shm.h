@@ -0,0 +1,94 @@
+/*
+ * mini-shm.h
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MINI_SHM_H__
+#define __MINI_SHM_H__
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mini-file.h"
+#include "mini-frozen.h"
+
+#define MINI_SHM_MAGIC 0x314d48534e494dULL     /* "MINSHM1" */
+/* Times an attach looks for an image replaced while it's opened */
+#define MINI_SHM_ATTACH_TRIES 8
+
+/* 
+ * A MiniFile published under a POSIX shared memory name (say "/config") 
+ * is a frozen image (see mini-frozen.h) in the segment "/config.<N>", 
+ * being N its generation. The control segment "/config" holds the 
+ * generation of the current image: readers map the image read-only and 
+ * look up straight from it, and they check the control segment to know 
+ * if a newer one was published. Replaced images are unlinked, the 
+ * processes still mapping them keep them until they detach.
+ */
+typedef struct _MiniShmControl MiniShmControl;
+struct _MiniShmControl {
+    uint64_t magic;
+    /* Generation of the current image, 0 if none was published */
+    atomic_uint_least64_t generation;
+    /* Last generation given to a publisher */
+    atomic_uint_least64_t last_generation;
+};
+
+typedef struct _MiniShm MiniShm;
+struct _MiniShm {
+    char *name;
+    const MiniShmControl *control;
+    /* Generation of the last image attached, 0 if none */
+    uint64_t generation;
+};
+
+
+uint64_t mini_shm_publish (MiniFile *mini_file, const char *name);
+
+int mini_shm_unlink (const char *name);
+
+MiniShm *mini_shm_open (const char *name);
+
+void mini_shm_close (MiniShm *shm);
+
+MiniFile *mini_shm_attach (MiniShm *shm);
+
+uint64_t mini_shm_get_generation (const MiniShm *shm);
+
+int mini_shm_is_stale (const MiniShm *shm);
+
+#endif /* __MINI_SHM_H__ */
@@ -0,0 +1,779 @@
+/*
+ * mini-watch.c
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mini-lazy.h"
+#include "mini-watch.h"
+
+
+/**
+ *  Computes the content hash of a section: a hash of every key and value 
+ *  with its position, so reordered keys change it too.
+ *
+ *  @param section A Section structure.
+ *  @return The return value is the content hash, never zero.
+ */
+static uint64_t
+mini_watch_content_hash (const Section *section)
+{
+    const SectionData *data;
+    unsigned int pos;
+    uint64_t hash = 0, item;
+
+    pos = 0;
+    for (data = section->data; data != NULL; data = data->next, pos++) {
+        item = mini_hash_update (data->hash, data->value, data->value_len);
+        item = mini_hash_update (item, &pos, sizeof (pos));
+        hash += mini_hash_final (item);
+    }
+
+    return (hash != 0) ? hash : 1;
+}
+
+/**
+ *  Gets the content hash of a section, computing it the first time.
+ *
+ *  @param section A Section structure.
+ *  @return The return value is the content hash.
+ */
+static uint64_t
+mini_watch_get_content_hash (Section *section)
+{
+    if (section->content_hash == 0)
+        section->content_hash = mini_watch_content_hash (section);
+
+    return section->content_hash;
+}
+
+/**
+ *  Adds a change to the change list of a watch.
+ *
+ *  @param watch A MiniWatch structure.
+ *  @param type MINI_WATCH_ADDED, MINI_WATCH_REMOVED or MINI_WATCH_MODIFIED.
+ *  @param section The changed section.
+ *  @param data The changed key, or NULL if the whole section changed.
+ *  @return The function returns a negative number, if the change can't 
+ *          be added.
+ */
+static int
+mini_watch_add_change (MiniWatch *watch, int type, const Section *section, 
+                       const SectionData *data)
+{
+    MiniWatchChange *changes, *change;
+    unsigned int size;
+
+    if (watch->num_changes == watch->changes_size) {
+        size = (watch->changes_size == 0) ? 16 : watch->changes_size * 2;
+        changes = (MiniWatchChange *) mini_realloc (NULL, watch->changes, 
+            size * sizeof (MiniWatchChange));
+        if (changes == NULL)
+            return -1;
+
+        watch->changes = changes;
+        watch->changes_size = size;
+    }
+
+    change = &watch->changes[watch->num_changes++];
+    change->type = type;
+    change->section = section->name;
+    change->section_len = section->name_len;
+    change->key = (data != NULL) ? data->key : NULL;
+    change->key_len = (data != NULL) ? data->key_len : 0;
+
+    return 0;
+}
+
+/**
+ *  Adds the changes of the keys of a modified section to the change list.
+ *  Only the keys found by a lookup are compared, as only they can be read.
+ *
+ *  @param watch A MiniWatch structure.
+ *  @param old The section before the update.
+ *  @param new The section after the update.
+ *  @return The function returns a negative number, if the changes can't 
+ *          be added.
+ */
+static int
+mini_watch_diff_keys (MiniWatch *watch, const Section *old, const Section *new)
+{
+    SectionData *data, *other;
+    unsigned int i;
+
+    for (i = 0; i < new->index_size; i++) {
+        data = new->index[i];
+        if (data == NULL)
+            continue;
+
+        other = (old->index != NULL) ? 
+                mini_file_find_key (old, data->key, data->key_len) : NULL;
+        if (other == NULL) {
+            if (mini_watch_add_change (watch, MINI_WATCH_ADDED, new, data) < 0)
+                return -1;
+        } else if ((other->value_len != data->value_len) || 
+                   (memcmp (other->value, data->value, data->value_len) != 0)) {
+            if (mini_watch_add_change (watch, MINI_WATCH_MODIFIED, new, 
+                                       data) < 0)
+                return -1;
+        }
+    }
+
+    for (i = 0; i < old->index_size; i++) {
+        data = old->index[i];
+        if ((data == NULL) || 
+            (mini_file_find_key (new, data->key, data->key_len) != NULL))
+            continue;
+
+        if (mini_watch_add_change (watch, MINI_WATCH_REMOVED, old, data) < 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+/**
+ *  Copies a section, with the cached conversions of its keys, after the 
+ *  last section of a MiniFile.
+ *
+ *  @param mini_file The MiniFile receiving the copy.
+ *  @param section A section of another MiniFile.
+ *  @return The return value is the copy.
+ *          The function returns NULL, if the section can't be copied.
+ */
+static Section *
+mini_watch_copy_section (MiniFile *mini_file, const Section *section)
+{
+    SectionData *data, *copied;
+    Section *copy;
+    const char *file_name = NULL;
+    char *copied_name = NULL;
+    int conversion;
+
+    copy = mini_file_add_section (mini_file, section->name, section->name_len,
+                                  MINI_COPY);
+    if (copy == NULL)
+        return NULL;
+
+    copy->content_hash = section->content_hash;
+
+    for (data = section->data; data != NULL; data = data->next) {
+        copied = mini_file_add_key_and_value (mini_file, data->key, 
+                                              data->key_len, data->value, 
+                                              data->value_len, MINI_COPY);
+        if (copied == NULL)
+            return NULL;
+
+        copied->lineno = data->lineno;
+
+        /* The copied section may be freed: included paths are copied once */
+        if ((data->file_name != NULL) && (data->file_name != file_name)) {
+            file_name = data->file_name;
+            copied_name = mini_arena_strdup (mini_file->arena, file_name);
+            if (copied_name == NULL)
+                return NULL;
+        }
+
+        if (data->file_name != NULL)
+            copied->file_name = copied_name;
+
+        conversion = atomic_load_explicit (&data->conversion, 
+                                           memory_order_acquire);
+        if (!(conversion & MINI_CONVERT_PENDING)) {
+            copied->converted = data->converted;
+            atomic_store_explicit (&copied->conversion, conversion, 
+                                   memory_order_release);
+        }
+    }
+
+    return copy;
+}
+
+/**
+ *  Links the given sections into the watched MiniFile, in order, instead 
+ *  of its current ones.
+ *
+ *  @param mini_file The watched MiniFile.
+ *  @param sections Sections to be linked.
+ *  @param num_sections Number of sections.
+ *  @return The function returns a negative number, if the sections can't 
+ *          be linked.
+ */
+static int
+mini_watch_relink (MiniFile *mini_file, Section **sections, 
+                   unsigned int num_sections)
+{
+    unsigned int i;
+
+    mini_file_reset (mini_file);
+
+    for (i = 0; i < num_sections; i++)
+        if (mini_file_link_section (mini_file, sections[i]) < 0)
+            return -1;
+
+    return 0;
+}
+
+/**
+ *  Moves the sections of the watched MiniFile copied into the store of a 
+ *  watch to another MiniFile, so the store can be freed with the sections 
+ *  replaced by the updates.
+ *
+ *  @param watch A MiniWatch structure.
+ *  @param target MiniFile receiving the sections: a new store, or the 
+ *         watched MiniFile itself.
+ *  @return The function returns a negative number, if the sections can't 
+ *          be moved. The watched MiniFile is left as it was.
+ */
+static int
+mini_watch_move_store (MiniWatch *watch, MiniFile *target)
+{
+    MiniFile *mini_file = watch->mini_file;
+    Section **sections, **moved, *sec;
+    unsigned int num_sections, i;
+    int ret = 0;
+
+    num_sections = mini_file->num_sections;
+    sections = (Section **) mini_malloc (NULL, (num_sections + 1) * 
+                                         sizeof (Section *));
+    moved = (Section **) mini_malloc (NULL, (num_sections + 1) * 
+                                      sizeof (Section *));
+    if ((sections == NULL) || (moved == NULL)) {
+        mini_free (NULL, sections);
+        mini_free (NULL, moved);
+        return -1;
+    }
+
+    i = 0;
+    for (sec = mini_file->section; sec != NULL; sec = sec->next)
+        sections[i++] = sec;
+
+    for (i = 0; (ret == 0) && (i < num_sections); i++) {
+        moved[i] = sections[i];
+        if (mini_arena_contains (watch->store->arena, sections[i])) {
+            moved[i] = mini_watch_copy_section (target, sections[i]);
+            if (moved[i] == NULL)
+                ret = -1;
+        }
+    }
+
+    if ((ret == 0) && (mini_watch_relink (mini_file, moved, num_sections) < 0))
+        ret = -1;
+
+    /* The copies may have been linked after the sections of the target */
+    if (ret < 0)
+        mini_watch_relink (mini_file, sections, num_sections);
+
+    mini_free (NULL, sections);
+    mini_free (NULL, moved);
+
+    return ret;
+}
+
+/**
+ *  Compacts the store of a watch once it doubles: the sections still 
+ *  linked into the watched MiniFile are copied into a new store, and the 
+ *  old one is freed with the copies replaced since then.
+ *
+ *  @param watch A MiniWatch structure.
+ */
+static void
+mini_watch_compact (MiniWatch *watch)
+{
+    MiniFile *store;
+
+    if (watch->store->arena->bytes <= watch->store_limit)
+        return;
+
+    store = mini_file_new_with_allocator (watch->mini_file->file_name,
+                                          &watch->mini_file->arena->allocator);
+    if ((store == NULL) || (mini_watch_move_store (watch, store) < 0)) {
+        mini_file_free (store);
+        watch->store_limit *= 2;
+        return;
+    }
+
+    mini_file_free (watch->store);
+    watch->store = store;
+
+    watch->store_limit = 2 * store->arena->bytes;
+    if (watch->store_limit < MINI_WATCH_STORE_MIN_SIZE)
+        watch->store_limit = MINI_WATCH_STORE_MIN_SIZE;
+}
+
+/**
+ *  Moves the keys of a kept section to the lines of the same keys in the 
+ *  new version of the file.
+ *
+ *  @param kept A kept section of the watched MiniFile.
+ *  @param section The same section in the new version of the file.
+ */
+static void
+mini_watch_move_keys (Section *kept, const Section *section)
+{
+    SectionData *data;
+    const SectionData *moved;
+
+    for (data = kept->data, moved = section->data; 
+         (data != NULL) && (moved != NULL); 
+         data = data->next, moved = moved->next)
+        data->lineno = moved->lineno;
+}
+
+/**
+ *  Keeps the sections hidden by a later section with the same name whose 
+ *  contents didn't change, matching them with the hidden sections of the 
+ *  watched MiniFile.
+ *
+ *  @param mini_file The watched MiniFile.
+ *  @param new_file The new version of the file.
+ *  @param sections Sections of the new version, in file order.
+ *  @param kept Kept section of the watched MiniFile for every new one.
+ *  @param num_sections Number of sections.
+ *  @return The function returns a negative number, if the sections can't 
+ *          be matched.
+ */
+static int
+mini_watch_keep_hidden (MiniFile *mini_file, MiniFile *new_file, 
+                        Section **sections, Section **kept, 
+                        unsigned int num_sections)
+{
+    Section **hidden, *sec;
+    unsigned int num_hidden, i, j;
+
+    hidden = (Section **) mini_malloc (NULL, (mini_file->num_sections + 1) * 
+                                       sizeof (Section *));
+    if (hidden == NULL)
+        return -1;
+
+    num_hidden = 0;
+    for (sec = mini_file->section; sec != NULL; sec = sec->next)
+        if (mini_file_find_section (mini_file, sec->name, 
+                                    sec->name_len) != sec)
+            hidden[num_hidden++] = sec;
+
+    for (i = 0; (num_hidden > 0) && (i < num_sections); i++) {
+        sec = sections[i];
+        if (mini_file_find_section (new_file, sec->name, sec->name_len) == sec)
+            continue;
+
+        for (j = 0; j < num_hidden; j++) {
+            if ((hidden[j] == NULL) || 
+                (hidden[j]->name_len != sec->name_len) || 
+                (memcmp (hidden[j]->name, sec->name, sec->name_len) != 0) || 
+                (mini_watch_get_content_hash (hidden[j]) != 
+                 sec->content_hash))
+                continue;
+
+            kept[i] = hidden[j];
+            hidden[j] = NULL;
+            break;
+        }
+    }
+
+    mini_free (NULL, hidden);
+
+    return 0;
+}
+
+/**
+ *  Checks whether the watched MiniFile already has the sections of the new 
+ *  version of the file, in the same order.
+ *
+ *  @param mini_file The watched MiniFile.
+ *  @param kept Kept section of the watched MiniFile for every new one, or 
+ *         NULL if it must be copied.
+ *  @param num_sections Number of sections.
+ *  @return The function returns non-zero if nothing must be rebuilt.
+ */
+static int
+mini_watch_is_unchanged (const MiniFile *mini_file, Section **kept, 
+                         unsigned int num_sections)
+{
+    const Section *sec;
+    unsigned int i;
+
+    if (mini_file->num_sections != num_sections)
+        return 0;
+
+    i = 0;
+    for (sec = mini_file->section; sec != NULL; sec = sec->next)
+        if (kept[i++] != sec)
+            return 0;
+
+    return 1;
+}
+
+/**
+ *  Rebuilds the watched MiniFile from the new version of the file, keeping 
+ *  the sections whose contents didn't change (with their cached 
+ *  conversions) and copying the other ones into the store of the watch. 
+ *  The index of the sections is updated in place.
+ *
+ *  @param watch A MiniWatch structure.
+ *  @param sections Sections of the new version, in file order.
+ *  @param kept Kept section of the watched MiniFile for every new one, or 
+ *         NULL if it must be copied. The copies are saved into it.
+ *  @param num_sections Number of sections.
+ *  @return The function returns a negative number, if the MiniFile 
+ *          can't be rebuilt.
+ */
+static int
+mini_watch_rebuild (MiniWatch *watch, Section **sections, Section **kept,
+                    unsigned int num_sections)
+{
+    unsigned int i;
+
+    /* 
+     * Everything is copied before relinking: adding a section to the store 
+     * rewrites the link of the last one added, which may be linked into the 
+     * watched MiniFile.
+     */
+    for (i = 0; i < num_sections; i++) {
+        if (kept[i] == NULL) {
+            kept[i] = mini_watch_copy_section (watch->store, sections[i]);
+            if (kept[i] == NULL)
+                return -1;
+        } else {
+            /* Same keys, but they may have moved to other lines */
+            mini_watch_move_keys (kept[i], sections[i]);
+        }
+    }
+
+    return mini_watch_relink (watch->mini_file, kept, num_sections);
+}
+
+/**
+ *  Watches the file of a MiniFile with inotify. When the file is written 
+ *  or replaced, mini_watch_dispatch() updates the MiniFile and passes the 
+ *  changes to the given callback.
+ *
+ *  The directory of the file is watched, so editors replacing the file 
+ *  are followed. The watched MiniFile must only be updated by the watch, 
+ *  and freed after it.
+ *
+ *  The sections changed by the updates are copied into a store of the 
+ *  watch. When the store doubles, the copies still in use are moved to a 
+ *  new store and the old one is freed, so the memory of a long running 
+ *  watch stays within about twice its changed sections, plus the parse of 
+ *  the file. Strings got from a changed section are valid until a later 
+ *  update.
+ *
+ *  @param mini_file A MiniFile structure generated from an INI file.
+ *  @param callback Function called after every update with changes.
+ *  @param user_data Pointer passed to the callback.
+ *  @return The return value is the new MiniWatch structure.
+ *          The function returns NULL, if the file can't be watched.
+ */
+MiniWatch *
+mini_file_watch (MiniFile *mini_file, MiniWatchCallback callback, 
+                 void *user_data)
+{
+    MiniWatch *watch;
+    char *dir_name, *slash;
+
+    /* MiniFile and callback can't be NULL */
+    assert (mini_file != NULL);
+    assert (callback != NULL);
+
+    /* Frozen MiniFiles can't be modified */
+    if (mini_file->frozen != NULL)
+        return NULL;
+
+    /* The changes are found comparing the keys of every section */
+    mini_lazy_load_all (mini_file);
+
+    watch = (MiniWatch *) mini_malloc (NULL, sizeof (MiniWatch));
+    if (watch == NULL)
+        return NULL;
+
+    watch->mini_file = mini_file;
+    watch->callback = callback;
+    watch->user_data = user_data;
+    watch->fd = -1;
+    watch->wd = -1;
+    watch->changes = NULL;
+    watch->num_changes = 0;
+    watch->changes_size = 0;
+    watch->base_name = NULL;
+    watch->store_limit = MINI_WATCH_STORE_MIN_SIZE;
+
+    /* Copies of the changed sections, with the allocator of the MiniFile */
+    watch->store = mini_file_new_with_allocator (mini_file->file_name, 
+                                                 &mini_file->arena->allocator);
+    if (watch->store == NULL) {
+        mini_free (NULL, watch);
+        return NULL;
+    }
+
+    dir_name = mini_strdup (NULL, mini_file->file_name);
+    if (dir_name == NULL) {
+        mini_watch_free (watch);
+        return NULL;
+    }
+
+    /* Split the path in directory and base name */
+    slash = strrchr (dir_name, '/');
+    if (slash == NULL) {
+        watch->base_name = mini_strdup (NULL, dir_name);
+        strcpy (dir_name, ".");
+    } else {
+        watch->base_name = mini_strdup (NULL, slash + 1);
+        slash[(slash == dir_name) ? 1 : 0] = '\0';
+    }
+
+    if (watch->base_name == NULL) {
+        mini_free (NULL, dir_name);
+        mini_watch_free (watch);
+        return NULL;
+    }
+
+#ifdef HAVE_SYS_INOTIFY_H
+    watch->fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+    if (watch->fd >= 0)
+        watch->wd = inotify_add_watch (watch->fd, dir_name, 
+                                       IN_CLOSE_WRITE | IN_MOVED_TO);
+#endif
+
+    mini_free (NULL, dir_name);
+
+    if (watch->wd < 0) {
+        mini_watch_free (watch);
+        return NULL;
+    }
+
+    return watch;
+}
+
+/**
+ *  Stops watching a file and frees the MiniWatch structure. The watched 
+ *  MiniFile isn't freed: the sections copied by the updates are moved 
+ *  into it.
+ *
+ *  @param watch A MiniWatch structure.
+ */
+void
+mini_watch_free (MiniWatch *watch)
+{
+    /* Do nothing with NULL pointers */
+    if (watch == NULL)
+        return;
+
+    if (watch->fd >= 0)
+        close (watch->fd);
+
+    /* If the copies can't be moved, the store must outlive the MiniFile */
+    if ((watch->store->num_sections == 0) || 
+        (mini_watch_move_store (watch, watch->mini_file) == 0))
+        mini_file_free (watch->store);
+
+    mini_free (NULL, watch->base_name);
+    mini_free (NULL, watch->changes);
+    mini_free (NULL, watch);
+}
+
+/**
+ *  Gets the file descriptor of a watch, to be polled for input. When it's 
+ *  readable, mini_watch_dispatch() must be called.
+ *
+ *  @param watch A MiniWatch structure.
+ *  @return The return value is the file descriptor.
+ */
+int
+mini_watch_get_fd (const MiniWatch *watch)
+{
+    /* Watch can't be NULL */
+    assert (watch != NULL);
+
+    return watch->fd;
+}
+
+/**
+ *  Reads the pending events of a watch, updating the watched MiniFile if 
+ *  its file changed. It never blocks.
+ *
+ *  @param watch A MiniWatch structure.
+ *  @return The return value is the number of changes of the update, or 
+ *          zero if the file didn't change.
+ *          The function returns a negative number, if the events can't 
+ *          be read or the file can't be updated.
+ */
+int
+mini_watch_dispatch (MiniWatch *watch)
+{
+#ifdef HAVE_SYS_INOTIFY_H
+    char buffer[4096] 
+        __attribute__ ((aligned (__alignof__ (struct inotify_event))));
+    const struct inotify_event *event;
+    ssize_t len, offset;
+    int changed = 0;
+
+    /* Watch can't be NULL */
+    assert (watch != NULL);
+
+    for (;;) {
+        len = read (watch->fd, buffer, sizeof (buffer));
+        if (len < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN)
+                return -1;
+            break;
+        }
+
+        for (offset = 0; offset < len; 
+             offset += sizeof (struct inotify_event) + event->len) {
+            event = (const struct inotify_event *) &buffer[offset];
+
+            /* Lost events, the file may have changed */
+            if (event->mask & IN_Q_OVERFLOW)
+                changed = 1;
+            else if ((event->len > 0) && 
+                     (strcmp (event->name, watch->base_name) == 0))
+                changed = 1;
+        }
+    }
+
+    if (changed)
+        return mini_watch_update (watch);
+#endif
+
+    return 0;
+}
+
+/**
+ *  Updates a watched MiniFile from its file. The new version is parsed 
+ *  and the content hash of every section is compared with the one of the 
+ *  section with the same name: unchanged sections are kept as they are, 
+ *  with their key indexes, and only the other ones are rebuilt. The 
+ *  changes found by lookups (added, removed or modified sections and 
+ *  keys) are passed to the callback, if there is any.
+ *
+ *  An update without changes only moves the keys to their new lines. 
+ *  Changed sections are copied into the store of the watch, see 
+ *  mini_file_watch(): sections of the parse replaced by an update stay 
+ *  in the arena of the MiniFile until it's freed, and replaced copies 
+ *  until the store is compacted. A file with a wrong line doesn't update 
+ *  the MiniFile.
+ *
+ *  @param watch A MiniWatch structure.
+ *  @return The return value is the number of changes.
+ *          The function returns a negative number, if the file can't be 
+ *          parsed or the MiniFile can't be updated.
+ */
+int
+mini_watch_update (MiniWatch *watch)
+{
+    MiniFile *mini_file, *new_file;
+    Section **sections, **kept, *sec, *old;
+    unsigned int num_sections, i;
+    int ret = -1;
+
+    /* Watch can't be NULL */
+    assert (watch != NULL);
+
+    mini_file = watch->mini_file;
+    new_file = mini_parse_file_strict (mini_file->file_name);
+    if (new_file == NULL)
+        return -1;
+
+    num_sections = new_file->num_sections;
+    sections = (Section **) mini_malloc (NULL, (num_sections + 1) * 
+                                         sizeof (Section *));
+    kept = (Section **) mini_calloc (NULL, num_sections + 1, 
+                                     sizeof (Section *));
+    if ((sections == NULL) || (kept == NULL))
+        goto out;
+
+    i = 0;
+    for (sec = new_file->section; sec != NULL; sec = sec->next)
+        sections[i++] = sec;
+
+    watch->num_changes = 0;
+
+    /* Added and modified sections, only the ones found by a lookup */
+    for (i = 0; i < num_sections; i++) {
+        sec = sections[i];
+        mini_watch_get_content_hash (sec);
+
+        if (mini_file_find_section (new_file, sec->name, sec->name_len) != sec)
+            continue;
+
+        old = mini_file_find_section (mini_file, sec->name, sec->name_len);
+        if (old == NULL) {
+            if (mini_watch_add_change (watch, MINI_WATCH_ADDED, sec, NULL) < 0)
+                goto out;
+        } else if (mini_watch_get_content_hash (old) == sec->content_hash)
+            kept[i] = old;
+        else if (mini_watch_diff_keys (watch, old, sec) < 0)
+            goto out;
+    }
+
+    /* Removed sections */
+    for (i = 0; i < mini_file->index_size; i++) {
+        old = mini_file->index[i];
+        if ((old == NULL) || 
+            (mini_file_find_section (new_file, old->name, 
+                                     old->name_len) != NULL))
+            continue;
+
+        if (mini_watch_add_change (watch, MINI_WATCH_REMOVED, old, NULL) < 0)
+            goto out;
+    }
+
+    if (mini_watch_keep_hidden (mini_file, new_file, sections, kept, 
+                                num_sections) < 0)
+        goto out;
+
+    if ((watch->num_changes == 0) && 
+        mini_watch_is_unchanged (mini_file, kept, num_sections)) {
+        for (i = 0; i < num_sections; i++)
+            mini_watch_move_keys (kept[i], sections[i]);
+
+        ret = 0;
+        goto out;
+    }
+
+    if (mini_watch_rebuild (watch, sections, kept, num_sections) < 0)
+        goto out;
+
+    if (watch->num_changes > 0)
+        watch->callback (mini_file, watch->changes, watch->num_changes, 
+                         watch->user_data);
+
+    /* The removed sections of the changes may be in the store until now */
+    mini_watch_compact (watch);
+
+    ret = (int) watch->num_changes;
+
+out:
+    mini_free (NULL, sections);
+    mini_free (NULL, kept);
+    mini_file_free (new_file);
+
+    return ret;
+}
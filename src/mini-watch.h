@@ -0,0 +1,109 @@
+/*
+ * mini-watch.h
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MINI_WATCH_H__
+#define __MINI_WATCH_H__
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif
+
+#include "mini-file.h"
+#include "mini-parser.h"
+
+/* Bytes of copied sections before the store of a watch is compacted */
+#define MINI_WATCH_STORE_MIN_SIZE (256 * 1024)
+
+/* Types of change */
+#define MINI_WATCH_ADDED 0
+#define MINI_WATCH_REMOVED 1
+#define MINI_WATCH_MODIFIED 2
+
+/* 
+ * Change of a watched MiniFile: a whole section is added or removed 
+ * (key is NULL), or a key of a section kept by the new file is added, 
+ * removed or modified.
+ */
+typedef struct _MiniWatchChange MiniWatchChange;
+struct _MiniWatchChange {
+    int type;
+    const char *section;
+    size_t section_len;
+    const char *key;
+    size_t key_len;
+};
+
+/* 
+ * Called after a watched MiniFile is updated. The changes are valid only 
+ * during the call.
+ */
+typedef void (*MiniWatchCallback) (MiniFile *mini_file, 
+                                   const MiniWatchChange *changes,
+                                   unsigned int num_changes, void *user_data);
+
+typedef struct _MiniWatch MiniWatch;
+struct _MiniWatch {
+    MiniFile *mini_file;
+    MiniWatchCallback callback;
+    void *user_data;
+    /* inotify descriptor, watching the directory of the file */
+    int fd;
+    int wd;
+    char *base_name;
+    /* Change list of the last update */
+    MiniWatchChange *changes;
+    unsigned int num_changes;
+    unsigned int changes_size;
+    /* Copies of the changed sections, compacted past store_limit bytes */
+    MiniFile *store;
+    size_t store_limit;
+};
+
+
+MiniWatch *mini_file_watch (MiniFile *mini_file, MiniWatchCallback callback,
+                            void *user_data);
+
+void mini_watch_free (MiniWatch *watch);
+
+int mini_watch_get_fd (const MiniWatch *watch);
+
+int mini_watch_dispatch (MiniWatch *watch);
+
+int mini_watch_update (MiniWatch *watch);
+
+#endif /* __MINI_WATCH_H__ */
@@ -0,0 +1,481 @@
+/*
+ * mini-write.c
+ * This file is part of mini, a library to parse INI files.
+ *
+ * Copyright (c) 2010, Francisco Javier Cuadrado <fcocuadrado@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the Francisco Javier Cuadrado nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mini-lazy.h"
+#include "mini-write.h"
+
+/* Output being gathered: copies in the buffer and long strings in place */
+typedef struct _MiniWriter MiniWriter;
+struct _MiniWriter {
+    int fd;
+    char *buffer;
+    size_t used;
+    struct iovec iov[MINI_WRITE_MAX_IOV];
+    int num_iov;
+};
+
+/* Makes the temporary paths of mini_write_open_temp() unique */
+static atomic_uint mini_write_temp_counter;
+
+
+/**
+ *  Writes the gathered output with writev(), going on after partial 
+ *  writes and interruptions.
+ *
+ *  @param writer A MiniWriter structure.
+ *  @return The function returns a negative number, if the output can't 
+ *          be written.
+ */
+static int
+mini_write_flush (MiniWriter *writer)
+{
+    struct iovec *iov = writer->iov;
+    int num_iov = writer->num_iov;
+    ssize_t written;
+
+    while (num_iov > 0) {
+        written = writev (writer->fd, iov, num_iov);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+
+        /* Skip the written vectors, the last one may be partly written */
+        while ((num_iov > 0) && ((size_t) written >= iov->iov_len)) {
+            written -= iov->iov_len;
+            iov++;
+            num_iov--;
+        }
+
+        if (num_iov > 0) {
+            iov->iov_base = (char *) iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+
+    writer->used = 0;
+    writer->num_iov = 0;
+
+    return 0;
+}
+
+/**
+ *  Appends a string to the output. Short strings are copied into the 
+ *  buffer, long ones get a vector of their own.
+ *
+ *  @param writer A MiniWriter structure.
+ *  @param string A string, it must live until the output is flushed.
+ *  @param len Length of the string.
+ *  @return The function returns a negative number, if the output can't 
+ *          be written.
+ */
+static int
+mini_write_append (MiniWriter *writer, const char *string, size_t len)
+{
+    struct iovec *last;
+
+    if (len >= MINI_WRITE_DIRECT_SIZE) {
+        if ((writer->num_iov == MINI_WRITE_MAX_IOV) && 
+            (mini_write_flush (writer) < 0))
+            return -1;
+
+        writer->iov[writer->num_iov].iov_base = (void *) string;
+        writer->iov[writer->num_iov].iov_len = len;
+        writer->num_iov++;
+
+        return 0;
+    }
+
+    if ((writer->used + len > MINI_WRITE_BUFFER_SIZE) && 
+        (mini_write_flush (writer) < 0))
+        return -1;
+
+    /* Grow the last vector if it ends at the end of the buffer */
+    last = (writer->num_iov > 0) ? &writer->iov[writer->num_iov - 1] : NULL;
+    if ((last == NULL) || 
+        ((char *) last->iov_base + last->iov_len != writer->buffer + 
+                                                    writer->used)) {
+        if ((writer->num_iov == MINI_WRITE_MAX_IOV) && 
+            (mini_write_flush (writer) < 0))
+            return -1;
+
+        last = &writer->iov[writer->num_iov++];
+        last->iov_base = writer->buffer + writer->used;
+        last->iov_len = 0;
+    }
+
+    memcpy (writer->buffer + writer->used, string, len);
+    writer->used += len;
+    last->iov_len += len;
+
+    return 0;
+}
+
+/**
+ *  Checks that a string is parsed back unchanged: it isn't empty, it has 
+ *  no character of the given classes and, if the parser strips it, no 
+ *  whitespaces around it.
+ *
+ *  @param string A string.
+ *  @param len Length of the string.
+ *  @param classes Forbidden classes of mini_scan_class.
+ *  @param stripped Non-zero if the parser strips the string.
+ *  @return The function returns a negative number, if the string can't 
+ *          be written.
+ */
+static int
+mini_write_check (const char *string, size_t len, unsigned char classes, 
+                  int stripped)
+{
+    size_t i;
+
+    if (len == 0)
+        return -1;
+
+    if (stripped && (MINI_SCAN_IS_SPACE (string[0]) || 
+                     MINI_SCAN_IS_SPACE (string[len - 1])))
+        return -1;
+
+    for (i = 0; i < len; i++)
+        if (mini_scan_class[(unsigned char) string[i]] & classes)
+            return -1;
+
+    return 0;
+}
+
+/**
+ *  Appends a section header to the output, after a blank line unless 
+ *  it's the first section.
+ *
+ *  @param writer A MiniWriter structure.
+ *  @param name A section name.
+ *  @param name_len Length of the section name.
+ *  @param first Non-zero for the first section.
+ *  @return The function returns a negative number, if the name can't be 
+ *          written (errno is EINVAL) or the output can't be written.
+ */
+static int
+mini_write_section (MiniWriter *writer, const char *name, size_t name_len, 
+                    int first)
+{
+    /* Everything but ']' is kept between the brackets */
+    if (mini_write_check (name, name_len, MINI_SCAN_NEWLINE | 
+                          MINI_SCAN_COMMENT | MINI_SCAN_CLOSE, 0) < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if ((mini_write_append (writer, first ? "[" : "\n[", first ? 1 : 2) < 0) ||
+        (mini_write_append (writer, name, name_len) < 0) || 
+        (mini_write_append (writer, "]\n", 2) < 0))
+        return -1;
+
+    return 0;
+}
+
+/**
+ *  Appends a key-value pair to the output.
+ *
+ *  @param writer A MiniWriter structure.
+ *  @param key A key name.
+ *  @param key_len Length of the key name.
+ *  @param value The value of the key.
+ *  @param value_len Length of the value.
+ *  @return The function returns a negative number, if the pair can't be 
+ *          written (errno is EINVAL) or the output can't be written.
+ */
+static int
+mini_write_key (MiniWriter *writer, const char *key, size_t key_len, 
+                const char *value, size_t value_len)
+{
+    /* A key starting with '[' would be a section */
+    if ((mini_write_check (key, key_len, MINI_SCAN_NEWLINE | 
+                           MINI_SCAN_COMMENT | MINI_SCAN_EQUAL, 1) < 0) || 
+        (key[0] == '[') || 
+        (mini_write_check (value, value_len, MINI_SCAN_NEWLINE | 
+                           MINI_SCAN_COMMENT, 1) < 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if ((mini_write_append (writer, key, key_len) < 0) || 
+        (mini_write_append (writer, " = ", 3) < 0) || 
+        (mini_write_append (writer, value, value_len) < 0) || 
+        (mini_write_append (writer, "\n", 1) < 0))
+        return -1;
+
+    return 0;
+}
+
+/**
+ *  Appends the sections and keys of a MiniFile to the output, in file 
+ *  order.
+ *
+ *  @param writer A MiniWriter structure.
+ *  @param mini_file A MiniFile structure, not frozen.
+ *  @return The function returns a negative number, if the MiniFile can't 
+ *          be written.
+ */
+static int
+mini_write_sections (MiniWriter *writer, const MiniFile *mini_file)
+{
+    const Section *sec;
+    const SectionData *data;
+
+    for (sec = mini_file->section; sec != NULL; sec = sec->next) {
+        if (mini_write_section (writer, sec->name, sec->name_len, 
+                                sec == mini_file->section) < 0)
+            return -1;
+
+        for (data = sec->data; data != NULL; data = data->next)
+            if (mini_write_key (writer, data->key, data->key_len, 
+                                data->value, data->value_len) < 0)
+                return -1;
+    }
+
+    return 0;
+}
+
+/**
+ *  Appends the sections and keys of a frozen image to the output, in 
+ *  file order.
+ *
+ *  @param writer A MiniWriter structure.
+ *  @param image A frozen image.
+ *  @return The function returns a negative number, if the image can't 
+ *          be written.
+ */
+static int
+mini_write_frozen (MiniWriter *writer, const MiniFrozenHeader *image)
+{
+    const char *base = (const char *) image;
+    const MiniFrozenSection *sections;
+    const MiniFrozenKey *keys;
+    uint32_t i, j;
+
+    sections = (const MiniFrozenSection *) &base[image->sections_offset];
+    keys = (const MiniFrozenKey *) &base[image->keys_offset];
+
+    for (i = 0; i < image->num_sections; i++) {
+        if (mini_write_section (writer, &base[sections[i].name], 
+                                sections[i].name_len, i == 0) < 0)
+            return -1;
+
+        for (j = sections[i].first_key; 
+             j < sections[i].first_key + sections[i].num_keys; j++)
+            if (mini_write_key (writer, &base[keys[j].key], keys[j].key_len,
+                                &base[keys[j].value], 
+                                keys[j].value_len) < 0)
+                return -1;
+    }
+
+    return 0;
+}
+
+
+/**
+ *  Creates a temporary file next to a file being replaced, for the new 
+ *  contents to be renamed over it. The temporary file gets the mode of 
+ *  the replaced file or, if there isn't one, the mode of a new file 
+ *  (0666 without the bits of the umask).
+ *
+ *  @param path Path of the file being replaced.
+ *  @param tmp_path Buffer receiving the temporary path, with room for 
+ *         the path plus MINI_WRITE_TEMP_SUFFIX_SIZE bytes.
+ *  @return The return value is a descriptor of the temporary file, open 
+ *          for writing.
+ *          The function returns a negative number, if it can't be created.
+ */
+int
+mini_write_open_temp (const char *path, char *tmp_path)
+{
+    struct stat st;
+    mode_t mode = 0666;
+    int existing, fd = -1, i;
+
+    /* Paths can't be NULL */
+    assert (path != NULL);
+    assert (tmp_path != NULL);
+
+    existing = (stat (path, &st) == 0);
+    if (existing)
+        mode = st.st_mode & 07777;
+
+    for (i = 0; (i < MINI_WRITE_TEMP_TRIES) && (fd < 0); i++) {
+        sprintf (tmp_path, "%s.%ld.%u", path, (long) getpid (), 
+                 atomic_fetch_add (&mini_write_temp_counter, 1));
+
+        fd = open (tmp_path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, mode);
+        if ((fd < 0) && (errno != EEXIST))
+            return -1;
+    }
+
+    if (fd < 0)
+        return -1;
+
+    /* The umask only applies to new files: keep the mode of the old one */
+    if (existing && (fchmod (fd, mode) < 0)) {
+        close (fd);
+        unlink (tmp_path);
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ *  Syncs the directory of a file renamed over another one, so that the 
+ *  rename survives a crash.
+ *
+ *  @param tmp_path Former temporary path of the renamed file, it's 
+ *         overwritten with the path of its directory.
+ */
+void
+mini_write_sync_dir (char *tmp_path)
+{
+    char *slash;
+    int dir_fd;
+
+    /* Path can't be NULL */
+    assert (tmp_path != NULL);
+
+    slash = strrchr (tmp_path, '/');
+    if (slash == NULL)
+        strcpy (tmp_path, ".");
+    else
+        slash[(slash == tmp_path) ? 1 : 0] = '\0';
+
+    dir_fd = open (tmp_path, O_RDONLY | O_DIRECTORY);
+    if (dir_fd >= 0) {
+        fsync (dir_fd);
+        close (dir_fd);
+    }
+}
+
+/**
+ *  Writes a MiniFile as an INI file into a file descriptor: its sections 
+ *  and keys in file order, duplicated ones included, as "[section]" and 
+ *  "key = value" lines with a blank line between sections. The output is 
+ *  gathered in large buffers and written with writev().
+ *
+ *  Parsing the output gives the same sections and keys, so writing it 
+ *  again gives the same bytes. Names and values that can't be parsed 
+ *  back (empty, with an end of line, a comment character or whitespaces 
+ *  the parser would strip) aren't written.
+ *
+ *  @param mini_file A MiniFile structure.
+ *  @param fd A file descriptor open for writing.
+ *  @return The function returns a negative number, if the MiniFile can't 
+ *          be written (errno is EINVAL if a name or a value can't be 
+ *          written). The output may be partly written then.
+ */
+int
+mini_file_write_fd (MiniFile *mini_file, int fd)
+{
+    MiniWriter writer;
+    int ret;
+
+    /* MiniFile can't be NULL */
+    assert (mini_file != NULL);
+
+    writer.fd = fd;
+    writer.used = 0;
+    writer.num_iov = 0;
+    writer.buffer = (char *) mini_malloc (NULL, MINI_WRITE_BUFFER_SIZE);
+    if (writer.buffer == NULL)
+        return -1;
+
+    /* Sections not parsed yet have no keys to write */
+    mini_lazy_load_all (mini_file);
+
+    if (mini_file->frozen != NULL)
+        ret = mini_write_frozen (&writer, mini_file->frozen);
+    else
+        ret = mini_write_sections (&writer, mini_file);
+
+    if (ret == 0)
+        ret = mini_write_flush (&writer);
+
+    mini_free (NULL, writer.buffer);
+
+    return ret;
+}
+
+/**
+ *  Writes a MiniFile as an INI file, as mini_file_write_fd() does. The 
+ *  file is replaced atomically: the output goes to a temporary file in 
+ *  the same directory, which is synced to disk and renamed over the 
+ *  given path. The new file keeps the mode of the replaced one, see 
+ *  mini_write_open_temp().
+ *
+ *  @param mini_file A MiniFile structure.
+ *  @param path Path of the INI file.
+ *  @return The function returns a negative number, if the MiniFile can't 
+ *          be written. The file at path is left untouched then.
+ */
+int
+mini_file_write (MiniFile *mini_file, const char *path)
+{
+    char *tmp_path;
+    int fd, ret = -1;
+
+    /* MiniFile and path can't be NULL */
+    assert (mini_file != NULL);
+    assert (path != NULL);
+
+    tmp_path = (char *) mini_malloc (NULL, strlen (path) + 
+                                     MINI_WRITE_TEMP_SUFFIX_SIZE);
+    if (tmp_path == NULL)
+        return -1;
+
+    fd = mini_write_open_temp (path, tmp_path);
+    if (fd < 0)
+        goto out;
+
+    if ((mini_file_write_fd (mini_file, fd) < 0) || (fsync (fd) < 0)) {
+        close (fd);
+        unlink (tmp_path);
+        goto out;
+    }
+
+    if ((close (fd) < 0) || (rename (tmp_path, path) < 0)) {
+        unlink (tmp_path);
+        goto out;
+    }
+
+    ret = 0;
+    mini_write_sync_dir (tmp_path);
+
+out:
+    mini_free (NULL, tmp_path);
+
+    return ret;
+}